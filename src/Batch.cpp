@@ -0,0 +1,132 @@
+/* Copyright (c) His Majesty the King in Right of Canada as represented by the Minister of Natural Resources, 2024. */
+
+/* SPDX-License-Identifier: AGPL-3.0-or-later */
+
+#include "stdafx.h"
+#include "Batch.h"
+#include "Log.h"
+#include "TimeUtil.h"
+#include "Trim.h"
+namespace tbd::sim
+{
+/**
+ * \brief Number of columns in a manifest row
+ */
+static constexpr size_t MANIFEST_COLUMNS = 7;
+/**
+ * \brief Parse a single manifest row
+ * \param filename File that row is from
+ * \param line_number Line number of row
+ * \param line Row to parse
+ * \return Ignition for row
+ */
+static Ignition parse_ignition(const string& filename,
+                               const size_t line_number,
+                               const string& line)
+{
+  vector<string> values{};
+  istringstream iss(line);
+  string str;
+  while (getline(iss, str, ','))
+  {
+    values.push_back(util::trim_copy(str));
+  }
+  // trailing empty columns don't show up when splitting
+  values.resize(max(values.size(), MANIFEST_COLUMNS));
+  logging::check_fatal(MANIFEST_COLUMNS != values.size(),
+                       "Expected %ld columns but got %ld on line %ld of %s",
+                       MANIFEST_COLUMNS,
+                       values.size(),
+                       line_number,
+                       filename.c_str());
+  const auto& date = values[2];
+  const auto& time = values[3];
+  logging::check_fatal(10 != date.size() || '-' != date[4] || '-' != date[7],
+                       "Expected date in yyyy-mm-dd format but got '%s' on line %ld of %s",
+                       date.c_str(),
+                       line_number,
+                       filename.c_str());
+  logging::check_fatal(5 != time.size() || ':' != time[2],
+                       "Expected time in HH:MM format but got '%s' on line %ld of %s",
+                       time.c_str(),
+                       line_number,
+                       filename.c_str());
+  logging::check_fatal(values[4].empty(),
+                       "No output directory on line %ld of %s",
+                       line_number,
+                       filename.c_str());
+  try
+  {
+    tm start_time{};
+    start_time.tm_year = stoi(date.substr(0, 4)) - 1900;
+    start_time.tm_mon = stoi(date.substr(5, 2)) - 1;
+    start_time.tm_mday = stoi(date.substr(8, 2));
+    start_time.tm_hour = stoi(time.substr(0, 2));
+    start_time.tm_min = stoi(time.substr(3, 2));
+    logging::check_fatal(start_time.tm_hour < 0 || start_time.tm_hour > 23,
+                         "Simulation start time has an invalid hour (%d) on line %ld of %s",
+                         start_time.tm_hour,
+                         line_number,
+                         filename.c_str());
+    logging::check_fatal(start_time.tm_min < 0 || start_time.tm_min > 59,
+                         "Simulation start time has an invalid minute (%d) on line %ld of %s",
+                         start_time.tm_min,
+                         line_number,
+                         filename.c_str());
+    util::fix_tm(&start_time);
+    auto output_dir = values[4];
+    replace(output_dir.begin(), output_dir.end(), '\\', '/');
+    if ('/' != output_dir[output_dir.length() - 1])
+    {
+      output_dir += '/';
+    }
+    return {topo::StartPoint(stod(values[0]), stod(values[1])),
+            start_time,
+            output_dir,
+            values[5],
+            values[6].empty() ? 0 : static_cast<size_t>(stoi(values[6]))};
+  }
+  catch (const std::invalid_argument&)
+  {
+    return logging::fatal<Ignition>("Invalid value on line %ld of %s",
+                                    line_number,
+                                    filename.c_str());
+  }
+  catch (const std::out_of_range&)
+  {
+    return logging::fatal<Ignition>("Invalid value on line %ld of %s",
+                                    line_number,
+                                    filename.c_str());
+  }
+}
+vector<Ignition> read_ignitions(const string& filename)
+{
+  ifstream in;
+  in.open(filename.c_str());
+  logging::check_fatal(!in.is_open(), "Unable to read manifest %s", filename.c_str());
+  vector<Ignition> result{};
+  string str;
+  size_t line_number = 0;
+  // skip header
+  if (getline(in, str))
+  {
+    ++line_number;
+  }
+  while (getline(in, str))
+  {
+    ++line_number;
+    // allow for files with CRLF line endings
+    if (!str.empty() && '\r' == str.back())
+    {
+      str.pop_back();
+    }
+    if (util::trim_copy(str).empty())
+    {
+      continue;
+    }
+    result.push_back(parse_ignition(filename, line_number, str));
+  }
+  logging::check_fatal(result.empty(), "No ignitions in manifest %s", filename.c_str());
+  return result;
+}
+}
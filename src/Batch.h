@@ -0,0 +1,47 @@
+/* Copyright (c) His Majesty the King in Right of Canada as represented by the Minister of Natural Resources, 2024. */
+
+/* SPDX-License-Identifier: AGPL-3.0-or-later */
+
+#pragma once
+#include <string>
+#include <vector>
+#include "StartPoint.h"
+namespace tbd::sim
+{
+/**
+ * \brief A single fire to simulate as part of a batch
+ */
+struct Ignition
+{
+  /**
+   * \brief Point the fire starts at
+   */
+  topo::StartPoint start_point;
+  /**
+   * \brief Start time for simulation
+   */
+  tm start_time;
+  /**
+   * \brief Folder to save outputs to
+   */
+  string output_dir;
+  /**
+   * \brief Perimeter to initialize fire from, if there is one
+   */
+  string perimeter;
+  /**
+   * \brief Size to start fire at if no Perimeter
+   */
+  size_t size;
+};
+/**
+ * \brief Read ignitions from a manifest file
+ *
+ * The manifest is a .csv with a header row and then one ignition per row, with columns
+ * lat,lon,date,time,output_dir,perim,size where date is yyyy-mm-dd, time is HH:MM, and
+ * perim and size can be left empty.
+ * \param filename File to read
+ * \return Ignitions in the order they are listed in the manifest
+ */
+[[nodiscard]] vector<Ignition> read_ignitions(const string& filename);
+}
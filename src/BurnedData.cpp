@@ -0,0 +1,72 @@
+/* Copyright (c) His Majesty the King in Right of Canada as represented by the Minister of Natural Resources, 2024. */
+
+/* SPDX-License-Identifier: AGPL-3.0-or-later */
+
+#include "stdafx.h"
+#include "BurnedData.h"
+#include "Log.h"
+namespace tbd::sim
+{
+/**
+ * \brief Tile with no bits set that all BurnedData without a base start from
+ */
+static const BurnedData::Tile EMPTY_TILE{};
+BurnedData::BurnedData() noexcept
+  : base_(nullptr)
+{
+  tiles_.fill(&EMPTY_TILE);
+}
+BurnedData::BurnedData(shared_ptr<const BurnedData> base) noexcept
+  : base_(std::move(base)),
+    tiles_(base_->tiles_)
+{
+}
+void BurnedData::own(const size_t t) noexcept
+{
+  try
+  {
+    unique_ptr<Tile> storage = nullptr;
+    if (spare_.empty())
+    {
+      storage = make_unique<Tile>();
+    }
+    else
+    {
+      storage = std::move(spare_.back());
+      spare_.pop_back();
+    }
+    *storage = *tiles_[t];
+    tiles_[t] = storage.get();
+    is_owned_.set(t);
+    owned_tiles_.push_back(t);
+    owned_.push_back(std::move(storage));
+  }
+  catch (const std::exception& ex)
+  {
+    logging::fatal(ex);
+    std::terminate();
+  }
+}
+void BurnedData::reset() noexcept
+{
+  try
+  {
+    for (const auto t : owned_tiles_)
+    {
+      tiles_[t] = (nullptr == base_) ? &EMPTY_TILE : base_->tiles_[t];
+      is_owned_.reset(t);
+    }
+    owned_tiles_.clear();
+    for (auto& storage : owned_)
+    {
+      spare_.push_back(std::move(storage));
+    }
+    owned_.clear();
+  }
+  catch (const std::exception& ex)
+  {
+    logging::fatal(ex);
+    std::terminate();
+  }
+}
+}
@@ -0,0 +1,135 @@
+/* Copyright (c) His Majesty the King in Right of Canada as represented by the Minister of Natural Resources, 2024. */
+
+/* SPDX-License-Identifier: AGPL-3.0-or-later */
+
+#pragma once
+#include <array>
+#include <bit>
+#include <bitset>
+#include <memory>
+#include <vector>
+#include "stdafx.h"
+namespace tbd::sim
+{
+/**
+ * \brief Bit for every cell in the grid, stored as tiles that are shared with a base
+ * BurnedData until they are written to.
+ *
+ * Each tile is 64 x 64 cells, so each row of a tile is one 64 bit word. Looking up a
+ * cell is the same work whether its tile has been written to or not, and resetting only
+ * has to touch the tiles that were written to since the last reset.
+ */
+class BurnedData
+{
+public:
+  /**
+   * \brief Number of bits used for a coordinate in a tile
+   */
+  static constexpr uint32_t TILE_BITS = 6;
+  /**
+   * \brief Number of rows and columns in a tile
+   */
+  static constexpr Idx TILE_CELLS = static_cast<Idx>(1) << TILE_BITS;
+  static_assert(0 == MAX_ROWS % TILE_CELLS && 0 == MAX_COLUMNS % TILE_CELLS);
+  /**
+   * \brief Number of tiles across the grid
+   */
+  static constexpr size_t TILE_COLUMNS = MAX_COLUMNS / TILE_CELLS;
+  /**
+   * \brief Number of tiles in the grid
+   */
+  static constexpr size_t NUM_TILES = (MAX_ROWS / TILE_CELLS) * TILE_COLUMNS;
+  /**
+   * \brief One row of bits per row of cells in the tile
+   */
+  using Tile = array<uint64_t, TILE_CELLS>;
+  /**
+   * \brief Construct with no bits set
+   */
+  BurnedData() noexcept;
+  /**
+   * \brief Construct with the same bits as base, which must not change while this exists
+   * \param base BurnedData to use values from until they are written to
+   */
+  explicit BurnedData(shared_ptr<const BurnedData> base) noexcept;
+  ~BurnedData() = default;
+  BurnedData(const BurnedData& rhs) = delete;
+  BurnedData(BurnedData&& rhs) = delete;
+  BurnedData& operator=(const BurnedData& rhs) = delete;
+  BurnedData& operator=(BurnedData&& rhs) = delete;
+  /**
+   * \brief Whether bit is set for the cell with the given hash
+   * \param hash Hash of Location to check
+   * \return Whether bit is set for the cell with the given hash
+   */
+  [[nodiscard]] bool operator[](const HashSize hash) const noexcept
+  {
+    return 0 != (((*tiles_[tile(hash)])[hash >> XY_BITS & TILE_MASK] >> (hash & TILE_MASK)) & 1);
+  }
+  /**
+   * \brief Set bit for the cell with the given hash
+   * \param hash Hash of Location to set
+   */
+  void set(const HashSize hash) noexcept
+  {
+    const auto t = tile(hash);
+    if (!is_owned_[t])
+    {
+      own(t);
+    }
+    // tiles that are owned were allocated by this and aren't really const
+    (*const_cast<Tile*>(tiles_[t]))[hash >> XY_BITS & TILE_MASK] |= static_cast<uint64_t>(1) << (hash & TILE_MASK);
+  }
+  /**
+   * \brief Change back to the values from the base, or no bits set if there isn't one
+   */
+  void reset() noexcept;
+private:
+  /**
+   * \brief Number of bits in a hash that are used for the column
+   */
+  static constexpr uint32_t XY_BITS = std::bit_width<uint32_t>(MAX_COLUMNS - 1);
+  /**
+   * \brief Mask for coordinate within a tile
+   */
+  static constexpr HashSize TILE_MASK = static_cast<HashSize>(TILE_CELLS - 1);
+  /**
+   * \brief Index of tile that contains cell with the given hash
+   * \param hash Hash of Location to find tile for
+   * \return Index of tile that contains cell with the given hash
+   */
+  [[nodiscard]] static constexpr size_t tile(const HashSize hash) noexcept
+  {
+    return (hash >> (XY_BITS + TILE_BITS)) * TILE_COLUMNS + ((hash & (MAX_COLUMNS - 1)) >> TILE_BITS);
+  }
+  /**
+   * \brief Copy tile from base into storage owned by this so it can be written to
+   * \param t Index of tile
+   */
+  void own(size_t t) noexcept;
+  /**
+   * \brief BurnedData to use tiles from when they haven't been written to
+   */
+  shared_ptr<const BurnedData> base_;
+  /**
+   * \brief Tile for each part of the grid, either from base_ or owned by this
+   */
+  array<const Tile*, NUM_TILES> tiles_;
+  /**
+   * \brief Whether each tile is owned by this
+   */
+  std::bitset<NUM_TILES> is_owned_{};
+  /**
+   * \brief Indices of tiles that are owned by this
+   */
+  vector<size_t> owned_tiles_{};
+  /**
+   * \brief Storage for tiles that are owned by this, in the same order as owned_tiles_
+   */
+  vector<unique_ptr<Tile>> owned_{};
+  /**
+   * \brief Storage that was used before last reset and can be used again
+   */
+  vector<unique_ptr<Tile>> spare_{};
+};
+}
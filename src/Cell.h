@@ -73,6 +73,18 @@ public:
     : Position<Topo>(hash)
   {
   }
+  /**
+   * \brief Construct from location and SpreadKey
+   * \param hash Hash of row and column
+   * \param key SpreadKey defining Slope, Aspect, and Fuel
+   */
+  constexpr Cell(const HashSize hash,
+                 const SpreadKey key) noexcept
+    : Position<Topo>(
+        static_cast<Topo>(hash & HashMask)
+        | static_cast<Topo>(key) << FuelShift)
+  {
+  }
   /**
    * \brief Construct based on given attributes
    * \param hash Hash of row and column
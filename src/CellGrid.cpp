@@ -0,0 +1,112 @@
+/* Copyright (c) His Majesty the King in Right of Canada as represented by the Minister of Natural Resources, 2024. */
+
+/* SPDX-License-Identifier: AGPL-3.0-or-later */
+
+#include "stdafx.h"
+#include "CellGrid.h"
+#include "Log.h"
+namespace tbd::topo
+{
+CellGrid::CellGrid(const MathSize cell_size,
+                   const Idx rows,
+                   const Idx columns,
+                   const Topo nodata_input,
+                   const Cell nodata_value,
+                   const MathSize xllcorner,
+                   const MathSize yllcorner,
+                   const MathSize xurcorner,
+                   const MathSize yurcorner,
+                   string&& proj4,
+                   vector<Cell>&& cells)
+  : CellGrid(cell_size,
+             rows,
+             columns,
+             nodata_input,
+             nodata_value,
+             xllcorner,
+             yllcorner,
+             xurcorner,
+             yurcorner,
+             std::forward<string>(proj4),
+             cells,
+             vector<SpreadKey>{})
+{
+  // don't keep the full Cells around once they've been indexed
+  vector<Cell>().swap(cells);
+}
+CellGrid::CellGrid(const MathSize cell_size,
+                   const Idx rows,
+                   const Idx columns,
+                   const Topo nodata_input,
+                   const Cell nodata_value,
+                   const MathSize xllcorner,
+                   const MathSize yllcorner,
+                   const MathSize xurcorner,
+                   const MathSize yurcorner,
+                   string&& proj4,
+                   const vector<Cell>& cells,
+                   vector<SpreadKey>&& keys)
+  : GridData<Cell, Topo, const vector<SpreadKeyIndex>>(cell_size,
+                                                       rows,
+                                                       columns,
+                                                       nodata_input,
+                                                       nodata_value,
+                                                       xllcorner,
+                                                       yllcorner,
+                                                       xurcorner,
+                                                       yurcorner,
+                                                       std::forward<string>(proj4),
+                                                       index_cells(cells, &keys)),
+    keys_(std::move(keys))
+{
+  if (this->data.empty() && !cells.empty())
+  {
+    logging::note("Window has more than %ld combinations of slope, aspect, and fuel so storing them directly",
+                  MAX_KEYS);
+    keys_.clear();
+    wide_.reserve(cells.size());
+    for (const auto& cell : cells)
+    {
+      wide_.push_back(cell.key());
+    }
+  }
+  logging::verbose("Indexed %ld cells using %ld keys", cells.size(), keys_.size());
+}
+vector<SpreadKeyIndex> CellGrid::index_cells(const vector<Cell>& cells,
+                                             vector<SpreadKey>* keys)
+{
+  vector<SpreadKeyIndex> result{};
+  result.reserve(cells.size());
+  unordered_map<SpreadKey, SpreadKeyIndex> index{};
+  // neighbouring cells usually have the same key so avoid looking it up again
+  SpreadKey last_key = 0;
+  SpreadKeyIndex last_index = 0;
+  for (const auto& cell : cells)
+  {
+    const auto key = cell.key();
+    if (!result.empty() && key == last_key)
+    {
+      result.push_back(last_index);
+      continue;
+    }
+    last_key = key;
+    const auto seek = index.find(key);
+    if (index.end() != seek)
+    {
+      last_index = seek->second;
+      result.push_back(last_index);
+      continue;
+    }
+    if (MAX_KEYS == keys->size())
+    {
+      return {};
+    }
+    const auto i = static_cast<SpreadKeyIndex>(keys->size());
+    keys->push_back(key);
+    index.emplace(key, i);
+    last_index = i;
+    result.push_back(i);
+  }
+  return result;
+}
+}
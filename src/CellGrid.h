@@ -0,0 +1,150 @@
+/* Copyright (c) His Majesty the King in Right of Canada as represented by the Minister of Natural Resources, 2024. */
+
+/* SPDX-License-Identifier: AGPL-3.0-or-later */
+
+#pragma once
+#include <limits>
+#include <string>
+#include <vector>
+#include "Cell.h"
+#include "Grid.h"
+namespace tbd::topo
+{
+/**
+ * \brief Index into the table of SpreadKeys used by a CellGrid
+ */
+using SpreadKeyIndex = uint16_t;
+/**
+ * \brief Grid of Cells that stores an index into a table of SpreadKeys for each cell
+ * instead of the whole Cell.
+ *
+ * Location is implied by the position in the grid, so only the slope, aspect, and fuel
+ * need to be stored, and a window rarely has more than a few thousand combinations of
+ * those. If there are too many combinations to index with a SpreadKeyIndex then the
+ * SpreadKey for each cell is stored directly instead.
+ */
+class CellGrid final
+  : public data::GridData<Cell, Topo, const vector<SpreadKeyIndex>>
+{
+public:
+  /**
+   * \brief Largest number of SpreadKeys that can be indexed with a SpreadKeyIndex
+   */
+  static constexpr size_t MAX_KEYS = static_cast<size_t>(std::numeric_limits<SpreadKeyIndex>::max()) + 1;
+  /**
+   * \brief Cell for grid at given Location
+   * \param location Location to get Cell for
+   * \return Cell at grid Location
+   */
+  [[nodiscard]] constexpr Cell at(const Location& location) const noexcept override
+  {
+#ifdef DEBUG_GRIDS
+    logging::check_fatal(location.row() >= this->rows() || location.column() >= this->columns(), "Out of bounds (%d, %d)", location.row(), location.column());
+#endif
+    const auto h = location.hash();
+    return Cell{h, wide_.empty() ? keys_[this->data[h]] : wide_[h]};
+  }
+  /**
+   * \brief Cell for grid at given Position
+   * \param position Position to get Cell for
+   * \return Cell at grid Position
+   */
+  template <class P>
+  [[nodiscard]] Cell at(const Position<P>& position) const noexcept
+  {
+    return at(Location{position.hash()});
+  }
+  /**
+   * \brief Throw an error because CellGrid can't change values.
+   */
+  // ! @cond Doxygen_Suppress
+  void set(const Location&, const Cell) override
+  // ! @endcond
+  {
+    throw runtime_error("Cannot change CellGrid");
+  }
+  ~CellGrid() = default;
+  CellGrid(const CellGrid& rhs) noexcept = delete;
+  CellGrid(CellGrid&& rhs) noexcept = delete;
+  CellGrid& operator=(const CellGrid& rhs) noexcept = delete;
+  CellGrid& operator=(CellGrid&& rhs) noexcept = delete;
+  /**
+   * \brief Constructor
+   * \param cell_size Cell width and height (m)
+   * \param rows Number of rows
+   * \param columns Number of columns
+   * \param nodata_input Value that represents no data for Topo
+   * \param nodata_value Value that represents no data for Cell
+   * \param xllcorner Lower left corner X coordinate (m)
+   * \param yllcorner Lower left corner Y coordinate (m)
+   * \param xurcorner Upper right corner X coordinate (m)
+   * \param yurcorner Upper right corner Y coordinate (m)
+   * \param proj4 Proj4 projection definition
+   * \param cells Cells indexed by Location hash
+   */
+  CellGrid(MathSize cell_size,
+           Idx rows,
+           Idx columns,
+           Topo nodata_input,
+           Cell nodata_value,
+           MathSize xllcorner,
+           MathSize yllcorner,
+           MathSize xurcorner,
+           MathSize yurcorner,
+           string&& proj4,
+           vector<Cell>&& cells);
+protected:
+  tuple<Idx, Idx, Idx, Idx> dataBounds() const override
+  {
+    return tuple<Idx, Idx, Idx, Idx>{
+      0,
+      0,
+      this->columns(),
+      this->rows()};
+  }
+private:
+  /**
+   * \brief Constructor
+   * \param cell_size Cell width and height (m)
+   * \param rows Number of rows
+   * \param columns Number of columns
+   * \param nodata_input Value that represents no data for Topo
+   * \param nodata_value Value that represents no data for Cell
+   * \param xllcorner Lower left corner X coordinate (m)
+   * \param yllcorner Lower left corner Y coordinate (m)
+   * \param xurcorner Upper right corner X coordinate (m)
+   * \param yurcorner Upper right corner Y coordinate (m)
+   * \param proj4 Proj4 projection definition
+   * \param cells Cells indexed by Location hash
+   * \param keys Filled with distinct SpreadKeys in order they are first seen in cells
+   */
+  CellGrid(MathSize cell_size,
+           Idx rows,
+           Idx columns,
+           Topo nodata_input,
+           Cell nodata_value,
+           MathSize xllcorner,
+           MathSize yllcorner,
+           MathSize xurcorner,
+           MathSize yurcorner,
+           string&& proj4,
+           const vector<Cell>& cells,
+           vector<SpreadKey>&& keys);
+  /**
+   * \brief Index into keys_ for each Cell, or empty if there were too many keys
+   * \param cells Cells indexed by Location hash
+   * \param keys Filled with distinct SpreadKeys in order they are first seen in cells
+   * \return Index into keys for each Cell, or empty if there were too many keys
+   */
+  [[nodiscard]] static vector<SpreadKeyIndex> index_cells(const vector<Cell>& cells,
+                                                          vector<SpreadKey>* keys);
+  /**
+   * \brief Distinct SpreadKeys that data indexes into
+   */
+  vector<SpreadKey> keys_;
+  /**
+   * \brief SpreadKey for each Cell if there were too many to index, otherwise empty
+   */
+  vector<SpreadKey> wide_{};
+};
+}
@@ -30,6 +30,17 @@ static const SpreadData INVALID_SPREAD_DATA{
   INVALID_ROS,
   Direction::Invalid,
   Direction::Invalid};
+bool CellPointArrays::operator<(const CellPointArrays& rhs) const noexcept
+{
+  for (size_t i = 0; i < NUM_DIRECTIONS; ++i)
+  {
+    if (point(i) != rhs.point(i))
+    {
+      return point(i) < rhs.point(i);
+    }
+  }
+  return false;
+}
 set<XYPos> CellPoints::unique() const noexcept
 {
   // // if any point is invalid then they all have to be
@@ -39,12 +50,12 @@ set<XYPos> CellPoints::unique() const noexcept
   }
   else
   {
-    const auto& pts_all = std::views::transform(
-      pts_.points(),
-      [this](const auto& p) {
-        return XYPos(p.first + cell_x_y_.first, p.second + cell_x_y_.second);
-      });
-    return {pts_all.begin(), pts_all.end()};
+    set<XYPos> result{};
+    for (size_t i = 0; i < NUM_DIRECTIONS; ++i)
+    {
+      result.emplace(pts_.xs()[i] + cell_x_y_.first, pts_.ys()[i] + cell_x_y_.second);
+    }
+    return result;
   }
 }
 #ifdef DEBUG_CELLPOINTS
@@ -57,12 +68,13 @@ CellPoints::CellPoints(const Idx cell_x, const Idx cell_y) noexcept
   : spread_arrival_(INVALID_SPREAD_DATA),
     spread_internal_(INVALID_SPREAD_DATA),
     spread_exit_(INVALID_SPREAD_DATA),
-    pts_({}),
+    pts_(),
     cell_x_y_(cell_x, cell_y),
     src_(DIRECTION_NONE)
 {
   std::fill(pts_.distances().begin(), pts_.distances().end(), INVALID_DISTANCE);
-  std::fill(pts_.points().begin(), pts_.points().end(), INVALID_INNER_POSITION);
+  std::fill(pts_.xs().begin(), pts_.xs().end(), INVALID_INNER_POSITION.first);
+  std::fill(pts_.ys().begin(), pts_.ys().end(), INVALID_INNER_POSITION.second);
   std::fill(pts_.directions().begin(), pts_.directions().end(), INVALID_DIRECTION);
 
 #ifdef DEBUG_CELLPOINTS
@@ -123,6 +135,23 @@ constexpr std::array<DISTANCE_PAIR, NUM_DIRECTIONS> POINTS_OUTER{
   D_PTS(0.0, 1.0),
   // north-northwest is closest to point (0.5 - 0.207, 1.0)
   D_PTS(M_0_5, 1.0)};
+#undef D_PTS
+/**
+ * \brief Make array of one coordinate of POINTS_OUTER
+ * \param is_x Whether to use x or y coordinate
+ * \return Array of one coordinate of POINTS_OUTER
+ */
+static constexpr array_dists outer_coordinates(const bool is_x)
+{
+  array_dists result{};
+  for (size_t i = 0; i < NUM_DIRECTIONS; ++i)
+  {
+    result[i] = is_x ? POINTS_OUTER[i].first : POINTS_OUTER[i].second;
+  }
+  return result;
+}
+alignas(CELLPOINTS_ALIGNMENT) static constexpr array_dists POINTS_OUTER_X = outer_coordinates(true);
+alignas(CELLPOINTS_ALIGNMENT) static constexpr array_dists POINTS_OUTER_Y = outer_coordinates(false);
 
 // TODO: add angle
 CellPoints& CellPoints::insert(
@@ -208,35 +237,23 @@ CellPoints& CellPoints::insert(
     static_cast<InnerSize>(y - cell_x_y_.second));
   const auto x0 = static_cast<DistanceSize>(p0.first);
   const auto y0 = static_cast<DistanceSize>(p0.second);
-  // CHECK: FIX: is this initializing everything to false or just one element?
+  const auto direction = spread_current.direction().asDegrees();
+  auto& dists = pts_.distances();
+  auto& xs = pts_.xs();
+  auto& ys = pts_.ys();
+  auto& dirs = pts_.directions();
+  // use separate arrays and selects instead of branches so compiler can vectorize this
   std::array<bool, NUM_DIRECTIONS> closer{};
-  std::fill_n(closer.begin(), NUM_DIRECTIONS, false);
-  // static_assert(pts_.first.size() == NUM_DIRECTIONS);
   for (size_t i = 0; i < NUM_DIRECTIONS; ++i)
   {
-    const auto& p1 = POINTS_OUTER[i];
-    const auto& x1 = p1.first;
-    const auto& y1 = p1.second;
-    const auto d = ((x0 - x1) * (x0 - x1) + (y0 - y1) * (y0 - y1));
-    auto& p_d = pts_.distances()[i];
-    auto& p_p = pts_.points()[i];
-    auto& p_a = pts_.directions()[i];
-    closer[i] = (d < p_d);
-    p_p = closer[i] ? p0 : p_p;
-    p_d = closer[i] ? d : p_d;
-    p_a = closer[i] ? spread_current.direction().asDegrees() : p_a;
-    // // worse than two checks + assignment
-    // const auto& [p_new, d_new] =
-    //   (d < p_d)
-    //     ? std::make_tuple(p0, d)
-    //     : std::make_tuple(p_p, p_d);
-    // p_p = p_new;
-    // p_d = d_new;
-    // // worse than two checks + assignment
-    // std::tie(p_d, p_p) =
-    //   (d < p_d)
-    //     ? std::make_tuple(d, p0)
-    //     : std::make_tuple(p_d, p_p);
+    const auto dx = x0 - POINTS_OUTER_X[i];
+    const auto dy = y0 - POINTS_OUTER_Y[i];
+    const auto d = (dx * dx + dy * dy);
+    closer[i] = (d < dists[i]);
+    dists[i] = closer[i] ? d : dists[i];
+    xs[i] = closer[i] ? p0.first : xs[i];
+    ys[i] = closer[i] ? p0.second : ys[i];
+    dirs[i] = closer[i] ? direction : dirs[i];
   }
 #ifdef DEBUG_CELLPOINTS
   logging::note("now have %ld points", size());
@@ -286,7 +303,6 @@ CellPoints& CellPoints::insert(
   // FIX: do something with spread on exit
   return *this;
 }
-#undef D_PTS
 CellPoints::CellPoints(const XYPos& p) noexcept
   : CellPoints(p.first, p.second)
 {
@@ -316,17 +332,18 @@ CellPoints& CellPoints::merge(const CellPoints& rhs)
   // either both invalid or lower one is valid
   cell_x_y_ = min(cell_x_y_, rhs.cell_x_y_);
   auto& d0 = pts_.distances();
-  auto& d1 = rhs.pts_.distances();
-  auto& p0 = pts_.points();
-  auto& p1 = rhs.pts_.points();
+  auto& x0 = pts_.xs();
+  auto& y0 = pts_.ys();
+  const auto& d1 = rhs.pts_.distances();
+  const auto& x1 = rhs.pts_.xs();
+  const auto& y1 = rhs.pts_.ys();
   // we know distances in each direction so just pick closer
-  for (size_t i = 0; i < d0.size(); ++i)
+  for (size_t i = 0; i < NUM_DIRECTIONS; ++i)
   {
-    if (d1[i] < d0[i])
-    {
-      d0[i] = d1[i];
-      p0[i] = p1[i];
-    }
+    const auto closer = d1[i] < d0[i];
+    d0[i] = closer ? d1[i] : d0[i];
+    x0[i] = closer ? x1[i] : x0[i];
+    y0[i] = closer ? y1[i] : y0[i];
   }
   add_source(rhs.src_);
 #ifdef DEBUG_CELLPOINTS
@@ -342,7 +359,7 @@ bool CellPoints::operator<(const CellPoints& rhs) const noexcept
 {
   if (cell_x_y_ == rhs.cell_x_y_)
   {
-    return pts_.points() < rhs.pts_.points();
+    return pts_ < rhs.pts_;
   }
   return cell_x_y_ < rhs.cell_x_y_;
 }
@@ -350,7 +367,7 @@ bool CellPoints::operator==(const CellPoints& rhs) const noexcept
 {
   return (
     cell_x_y_ == rhs.cell_x_y_
-    && pts_.points() == rhs.pts_.points());
+    && pts_ == rhs.pts_);
 }
 bool CellPoints::empty() const
 {
@@ -361,9 +378,133 @@ bool CellPoints::empty() const
 {
   return Location{cell_x_y_.second, cell_x_y_.first};
 }
+/**
+ * \brief Initial number of slots in CellPointsMap index
+ */
+static constexpr size_t INITIAL_SLOTS = 64;
 CellPointsMap::CellPointsMap()
-  : map_({})
+  : items_(),
+    used_(),
+    free_(),
+    slots_(INITIAL_SLOTS, 0),
+    sorted_(),
+    size_(0)
+{
+}
+size_t CellPointsMap::home(const Location& location) const noexcept
 {
+  // multiply by golden ratio so neighbouring cells don't end up in neighbouring slots
+  const auto h = static_cast<uint64_t>(location.hash()) * 0x9E3779B97F4A7C15ULL;
+  return static_cast<size_t>(h >> 32) & (slots_.size() - 1);
+}
+void CellPointsMap::grow() noexcept
+{
+  std::fill(slots_.begin(), slots_.end(), 0);
+  slots_.resize(slots_.size() * 2, 0);
+  const auto mask = slots_.size() - 1;
+  for (uint32_t i = 0; i < items_.size(); ++i)
+  {
+    if (used_[i])
+    {
+      auto slot = home(items_[i].first);
+      while (0 != slots_[slot])
+      {
+        slot = (slot + 1) & mask;
+      }
+      slots_[slot] = i + 1;
+    }
+  }
+}
+pair<uint32_t, bool> CellPointsMap::emplace(const Location& location) noexcept
+{
+  // keep load factor under 1/2 so probe sequences stay short
+  if (2 * (size_ + 1) > slots_.size())
+  {
+    grow();
+  }
+  const auto mask = slots_.size() - 1;
+  auto slot = home(location);
+  while (0 != slots_[slot])
+  {
+    const auto i = slots_[slot] - 1;
+    if (items_[i].first == location)
+    {
+      return {i, false};
+    }
+    slot = (slot + 1) & mask;
+  }
+  uint32_t i;
+  if (free_.empty())
+  {
+    i = static_cast<uint32_t>(items_.size());
+    items_.emplace_back(location, CellPoints());
+    used_.push_back(true);
+  }
+  else
+  {
+    i = free_.back();
+    free_.pop_back();
+    items_[i].first = location;
+    used_[i] = true;
+  }
+  slots_[slot] = i + 1;
+  ++size_;
+  return {i, true};
+}
+void CellPointsMap::erase(const uint32_t i) noexcept
+{
+  const auto mask = slots_.size() - 1;
+  auto slot = home(items_[i].first);
+  while (slots_[slot] != i + 1)
+  {
+    slot = (slot + 1) & mask;
+  }
+  // shift following entries back so lookups don't need tombstones
+  auto next = (slot + 1) & mask;
+  while (0 != slots_[next])
+  {
+    const auto want = home(items_[slots_[next] - 1].first);
+    // move entry if its home isn't between the empty slot and where it is now
+    if (((next - want) & mask) >= ((next - slot) & mask))
+    {
+      slots_[slot] = slots_[next];
+      slot = next;
+    }
+    next = (next + 1) & mask;
+  }
+  slots_[slot] = 0;
+  used_[i] = false;
+  free_.push_back(i);
+  --size_;
+}
+void CellPointsMap::clear() noexcept
+{
+  std::fill(slots_.begin(), slots_.end(), 0);
+  free_.clear();
+  // reuse items in order so they get filled the same way every time
+  for (uint32_t i = static_cast<uint32_t>(items_.size()); i > 0; --i)
+  {
+    free_.push_back(i - 1);
+  }
+  std::fill(used_.begin(), used_.end(), false);
+  size_ = 0;
+}
+const vector<uint32_t>& CellPointsMap::sortedItems() noexcept
+{
+  sorted_.clear();
+  for (uint32_t i = 0; i < items_.size(); ++i)
+  {
+    if (used_[i])
+    {
+      sorted_.push_back(i);
+    }
+  }
+  std::sort(sorted_.begin(),
+            sorted_.end(),
+            [this](const uint32_t lhs, const uint32_t rhs) {
+              return items_[lhs].first.hash() < items_[rhs].first.hash();
+            });
+  return sorted_;
 }
 CellPoints& CellPointsMap::insert(
   const XYPos& src,
@@ -375,9 +516,13 @@ CellPoints& CellPointsMap::insert(
   const auto n0 = size();
 #endif
   const Location location{static_cast<Idx>(y), static_cast<Idx>(x)};
-  auto e = map_.try_emplace(location, src, spread_current, x, y);
-  CellPoints& cell_pts = e.first->second;
-  if (!e.second)
+  const auto e = emplace(location);
+  CellPoints& cell_pts = items_[e.first].second;
+  if (e.second)
+  {
+    cell_pts = CellPoints(src, spread_current, x, y);
+  }
+  else
   {
     // FIX: should use max of whatever ROS has entered during this time and not just first ros
     // tried to add new CellPoints but already there
@@ -399,56 +544,58 @@ CellPointsMap& CellPointsMap::merge(
   const BurnedData& unburnable,
   const CellPointsMap& rhs) noexcept
 {
-  // FIX: if we iterate through both they should be sorted
-  for (const auto& kv : rhs.map_)
+  return merge(unburnable, rhs, [](const Location&) {});
+}
+CellPointsMap& CellPointsMap::merge(
+  const BurnedData& unburnable,
+  const CellPointsMap& rhs,
+  const std::function<void(const Location&)>& on_unburnable)
+{
+  // order doesn't matter since each Location is only merged once
+  for (uint32_t j = 0; j < rhs.items_.size(); ++j)
   {
+    if (!rhs.used_[j])
+    {
+      continue;
+    }
+    const auto& kv = rhs.items_[j];
     const auto h = kv.first.hash();
     if (!unburnable[h])
     {
       const CellPoints& pts = kv.second;
       const Location location = pts.location();
-      auto e = map_.try_emplace(location, pts);
-      CellPoints& cell_pts = e.first->second;
-      if (!e.second)
+      const auto e = emplace(location);
+      CellPoints& cell_pts = items_[e.first].second;
+      if (e.second)
+      {
+        cell_pts = pts;
+      }
+      else
       {
         // couldn't insert
         cell_pts.merge(pts);
       }
     }
-  }
-  return *this;
-}
-void CellPointsMap::remove_if(std::function<bool(const pair<Location, CellPoints>&)> F) noexcept
-{
-  auto it = map_.begin();
-  while (map_.end() != it)
-  {
-    if (F(*it))
-    {
-      it = map_.erase(it);
-    }
     else
     {
-      ++it;
+      on_unburnable(kv.first);
     }
   }
+  return *this;
 }
 set<XYPos> CellPointsMap::unique() const noexcept
 {
   set<XYPos> r{};
-  for (auto& lp : map_)
+  for (uint32_t i = 0; i < items_.size(); ++i)
   {
-    for (auto& p : lp.second.unique())
+    if (used_[i])
     {
-      r.insert(p);
+      for (auto& p : items_[i].second.unique())
+      {
+        r.insert(p);
+      }
     }
   }
   return r;
 }
-#ifdef DEBUG_CELLPOINTS
-size_t CellPointsMap::size() const noexcept
-{
-  return unique().size();
-}
-#endif
 }
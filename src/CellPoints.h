@@ -83,43 +83,85 @@ static constexpr std::array<CellIndex, NUM_DIRECTIONS> DIRECTION_MASKS{
   MASK_NW};
 
 class CellPointsMap;
-// using dist_pt = pair<DistanceSize, InnerPos>;
-// using array_cellpts = std::array<dist_pt, NUM_DIRECTIONS>;
+/**
+ * \brief Alignment for arrays in CellPointArrays so all directions can be loaded into
+ * vector registers at once
+ */
+static constexpr size_t CELLPOINTS_ALIGNMENT = 32;
 using array_dists = std::array<DistanceSize, NUM_DIRECTIONS>;
-using array_pts = std::array<InnerPos, NUM_DIRECTIONS>;
-// using array_cellpts = pair<CellPoints::array_dists, CellPoints::array_pts>;
+using array_coords = std::array<InnerSize, NUM_DIRECTIONS>;
 using array_dirs = std::array<MathSize, NUM_DIRECTIONS>;
-using array_cellpts = std::tuple<array_dists, array_pts, array_dirs>;
-//   using array_cellpts = std::array<DistanceSize, NUM_DIRECTIONS>;
+/**
+ * \brief Closest point in each direction, with each attribute stored in its own array
+ * so that comparing a new point to all directions can be vectorized.
+ *
+ * Precision (and so how many directions fit in a vector register) is determined by
+ * DistanceSize and InnerSize.
+ */
 class CellPointArrays
-  : public array_cellpts
 {
 public:
-  using array_cellpts::array_cellpts;
   inline const array_dists& distances() const
   {
-    return std::get<0>(*this);
+    return distances_;
   }
-  inline const array_pts& points() const
+  inline const array_coords& xs() const
   {
-    return std::get<1>(*this);
+    return xs_;
+  }
+  inline const array_coords& ys() const
+  {
+    return ys_;
   }
   inline const array_dirs& directions() const
   {
-    return std::get<2>(*this);
+    return directions_;
   }
   inline array_dists& distances()
   {
-    return std::get<0>(*this);
+    return distances_;
   }
-  inline array_pts& points()
+  inline array_coords& xs()
   {
-    return std::get<1>(*this);
+    return xs_;
+  }
+  inline array_coords& ys()
+  {
+    return ys_;
   }
   inline array_dirs& directions()
   {
-    return std::get<2>(*this);
+    return directions_;
+  }
+  /**
+   * \brief Closest point in a direction
+   * \param i Index of direction
+   * \return Closest point in a direction
+   */
+  inline InnerPos point(const size_t i) const
+  {
+    return InnerPos(xs_[i], ys_[i]);
+  }
+  /**
+   * \brief Compare points in order of direction
+   * \param rhs CellPointArrays to compare to
+   * \return Whether points are before the points in rhs
+   */
+  bool operator<(const CellPointArrays& rhs) const noexcept;
+  /**
+   * \brief Whether all points are the same
+   * \param rhs CellPointArrays to compare to
+   * \return Whether all points are the same
+   */
+  bool operator==(const CellPointArrays& rhs) const noexcept
+  {
+    return xs_ == rhs.xs_ && ys_ == rhs.ys_;
   }
+private:
+  alignas(CELLPOINTS_ALIGNMENT) array_dists distances_;
+  alignas(CELLPOINTS_ALIGNMENT) array_coords xs_;
+  alignas(CELLPOINTS_ALIGNMENT) array_coords ys_;
+  alignas(CELLPOINTS_ALIGNMENT) array_dirs directions_;
 };
 /**
  * Points in a cell furthest in each direction
@@ -178,7 +220,6 @@ public:
   bool operator==(const CellPoints& rhs) const noexcept;
   [[nodiscard]] Location location() const noexcept;
   void clear();
-  //   const array_pts points() const;
   bool empty() const;
   SpreadData spread_arrival_;
   SpreadData spread_internal_;
@@ -201,18 +242,18 @@ private:
 
 using spreading_points = CellPoints::spreading_points;
 class Scenario;
-// map that merges items when try_emplace doesn't insert
+/**
+ * \brief Map of Locations to the CellPoints within them that merges items when
+ * inserting into a Location that is already present.
+ *
+ * Stored as a flat array of CellPoints with an open addressing index keyed on
+ * Location::hash(), and slots from removed items are reused, so it doesn't allocate
+ * once it has grown to the size of the fire and been cleared.
+ */
 class CellPointsMap
 {
 public:
   CellPointsMap();
-  // CellPoints& insert(
-  //   const DurationSize& arrival_time,
-  //   const IntensitySize intensity,
-  //   const ROSSize& ros,
-  //   const Direction& raz,
-  //   const XYSize x,
-  //   const XYSize y) noexcept;
   CellPoints& insert(
     const XYPos& src,
     const SpreadData& spread_current,
@@ -221,14 +262,116 @@ public:
   CellPointsMap& merge(
     const BurnedData& unburnable,
     const CellPointsMap& rhs) noexcept;
+  /**
+   * \brief Merge points from rhs into this, skipping Locations that are unburnable
+   * \param unburnable Locations that can't burn
+   * \param rhs Points to merge
+   * \param on_unburnable Called with each Location that is skipped
+   * \return This, after merging
+   */
+  CellPointsMap& merge(
+    const BurnedData& unburnable,
+    const CellPointsMap& rhs,
+    const std::function<void(const Location&)>& on_unburnable);
   set<XYPos> unique() const noexcept;
-#ifdef DEBUG_CELLPOINTS
-  size_t size() const noexcept;
-#endif
-  // apply function to each CellPoints within and remove matches
-  void remove_if(std::function<bool(const pair<Location, CellPoints>&)> F) noexcept;
-  // FIX: public for debugging right now
-  // private:
-  map<Location, CellPoints> map_;
+  /**
+   * \brief Number of Locations that have CellPoints
+   * \return Number of Locations that have CellPoints
+   */
+  size_t size() const noexcept
+  {
+    return size_;
+  }
+  /**
+   * \brief Whether there are no Locations with CellPoints
+   * \return Whether there are no Locations with CellPoints
+   */
+  bool empty() const noexcept
+  {
+    return 0 == size_;
+  }
+  /**
+   * \brief Remove all CellPoints but keep storage for reuse
+   */
+  void clear() noexcept;
+  /**
+   * \brief Apply function to each Location and its CellPoints in Location order
+   * \param fct Function to call with pair of Location and CellPoints
+   */
+  template <class F>
+  void for_each(F fct) noexcept
+  {
+    for (const auto i : sortedItems())
+    {
+      fct(items_[i]);
+    }
+  }
+  /**
+   * \brief Apply function to each Location and its CellPoints in Location order and
+   * remove the ones it returns true for
+   * \param fct Function to call with pair of Location and CellPoints
+   */
+  template <class F>
+  void remove_if(F fct) noexcept
+  {
+    for (const auto i : sortedItems())
+    {
+      if (fct(items_[i]))
+      {
+        erase(i);
+      }
+    }
+  }
+private:
+  /**
+   * \brief Find CellPoints for Location, or add Location if not present
+   * \param location Location to find
+   * \return Index of item for Location and whether it was added
+   */
+  pair<uint32_t, bool> emplace(const Location& location) noexcept;
+  /**
+   * \brief Remove item from map
+   * \param i Index of item to remove
+   */
+  void erase(uint32_t i) noexcept;
+  /**
+   * \brief Slot in index that Location belongs in if not displaced by collisions
+   * \param location Location to find slot for
+   * \return Slot in index that Location belongs in if not displaced by collisions
+   */
+  size_t home(const Location& location) const noexcept;
+  /**
+   * \brief Make index larger and reinsert all items
+   */
+  void grow() noexcept;
+  /**
+   * \brief Indices of items that are in use, sorted by Location
+   * \return Indices of items that are in use, sorted by Location
+   */
+  const vector<uint32_t>& sortedItems() noexcept;
+  /**
+   * \brief Locations and CellPoints, including unused items that can be reused
+   */
+  vector<pair<Location, CellPoints>> items_;
+  /**
+   * \brief Whether each item is in use
+   */
+  vector<bool> used_;
+  /**
+   * \brief Indices of items that are not in use
+   */
+  vector<uint32_t> free_;
+  /**
+   * \brief Index of item + 1 for each slot, or 0 if slot is empty
+   */
+  vector<uint32_t> slots_;
+  /**
+   * \brief Indices of items in use, in Location order
+   */
+  vector<uint32_t> sorted_;
+  /**
+   * \brief Number of items in use
+   */
+  size_t size_;
 };
 }
@@ -152,7 +152,7 @@ public:
                    xllcorner,
                    yllcorner,
                    proj4,
-                   std::move(vector<T>(static_cast<size_t>(MAX_ROWS) * MAX_COLUMNS,
+                   std::move(vector<T>(static_cast<size_t>(rows) * MAX_COLUMNS,
                                        initialization_value)))
   {
   }
@@ -200,44 +200,22 @@ public:
     logging::debug("NODATA value is parsed as %d", nodata_input);
     auto actual_rows = grid_info.calculateRows();
     auto actual_columns = grid_info.calculateColumns();
-    const auto coordinates = grid_info.findFullCoordinates(point, true);
-    logging::note("Coordinates before reading are (%d, %d => %f, %f)",
-                  std::get<0>(*coordinates),
-                  std::get<1>(*coordinates),
-                  std::get<0>(*coordinates) + std::get<2>(*coordinates) / 1000.0,
-                  std::get<1>(*coordinates) + std::get<3>(*coordinates) / 1000.0);
-    auto min_column = max(static_cast<FullIdx>(0),
-                          static_cast<FullIdx>(std::get<1>(*coordinates) - static_cast<FullIdx>(MAX_COLUMNS) / static_cast<FullIdx>(2)));
-    if (min_column + MAX_COLUMNS >= actual_columns)
-    {
-      min_column = max(static_cast<FullIdx>(0), actual_columns - MAX_COLUMNS);
-    }
+    const auto window = find_window(grid_info, point);
+    const auto min_column = window.min_column;
+    const auto max_column = window.max_column;
+    const auto min_row = window.min_row;
+    const auto max_row = window.max_row;
     // make sure we're at the start of a tile
     const auto tile_column = tile_width * static_cast<FullIdx>(min_column / tile_width);
-    const auto max_column = static_cast<FullIdx>(min(min_column + MAX_COLUMNS - 1, actual_columns));
-#ifdef DEBUG_GRIDS
-    logging::check_fatal(min_column < 0, "Column can't be less than 0");
-    logging::check_fatal(max_column - min_column > MAX_COLUMNS, "Can't have more than %d columns", MAX_COLUMNS);
-    logging::check_fatal(max_column > actual_columns, "Can't have more than actual %d columns", actual_columns);
-#endif
-    auto min_row = max(static_cast<FullIdx>(0),
-                       static_cast<FullIdx>(std::get<0>(*coordinates) - static_cast<FullIdx>(MAX_ROWS) / static_cast<FullIdx>(2)));
-    if (min_row + MAX_COLUMNS >= actual_rows)
-    {
-      min_row = max(static_cast<FullIdx>(0), actual_rows - MAX_ROWS);
-    }
     const auto tile_row = tile_width * static_cast<FullIdx>(min_row / tile_width);
-    const auto max_row = static_cast<FullIdx>(min(min_row + MAX_ROWS - 1, actual_rows));
-#ifdef DEBUG_GRIDS
-    logging::check_fatal(min_row < 0, "Row can't be less than 0 but is %d", min_row);
-    logging::check_fatal(max_row - min_row > MAX_ROWS, "Can't have more than %d rows but have %d", MAX_ROWS, max_row - min_row);
-    logging::check_fatal(max_row > actual_rows, "Can't have more than actual %d rows", actual_rows);
-#endif
     T nodata_value = convert(nodata_input, nodata_input);
     logging::check_fatal(
       convert(nodata_input, nodata_input) != nodata_value,
       "Expected nodata value to be returned from convert()");
-    vector<T> values(static_cast<size_t>(MAX_ROWS) * MAX_COLUMNS, nodata_value);
+    // only need rows that are in the window, but hash still uses MAX_COLUMNS per row
+    const auto num_rows = window.rows();
+    const auto num_columns = window.columns();
+    vector<T> values(static_cast<size_t>(num_rows) * MAX_COLUMNS, nodata_value);
     logging::verbose("%s: malloc start", filename.c_str());
     int bps = std::numeric_limits<V>::digits + (1 * std::numeric_limits<V>::is_signed);
     uint16_t bps_file;
@@ -281,7 +259,7 @@ public:
           // read in so that (0, 0) has a hash of 0
           const auto y_row = static_cast<HashSize>((h - min_row) + y);
           const auto actual_row = (max_row - min_row) - y_row;
-          if (actual_row >= 0 && actual_row < MAX_ROWS)
+          if (actual_row >= 0 && actual_row < num_rows)
           {
             for (
               auto x = 0;
@@ -331,21 +309,8 @@ public:
     logging::verbose("%s: read end", filename.c_str());
     _TIFFfree(buf);
     logging::verbose("%s: free end", filename.c_str());
-    const auto new_xll = grid_info.xllcorner() + (static_cast<MathSize>(min_column) * grid_info.cellSize());
-    const auto new_yll = grid_info.yllcorner()
-                       + (static_cast<MathSize>(actual_rows) - static_cast<MathSize>(max_row))
-                           * grid_info.cellSize();
-#ifdef DEBUG_GRIDS
-    logging::check_fatal(new_yll < grid_info.yllcorner(),
-                         "New yllcorner is outside original grid");
-#endif
-    logging::verbose("Translated lower left is (%f, %f) from (%f, %f)",
-                     new_xll,
-                     new_yll,
-                     grid_info.xllcorner(),
-                     grid_info.yllcorner());
-    const auto num_rows = max_row - min_row + 1;
-    const auto num_columns = max_column - min_column + 1;
+    const auto new_xll = window.xllcorner;
+    const auto new_yll = window.yllcorner;
     auto result = new ConstantGrid<T, V>(grid_info.cellSize(),
                                          num_rows,
                                          num_columns,
@@ -457,7 +422,7 @@ private:
   {
 #ifdef DEBUG_GRIDS
     logging::check_fatal(
-      this->data.size() != static_cast<size_t>(MAX_ROWS) * MAX_COLUMNS,
+      this->data.size() != static_cast<size_t>(this->rows()) * MAX_COLUMNS,
       "Invalid grid size");
 #endif
   }
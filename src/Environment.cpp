@@ -5,9 +5,11 @@
 
 #include "stdafx.h"
 #include "Environment.h"
+#include "EnvironmentCache.h"
 #include "EnvironmentInfo.h"
 #include "FuelLookup.h"
 #include "ProbabilityMap.h"
+#include "RasterCatalogue.h"
 #include "Scenario.h"
 #include "Settings.h"
 
@@ -26,6 +28,19 @@ Environment Environment::load(const string dir_out,
                               const string& in_elevation)
 {
   logging::note("Fuel raster is %s", in_fuel.c_str());
+  // need the full rasters if we're saving the simulation area
+  if (!sim::Settings::saveSimulationArea())
+  {
+    const auto cache = EnvironmentCache::open(in_fuel, in_elevation);
+    if (nullptr != cache)
+    {
+      logging::note("Using preprocessed environment %s",
+                    EnvironmentCache::fileName(in_fuel).c_str());
+      const auto elevation = cache->elevation(point);
+      logging::note("Start elevation is %d", elevation);
+      return Environment(dir_out, cache->readCells(point), elevation);
+    }
+  }
   if (sim::Settings::runAsync())
   {
     logging::debug("Loading grids async");
@@ -46,14 +61,15 @@ Environment Environment::load(const string dir_out,
                        ElevationGrid::readTiff(string(in_elevation), point)),
                      point);
 }
-sim::ProbabilityMap* Environment::makeProbabilityMap(const DurationSize time,
+sim::ProbabilityMap* Environment::makeProbabilityMap(const string& dir_out,
+                                                     const DurationSize time,
                                                      const DurationSize start_time,
                                                      const int min_value,
                                                      const int low_max,
                                                      const int med_max,
                                                      const int max_value) const
 {
-  return new sim::ProbabilityMap(dir_out_,
+  return new sim::ProbabilityMap(dir_out,
                                  time,
                                  start_time,
                                  min_value,
@@ -70,32 +86,20 @@ Environment Environment::loadEnvironment(const string dir_out,
 {
   logging::note("Using ignition point (%f, %f)", point.latitude(), point.longitude());
   logging::info("Running using inputs directory '%s'", path.c_str());
-  auto rasters = util::find_rasters(path, year);
+  // only look at headers for rasters that could contain the point
+  RasterCatalogue catalogue(path, year);
   auto best_score = numeric_limits<MathSize>::min();
   unique_ptr<const EnvironmentInfo> env_info = nullptr;
   unique_ptr<data::GridBase> for_info = nullptr;
-  string best_fuel = "";
-  string best_elevation = "";
-  auto found_best = false;
+  const RasterEntry* best = nullptr;
   if (!perimeter.empty())
   {
     for_info = make_unique<data::GridBase>(data::read_header(perimeter));
     logging::info("Perimeter projection is %s", for_info->proj4().c_str());
   }
-  for (const auto& raster : rasters)
+  for (const auto raster : catalogue.find(point))
   {
-    auto fuel = raster;
-    logging::verbose("Replacing directory separators in path for: %s\n", fuel.c_str());
-    // make sure we're using a consistent directory separator
-    std::replace(fuel.begin(), fuel.end(), '\\', '/');
-    // HACK: assume there's only one instance of 'fuel' in the file name we want to change
-    const auto find_what = string("fuel");
-    const auto find_len = find_what.length();
-    const auto find_start = fuel.find(find_what, fuel.find_last_of('/'));
-    const auto elevation = string(fuel).replace(find_start, find_len, "dem");
-    unique_ptr<const EnvironmentInfo> cur_info = EnvironmentInfo::loadInfo(
-      fuel,
-      elevation);
+    const auto cur_info = &raster->grid;
     // want the raster that's going to give us the most room to spread, so pick the one with the most
     //   cells between the ignition and the edge on the side where it's closest to the edge
     // FIX: need to pick raster that aligns with perimeter if we have one
@@ -136,17 +140,16 @@ Environment Environment::loadEnvironment(const string dir_out,
       if (cur_score > best_score)
       {
         best_score = cur_score;
-        best_fuel = fuel;
-        best_elevation = elevation;
-        found_best = true;
+        best = raster;
       }
     }
   }
-  if (nullptr == env_info && found_best)
+  if (nullptr == env_info && nullptr != best)
   {
     env_info = EnvironmentInfo::loadInfo(
-      best_fuel,
-      best_elevation);
+      best->fuel,
+      best->elevation,
+      best->grid);
   }
   logging::check_fatal(
     nullptr == env_info,
@@ -6,10 +6,12 @@
 #pragma once
 #include "stdafx.h"
 #include "Cell.h"
+#include "CellGrid.h"
 #include "ConstantGrid.h"
 #include "Event.h"
 #include "FuelType.h"
 #include "GridMap.h"
+#include "TiledGrid.h"
 #include "IntensityMap.h"
 #include "Point.h"
 #include "Settings.h"
@@ -18,7 +20,6 @@ namespace tbd::topo
 {
 using FuelGrid = data::ConstantGrid<const fuel::FuelType*, FuelSize>;
 using ElevationGrid = data::ConstantGrid<ElevationSize>;
-using CellGrid = data::ConstantGrid<Cell, Topo>;
 /*!
  * \page environment Fire environment
  *
@@ -202,6 +203,7 @@ public:
   }
   /**
    * \brief Make a ProbabilityMap that covers this Environment
+   * \param dir_out Folder to save outputs to
    * \param time Time in simulation this ProbabilityMap represents
    * \param start_time Start time of simulation
    * \param min_value Lower bound of 'low' intensity range
@@ -210,7 +212,8 @@ public:
    * \param max_value Upper bound of 'high' intensity range
    * \return ProbabilityMap with the same extent as this
    */
-  [[nodiscard]] sim::ProbabilityMap* makeProbabilityMap(DurationSize time,
+  [[nodiscard]] sim::ProbabilityMap* makeProbabilityMap(const string& dir_out,
+                                                        DurationSize time,
                                                         DurationSize start_time,
                                                         int min_value,
                                                         int low_max,
@@ -227,13 +230,25 @@ public:
   {
     return make_unique<data::GridMap<Other>>(*cells_, nodata);
   }
+  /**
+   * \brief Create a TiledGrid<Other> covering this Environment
+   * \tparam Other Type of TiledGrid
+   * \param nodata Value that represents no data
+   * \return TiledGrid<Other> covering this Environment
+   */
+  template <class Other>
+  [[nodiscard]] unique_ptr<data::TiledGrid<Other>> makeTiledGrid(const Other nodata) const
+  {
+    return make_unique<data::TiledGrid<Other>>(*cells_, nodata);
+  }
   /**
    * \brief Create BurnedData and set burned bits based on Perimeter
    * \return BurnedData with all initially burned locations set
    */
   [[nodiscard]] unique_ptr<sim::BurnedData> makeBurnedData() const
   {
-    auto result = make_unique<sim::BurnedData>(*not_burnable_);
+    // shares tiles with not_burnable_ until they get written to
+    auto result = make_unique<sim::BurnedData>(not_burnable_);
     return result;
   }
   /**
@@ -242,13 +257,50 @@ public:
    */
   void resetBurnedData(sim::BurnedData* data) const noexcept
   {
-    // setting to {} probably makes a bitset of the same size on the stack?
-    // *data = {};
-    *data = *not_burnable_;
+    // only tiles that were written to need to change back
+    data->reset();
+  }
+  /**
+   * \brief Calculate slope and aspect for the middle of a 3x3 block of elevations
+   * \param dem Elevations, starting with the NW corner and going across each row
+   * \param cell_size Cell width and height (m)
+   * \param slope Slope to set
+   * \param aspect Aspect to set
+   */
+  static void calculateSlopeAspect(const MathSize dem[9],
+                                   const MathSize cell_size,
+                                   SlopeSize* slope,
+                                   AspectSize* aspect) noexcept
+  {
+    // Horn's algorithm
+    const MathSize dx = ((dem[2] + dem[5] + dem[5] + dem[8])
+                         - (dem[0] + dem[3] + dem[3] + dem[6]))
+                      / cell_size;
+    const MathSize dy = ((dem[6] + dem[7] + dem[7] + dem[8])
+                         - (dem[0] + dem[1] + dem[1] + dem[2]))
+                      / cell_size;
+    const MathSize key = (dx * dx + dy * dy);
+    auto slope_pct = static_cast<float>(100 * (sqrt(key) / 8.0));
+    const auto s = min(static_cast<SlopeSize>(MAX_SLOPE_FOR_DISTANCE), static_cast<SlopeSize>(round(slope_pct)));
+    static_assert(std::numeric_limits<SlopeSize>::max() >= MAX_SLOPE_FOR_DISTANCE);
+    MathSize aspect_azimuth = 0.0;
+
+    if (s > 0 && (dx != 0 || dy != 0))
+    {
+      aspect_azimuth = atan2(dy, -dx) * M_RADIANS_TO_DEGREES;
+      // NOTE: need to change this out of 'math' direction into 'real' direction (i.e. N is 0, not E)
+      aspect_azimuth = (aspect_azimuth > 90.0) ? (450.0 - aspect_azimuth) : (90.0 - aspect_azimuth);
+      if (aspect_azimuth == 360.0)
+      {
+        aspect_azimuth = 0.0;
+      }
+    }
+    *slope = s;
+    *aspect = static_cast<AspectSize>(round(aspect_azimuth));
   }
 protected:
   /**
-   * \brief Combine rasters into ConstantGrid<Cell, Topo>
+   * \brief Combine rasters into CellGrid
    * \param elevation Elevation raster
    * \return
    */
@@ -322,31 +374,7 @@ protected:
             }
             if (valid)
             {
-              // Horn's algorithm
-              const MathSize dx = ((dem[2] + dem[5] + dem[5] + dem[8])
-                                   - (dem[0] + dem[3] + dem[3] + dem[6]))
-                                / elevation.cellSize();
-              const MathSize dy = ((dem[6] + dem[7] + dem[7] + dem[8])
-                                   - (dem[0] + dem[1] + dem[1] + dem[2]))
-                                / elevation.cellSize();
-              const MathSize key = (dx * dx + dy * dy);
-              auto slope_pct = static_cast<float>(100 * (sqrt(key) / 8.0));
-              s = min(static_cast<SlopeSize>(MAX_SLOPE_FOR_DISTANCE), static_cast<SlopeSize>(round(slope_pct)));
-              static_assert(std::numeric_limits<SlopeSize>::max() >= MAX_SLOPE_FOR_DISTANCE);
-              MathSize aspect_azimuth = 0.0;
-
-              if (s > 0 && (dx != 0 || dy != 0))
-              {
-                aspect_azimuth = atan2(dy, -dx) * M_RADIANS_TO_DEGREES;
-                // NOTE: need to change this out of 'math' direction into 'real' direction (i.e. N is 0, not E)
-                aspect_azimuth = (aspect_azimuth > 90.0) ? (450.0 - aspect_azimuth) : (90.0 - aspect_azimuth);
-                if (aspect_azimuth == 360.0)
-                {
-                  aspect_azimuth = 0.0;
-                }
-              }
-
-              a = static_cast<AspectSize>(round(aspect_azimuth));
+              calculateSlopeAspect(dem, elevation.cellSize(), &s, &a);
             }
           }
           const auto cell = Cell{h, s, a, f};
@@ -423,7 +451,10 @@ protected:
                      || (rows() - 1) == r
                      || (columns() - 1) == c;
         // (*result)[location.hash()] = (nullptr == fuel::fuel_by_code(cells.at(location).fuelCode()));
-        (*result)[location.hash()] = is_outer || fuel::is_null_fuel(cells.at(location));
+        if (is_outer || fuel::is_null_fuel(cells.at(location)))
+        {
+          result->set(location.hash());
+        }
         //        if (fuel::is_null_fuel(cell(location)))
         //        {
         //          not_burnable_[location.hash()] = true;
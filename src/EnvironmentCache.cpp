@@ -0,0 +1,359 @@
+/* Copyright (c) His Majesty the King in Right of Canada as represented by the Minister of Natural Resources, 2024. */
+
+/* SPDX-License-Identifier: AGPL-3.0-or-later */
+
+#include "stdafx.h"
+#include "EnvironmentCache.h"
+#include <cstring>
+#include <filesystem>
+#include <regex>
+#include "EnvironmentInfo.h"
+#include "FuelLookup.h"
+#include "Settings.h"
+namespace fs = std::filesystem;
+namespace tbd::topo
+{
+/**
+ * \brief Identifies file as preprocessed Cells
+ */
+static constexpr char CACHE_MAGIC[8] = {'F', 'S', 'C', 'E', 'L', 'L', 'S', '\0'};
+/**
+ * \brief Version of file layout, which needs to change if Cell attributes are packed differently
+ */
+static constexpr uint32_t CACHE_VERSION = 1;
+/**
+ * \brief Alignment of grids within file so they can be mapped by page
+ */
+static constexpr uint64_t CACHE_ALIGNMENT = 4096;
+/**
+ * \brief Start of preprocessed file
+ */
+struct CacheHeader
+{
+  char magic[8];
+  uint32_t version;
+  uint32_t proj4_length;
+  int64_t rows;
+  int64_t columns;
+  double cell_size;
+  double xllcorner;
+  double yllcorner;
+  double xurcorner;
+  double yurcorner;
+  /**
+   * \brief Hash of fuel lookup table used to determine fuel codes
+   */
+  uint64_t fuel_lookup;
+  int64_t fuel_modified;
+  int64_t fuel_size;
+  int64_t elevation_modified;
+  int64_t elevation_size;
+  uint64_t cells_offset;
+  uint64_t elevations_offset;
+};
+static uint64_t align(const uint64_t offset)
+{
+  return ((offset + CACHE_ALIGNMENT - 1) / CACHE_ALIGNMENT) * CACHE_ALIGNMENT;
+}
+/**
+ * \brief Hash contents of the fuel lookup table so changing it invalidates fuel codes
+ * \return FNV-1a hash of fuel lookup table file
+ */
+static uint64_t hash_fuel_lookup()
+{
+  return util::hash_file(sim::Settings::fuelLookupTable());
+}
+static void file_stats(const string& filename, int64_t* modified, int64_t* size)
+{
+  struct stat info
+  {
+  };
+  logging::check_fatal(0 != stat(filename.c_str(), &info), "Unable to read %s", filename.c_str());
+  *modified = static_cast<int64_t>(info.st_mtime);
+  *size = static_cast<int64_t>(info.st_size);
+}
+/**
+ * \brief Read an entire raster, starting with the top left cell
+ * \tparam V Type of raster values
+ * \param filename Raster to read
+ * \param rows Number of rows in raster
+ * \param columns Number of columns in raster
+ * \param nodata Value that represents no data
+ * \return Raster values
+ */
+template <class V>
+static vector<V> read_raster(const string& filename,
+                             FullIdx* rows,
+                             FullIdx* columns,
+                             V* nodata)
+{
+  return data::with_tiff<vector<V>>(
+    filename,
+    [&filename, rows, columns, nodata](TIFF* tif, GTIF*) {
+      logging::info("Reading file %s", filename.c_str());
+      uint32_t width;
+      uint32_t length;
+      uint32_t tile_width;
+      uint32_t tile_length;
+      TIFFGetField(tif, TIFFTAG_IMAGEWIDTH, &width);
+      TIFFGetField(tif, TIFFTAG_IMAGELENGTH, &length);
+      TIFFGetField(tif, TIFFTAG_TILEWIDTH, &tile_width);
+      TIFFGetField(tif, TIFFTAG_TILELENGTH, &tile_length);
+      void* data;
+      uint32_t count;
+      TIFFGetField(tif, TIFFTAG_GDAL_NODATA, &count, &data);
+      logging::check_fatal(0 == count, "NODATA value is not set in input");
+      *nodata = static_cast<V>(stoi(string(static_cast<char*>(data))));
+      const int bps = std::numeric_limits<V>::digits + (1 * std::numeric_limits<V>::is_signed);
+      uint16_t bps_file;
+      TIFFGetField(tif, TIFFTAG_BITSPERSAMPLE, &bps_file);
+      logging::check_fatal(bps != bps_file,
+                           "Raster %s type is not expected type (%d bits instead of %d)",
+                           filename.c_str(),
+                           bps_file,
+                           bps);
+      *rows = static_cast<FullIdx>(length);
+      *columns = static_cast<FullIdx>(width);
+      vector<V> values(static_cast<size_t>(length) * width, *nodata);
+      const auto buf = _TIFFmalloc(TIFFTileSize(tif));
+      for (uint32_t h = 0; h < length; h += tile_length)
+      {
+        for (uint32_t w = 0; w < width; w += tile_width)
+        {
+          TIFFReadTile(tif, buf, w, h, 0, 0);
+          for (uint32_t y = 0; y < tile_length && (y + h) < length; ++y)
+          {
+            const auto x_max = min(tile_width, width - w);
+            std::memcpy(&values[static_cast<size_t>(y + h) * width + w],
+                        static_cast<V*>(buf) + static_cast<size_t>(y) * tile_width,
+                        x_max * sizeof(V));
+          }
+        }
+      }
+      _TIFFfree(buf);
+      return values;
+    });
+}
+string EnvironmentCache::fileName(const string& in_fuel)
+{
+  return fs::path(in_fuel).replace_extension(".cells").string();
+}
+void EnvironmentCache::create(const string& in_fuel, const string& in_elevation)
+{
+  const auto filename = fileName(in_fuel);
+  logging::note("Preprocessing %s into %s", in_fuel.c_str(), filename.c_str());
+  // use same checks as loading so we don't create anything that wouldn't load
+  const auto info = EnvironmentInfo::loadInfo(in_fuel, in_elevation);
+  const auto grid_info = data::read_header(in_fuel);
+  FullIdx rows;
+  FullIdx columns;
+  FuelSize fuel_nodata;
+  const auto fuel = read_raster<FuelSize>(in_fuel, &rows, &columns, &fuel_nodata);
+  FullIdx elevation_rows;
+  FullIdx elevation_columns;
+  ElevationSize elevation_nodata;
+  const auto elevation = read_raster<ElevationSize>(in_elevation,
+                                                    &elevation_rows,
+                                                    &elevation_columns,
+                                                    &elevation_nodata);
+  logging::check_fatal(rows != elevation_rows || columns != elevation_columns,
+                       "Grids are not aligned");
+  CacheHeader header{};
+  std::memcpy(header.magic, CACHE_MAGIC, sizeof(CACHE_MAGIC));
+  header.version = CACHE_VERSION;
+  header.proj4_length = static_cast<uint32_t>(grid_info.proj4().size());
+  header.rows = rows;
+  header.columns = columns;
+  header.cell_size = grid_info.cellSize();
+  header.xllcorner = grid_info.xllcorner();
+  header.yllcorner = grid_info.yllcorner();
+  header.xurcorner = grid_info.xurcorner();
+  header.yurcorner = grid_info.yurcorner();
+  header.fuel_lookup = hash_fuel_lookup();
+  file_stats(in_fuel, &header.fuel_modified, &header.fuel_size);
+  file_stats(in_elevation, &header.elevation_modified, &header.elevation_size);
+  const auto num_cells = static_cast<uint64_t>(rows) * static_cast<uint64_t>(columns);
+  header.cells_offset = align(sizeof(CacheHeader) + header.proj4_length);
+  header.elevations_offset = align(header.cells_offset + num_cells * sizeof(Topo));
+  // write to temporary file and rename so nothing reads a partial file
+  const auto tmp_name = filename + ".tmp";
+  ofstream out(tmp_name, std::ios::binary);
+  logging::check_fatal(!out.good(), "Unable to write to %s", tmp_name.c_str());
+  const auto pad_to = [&out](const uint64_t offset) {
+    const auto pos = static_cast<uint64_t>(out.tellp());
+    const vector<char> padding(offset - pos, 0);
+    out.write(padding.data(), static_cast<std::streamsize>(padding.size()));
+  };
+  out.write(reinterpret_cast<const char*>(&header), sizeof(CacheHeader));
+  out.write(grid_info.proj4().c_str(), header.proj4_length);
+  pad_to(header.cells_offset);
+  const auto& lookup = sim::Settings::fuelLookup();
+  vector<Topo> row_values(static_cast<size_t>(columns));
+  for (FullIdx r = 0; r < rows; ++r)
+  {
+    for (FullIdx c = 0; c < columns; ++c)
+    {
+      const auto f = fuel::FuelType::safeCode(lookup(fuel[r * columns + c], fuel_nodata));
+      auto s = static_cast<SlopeSize>(INVALID_SLOPE);
+      auto a = static_cast<AspectSize>(INVALID_ASPECT);
+      if (r > 0 && r < rows - 1 && c > 0 && c < columns - 1)
+      {
+        MathSize dem[9];
+        bool valid = true;
+        // rows go from top down, so first row of block is north
+        for (int i = -1; valid && i < 2; ++i)
+        {
+          for (int j = -1; j < 2; ++j)
+          {
+            const auto v = elevation[(r + i) * columns + (c + j)];
+            // can't calculate slope & aspect if any surrounding cell is nodata
+            if (elevation_nodata == v)
+            {
+              valid = false;
+              break;
+            }
+            dem[3 * (i + 1) + (j + 1)] = 1.0 * v;
+          }
+        }
+        if (valid)
+        {
+          Environment::calculateSlopeAspect(dem, grid_info.cellSize(), &s, &a);
+        }
+      }
+      row_values[static_cast<size_t>(c)] = Cell::hashCell(s, a, f);
+    }
+    out.write(reinterpret_cast<const char*>(row_values.data()),
+              static_cast<std::streamsize>(row_values.size() * sizeof(Topo)));
+  }
+  pad_to(header.elevations_offset);
+  out.write(reinterpret_cast<const char*>(elevation.data()),
+            static_cast<std::streamsize>(elevation.size() * sizeof(ElevationSize)));
+  out.close();
+  logging::check_fatal(out.fail(), "Unable to write to %s", tmp_name.c_str());
+  fs::rename(tmp_name, filename);
+}
+size_t EnvironmentCache::createAll(const string& path)
+{
+  static const std::regex re("fuel.*\\.tif", std::regex_constants::icase);
+  size_t result = 0;
+  for (const auto& entry : fs::recursive_directory_iterator(path))
+  {
+    if (fs::is_regular_file(entry)
+        && std::regex_match(entry.path().filename().string(), re))
+    {
+      const auto in_fuel = entry.path().generic_string();
+      create(in_fuel, EnvironmentInfo::elevationFor(in_fuel));
+      ++result;
+    }
+  }
+  return result;
+}
+unique_ptr<EnvironmentCache> EnvironmentCache::open(const string& in_fuel,
+                                                    const string& in_elevation)
+{
+  const auto filename = fileName(in_fuel);
+  if (!util::file_exists(filename.c_str()))
+  {
+    return nullptr;
+  }
+  auto file = make_unique<util::MappedFile>(filename);
+  // anything that can't be used just means reading the rasters instead
+  const auto header = file->at<CacheHeader>(0);
+  if (file->size() < sizeof(CacheHeader)
+      || 0 != std::memcmp(header->magic, CACHE_MAGIC, sizeof(CACHE_MAGIC)))
+  {
+    logging::warning("Not using %s because it is not a preprocessed environment file", filename.c_str());
+    return nullptr;
+  }
+  if (CACHE_VERSION != header->version)
+  {
+    logging::warning("Not using %s because it is version %d instead of %d",
+                     filename.c_str(),
+                     header->version,
+                     CACHE_VERSION);
+    return nullptr;
+  }
+  const auto num_cells = static_cast<uint64_t>(header->rows) * static_cast<uint64_t>(header->columns);
+  if (0 > header->rows
+      || 0 > header->columns
+      || header->cells_offset < sizeof(CacheHeader) + header->proj4_length
+      || header->elevations_offset < header->cells_offset + num_cells * sizeof(Topo)
+      || file->size() < header->elevations_offset + num_cells * sizeof(ElevationSize))
+  {
+    logging::warning("Not using %s because it is truncated", filename.c_str());
+    return nullptr;
+  }
+  int64_t fuel_modified;
+  int64_t fuel_size;
+  int64_t elevation_modified;
+  int64_t elevation_size;
+  file_stats(in_fuel, &fuel_modified, &fuel_size);
+  file_stats(in_elevation, &elevation_modified, &elevation_size);
+  if (fuel_modified != header->fuel_modified
+      || fuel_size != header->fuel_size
+      || elevation_modified != header->elevation_modified
+      || elevation_size != header->elevation_size
+      || hash_fuel_lookup() != header->fuel_lookup)
+  {
+    logging::warning("Not using %s because it is out of date", filename.c_str());
+    return nullptr;
+  }
+  return unique_ptr<EnvironmentCache>(new EnvironmentCache(std::move(file)));
+}
+EnvironmentCache::EnvironmentCache(unique_ptr<util::MappedFile>&& file)
+  : file_(std::move(file))
+{
+  // open() already checked that header is valid and file is big enough
+  const auto header = file_->at<CacheHeader>(0);
+  rows_ = header->rows;
+  columns_ = header->columns;
+  grid_info_ = data::GridBase(header->cell_size,
+                              header->xllcorner,
+                              header->yllcorner,
+                              header->xurcorner,
+                              header->yurcorner,
+                              string(file_->at<char>(sizeof(CacheHeader)), header->proj4_length));
+  cells_ = file_->at<Topo>(header->cells_offset);
+  elevations_ = file_->at<ElevationSize>(header->elevations_offset);
+}
+CellGrid* EnvironmentCache::readCells(const Point& point) const
+{
+  const auto window = data::find_window(grid_info_, point);
+  const auto num_rows = static_cast<Idx>(window.rows());
+  const auto num_columns = static_cast<Idx>(window.columns());
+  static Cell nodata{};
+  // only need rows that are in the window, but hash still uses MAX_COLUMNS per row
+  auto values = vector<Cell>{static_cast<size_t>(num_rows) * MAX_COLUMNS};
+  for (Idx r = 0; r < num_rows; ++r)
+  {
+    // grid is (0, 0) at bottom left but file starts at top
+    const auto row = cells_ + (window.max_row - r) * columns_ + window.min_column;
+    for (Idx c = 0; c < num_columns; ++c)
+    {
+      const auto h = Location(r, c).hash();
+      // HACK: match makeCells() not calculating for outside box of cells
+      values[h] = (0 == r || num_rows - 1 == r || 0 == c || num_columns - 1 == c)
+                  ? Cell{h, static_cast<SlopeSize>(INVALID_SLOPE), static_cast<AspectSize>(INVALID_ASPECT), static_cast<FuelCodeSize>(INVALID_FUEL_CODE)}
+                  : Cell{static_cast<Topo>(h) | row[c]};
+    }
+  }
+  return new CellGrid(
+    grid_info_.cellSize(),
+    num_rows,
+    num_columns,
+    nodata.fullHash(),
+    nodata,
+    window.xllcorner,
+    window.yllcorner,
+    window.xllcorner + (static_cast<MathSize>(num_columns) + 1) * grid_info_.cellSize(),
+    window.yllcorner + (static_cast<MathSize>(num_rows) + 1) * grid_info_.cellSize(),
+    string(grid_info_.proj4()),
+    std::move(values));
+}
+ElevationSize EnvironmentCache::elevation(const Point& point) const
+{
+  const auto coordinates = grid_info_.findFullCoordinates(point, true);
+  logging::check_fatal(nullptr == coordinates, "Point is not within preprocessed environment");
+  return elevations_[std::get<0>(*coordinates) * columns_ + std::get<1>(*coordinates)];
+}
+}
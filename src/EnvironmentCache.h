@@ -0,0 +1,97 @@
+/* Copyright (c) His Majesty the King in Right of Canada as represented by the Minister of Natural Resources, 2024. */
+
+/* SPDX-License-Identifier: AGPL-3.0-or-later */
+
+#pragma once
+#include <memory>
+#include <string>
+#include "Environment.h"
+#include "MappedFile.h"
+namespace tbd::topo
+{
+/**
+ * \brief Preprocessed Cells for a pair of fuel and elevation rasters.
+ *
+ * The file has a header with the raster extent and projection, followed by a
+ * page-aligned grid of Cell attributes for the whole raster and then the elevations.
+ * Slope and aspect are calculated when the file is created, so loading an Environment
+ * only needs to copy the section of the grid around the ignition out of the mapped file.
+ */
+class EnvironmentCache
+{
+public:
+  /**
+   * \brief Name of preprocessed file for fuel raster
+   * \param in_fuel Fuel raster
+   * \return Name of preprocessed file for fuel raster
+   */
+  [[nodiscard]] static string fileName(const string& in_fuel);
+  /**
+   * \brief Create preprocessed file for fuel and elevation rasters
+   * \param in_fuel Fuel raster
+   * \param in_elevation Elevation raster
+   */
+  static void create(const string& in_fuel, const string& in_elevation);
+  /**
+   * \brief Create preprocessed files for all fuel rasters in directory and its subdirectories
+   * \param path Directory to look for rasters in
+   * \return Number of rasters that were processed
+   */
+  static size_t createAll(const string& path);
+  /**
+   * \brief Open preprocessed file for rasters if it exists and is still valid
+   * \param in_fuel Fuel raster
+   * \param in_elevation Elevation raster
+   * \return Preprocessed file, or nullptr if it doesn't exist, is out of date, or isn't valid
+   */
+  [[nodiscard]] static unique_ptr<EnvironmentCache> open(const string& in_fuel,
+                                                          const string& in_elevation);
+  ~EnvironmentCache() = default;
+  EnvironmentCache(const EnvironmentCache& rhs) = delete;
+  EnvironmentCache(EnvironmentCache&& rhs) = delete;
+  EnvironmentCache& operator=(const EnvironmentCache& rhs) = delete;
+  EnvironmentCache& operator=(EnvironmentCache&& rhs) = delete;
+  /**
+   * \brief Make CellGrid for the section of the raster centered on Point
+   * \param point Point to center grid on
+   * \return CellGrid with the same values that reading the rasters would produce
+   */
+  [[nodiscard]] CellGrid* readCells(const Point& point) const;
+  /**
+   * \brief Elevation at Point
+   * \param point Point to find elevation for
+   * \return Elevation at Point
+   */
+  [[nodiscard]] ElevationSize elevation(const Point& point) const;
+private:
+  /**
+   * \brief Constructor
+   * \param file Preprocessed file that has already been checked
+   */
+  explicit EnvironmentCache(unique_ptr<util::MappedFile>&& file);
+  /**
+   * \brief Preprocessed file
+   */
+  unique_ptr<util::MappedFile> file_;
+  /**
+   * \brief Extent and projection of rasters
+   */
+  data::GridBase grid_info_;
+  /**
+   * \brief Number of rows in rasters
+   */
+  FullIdx rows_;
+  /**
+   * \brief Number of columns in rasters
+   */
+  FullIdx columns_;
+  /**
+   * \brief Cell attributes for each raster cell, starting at top left
+   */
+  const Topo* cells_;
+  /**
+   * \brief Elevation for each raster cell, starting at top left
+   */
+  const ElevationSize* elevations_;
+};
+}
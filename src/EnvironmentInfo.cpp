@@ -11,6 +11,18 @@ namespace tbd
 {
 namespace topo
 {
+string EnvironmentInfo::elevationFor(const string& in_fuel)
+{
+  auto fuel = in_fuel;
+  logging::verbose("Replacing directory separators in path for: %s\n", fuel.c_str());
+  // make sure we're using a consistent directory separator
+  std::replace(fuel.begin(), fuel.end(), '\\', '/');
+  // HACK: assume there's only one instance of 'fuel' in the file name we want to change
+  const auto find_what = string("fuel");
+  const auto find_len = find_what.length();
+  const auto find_start = fuel.find(find_what, fuel.find_last_of('/'));
+  return fuel.replace(find_start, find_len, "dem");
+}
 EnvironmentInfo::~EnvironmentInfo() = default;
 EnvironmentInfo::EnvironmentInfo(string in_fuel,
                                  string in_elevation,
@@ -57,6 +69,16 @@ unique_ptr<EnvironmentInfo> EnvironmentInfo::loadInfo(const string& in_fuel,
                                      data::read_header(in_elevation));
   return unique_ptr<EnvironmentInfo>(e);
 }
+unique_ptr<EnvironmentInfo> EnvironmentInfo::loadInfo(const string& in_fuel,
+                                                      const string& in_elevation,
+                                                      const data::GridBase& grid_info)
+{
+  const auto e = new EnvironmentInfo(in_fuel,
+                                     in_elevation,
+                                     data::GridBase(grid_info),
+                                     data::GridBase(grid_info));
+  return unique_ptr<EnvironmentInfo>(e);
+}
 Environment EnvironmentInfo::load(const string dir_out, const Point& point) const
 {
   return Environment::load(dir_out, point, in_fuel_, in_elevation_);
@@ -24,6 +24,22 @@ public:
    */
   [[nodiscard]] static unique_ptr<EnvironmentInfo> loadInfo(const string& in_fuel,
                                                             const string& in_elevation);
+  /**
+   * \brief Create EnvironmentInfo for rasters that are already known to be aligned
+   * \param in_fuel Fuel raster
+   * \param in_elevation Elevation raster
+   * \param grid_info Information about rasters
+   * \return EnvironmentInfo
+   */
+  [[nodiscard]] static unique_ptr<EnvironmentInfo> loadInfo(const string& in_fuel,
+                                                            const string& in_elevation,
+                                                            const data::GridBase& grid_info);
+  /**
+   * \brief Determine elevation raster that goes with fuel raster
+   * \param in_fuel Fuel raster
+   * \return Elevation raster
+   */
+  [[nodiscard]] static string elevationFor(const string& in_fuel);
   ~EnvironmentInfo();
   /**
    * \brief Construct from given rasters
@@ -95,6 +111,14 @@ public:
   {
     return fuel_.proj4();
   }
+  /**
+   * \brief Information about rasters
+   * \return Information about rasters
+   */
+  [[nodiscard]] constexpr const data::GridBase& gridInfo() const
+  {
+    return fuel_;
+  }
 private:
   /**
    * \brief Information about fuel raster
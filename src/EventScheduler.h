@@ -0,0 +1,141 @@
+/* Copyright (c) His Majesty the King in Right of Canada as represented by the Minister of Natural Resources, 2024. */
+
+/* SPDX-License-Identifier: AGPL-3.0-or-later */
+
+#pragma once
+#include <algorithm>
+#include <optional>
+#include <vector>
+#include "Event.h"
+#include "EventCompare.h"
+namespace tbd::sim
+{
+/**
+ * \brief Queue of Events ordered by EventCompare, kept as a binary heap.
+ *
+ * Behaves like a set of Events in that Events that are equivalent to one that is already
+ * queued or being evaluated are ignored, but keeps its storage when cleared so it can be
+ * reused without allocating.
+ */
+class EventScheduler
+{
+public:
+  EventScheduler() = default;
+  ~EventScheduler() = default;
+  EventScheduler(const EventScheduler& rhs) = delete;
+  EventScheduler(EventScheduler&& rhs) noexcept = default;
+  EventScheduler& operator=(const EventScheduler& rhs) = delete;
+  EventScheduler& operator=(EventScheduler&& rhs) noexcept = default;
+  /**
+   * \brief Whether or not there are no Events queued
+   * \return Whether or not there are no Events queued
+   */
+  [[nodiscard]] bool empty() const noexcept
+  {
+    return events_.empty();
+  }
+  /**
+   * \brief Add Event to queue unless an equivalent Event is queued or being evaluated
+   * \param event Event to add
+   */
+  void insert(Event&& event)
+  {
+    if (has_current_ && isSame(*current_, event))
+    {
+      return;
+    }
+    // equivalent queued Events come out in the order they were added and next() drops
+    // all but the first, so there's no need to look for them here
+    events_.push_back({std::move(event), order_++});
+    std::push_heap(events_.begin(), events_.end(), isAfter);
+  }
+  /**
+   * \brief Remove the first Event from the queue so it can be evaluated
+   *
+   * Event stays valid and blocks equivalent Events from being added until the next
+   * call to next() or clear().
+   * \return First Event in queue
+   */
+  [[nodiscard]] const Event& next()
+  {
+    std::pop_heap(events_.begin(), events_.end(), isAfter);
+    current_.emplace(std::move(events_.back().event));
+    events_.pop_back();
+    has_current_ = true;
+    // a set would have ignored equivalent Events since they were added after this one
+    while (!events_.empty() && isSame(events_.front().event, *current_))
+    {
+      std::pop_heap(events_.begin(), events_.end(), isAfter);
+      events_.pop_back();
+    }
+    return *current_;
+  }
+  /**
+   * \brief Remove all Events without releasing storage
+   */
+  void clear() noexcept
+  {
+    events_.clear();
+    // don't destroy current_ since it could still be getting evaluated
+    has_current_ = false;
+    order_ = 0;
+  }
+private:
+  /**
+   * \brief Event with the order it was added in
+   */
+  struct QueuedEvent
+  {
+    /**
+     * \brief Event that was added
+     */
+    Event event;
+    /**
+     * \brief Number of Events added before this one
+     */
+    size_t order;
+  };
+  /**
+   * \brief Whether or not Events are equivalent according to EventCompare
+   * \param x First Event
+   * \param y Second Event
+   * \return Whether or not Events are equivalent according to EventCompare
+   */
+  [[nodiscard]] static constexpr bool isSame(const Event& x, const Event& y)
+  {
+    constexpr EventCompare compare{};
+    return !compare(x, y) && !compare(y, x);
+  }
+  /**
+   * \brief Reverse of EventCompare, then order added, so heap has first Event at the front
+   * \param x First Event
+   * \param y Second Event
+   * \return Whether first Event is after second Event
+   */
+  [[nodiscard]] static constexpr bool isAfter(const QueuedEvent& x, const QueuedEvent& y)
+  {
+    constexpr EventCompare compare{};
+    if (compare(y.event, x.event))
+    {
+      return true;
+    }
+    return !compare(x.event, y.event) && y.order < x.order;
+  }
+  /**
+   * \brief Queued Events as a heap
+   */
+  std::vector<QueuedEvent> events_{};
+  /**
+   * \brief Event that was last taken from the queue
+   */
+  std::optional<Event> current_{};
+  /**
+   * \brief Number of Events added since queue was cleared
+   */
+  size_t order_{0};
+  /**
+   * \brief Whether or not current_ is still being evaluated
+   */
+  bool has_current_{false};
+};
+}
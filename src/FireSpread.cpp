@@ -9,8 +9,9 @@
 #include "FuelType.h"
 #include "Scenario.h"
 #include "Settings.h"
-#include "unstable.h"
+#include "Trig.h"
 #include "SpreadAlgorithm.h"
+#include "SpreadInfoCache.h"
 
 namespace tbd::sim
 {
@@ -69,6 +70,10 @@ static constexpr MathSize calculate_standard_wsv(const MathSize v) noexcept
          : 12.0 * (1.0 - exp(-0.0818 * (v - 28)));
 }
 static const util::LookupTable<&calculate_standard_wsv> STANDARD_WSV{};
+/**
+ * \brief Limit for a check that fails regardless of minimum rate of spread
+ */
+static constexpr MathSize NO_ROS_LIMIT = -std::numeric_limits<MathSize>::infinity();
 SpreadInfo::SpreadInfo(const Scenario& scenario,
                        const DurationSize time,
                        const topo::SpreadKey& key,
@@ -109,7 +114,7 @@ MathSize SpreadInfo::initial(SpreadInfo& spread,
     const auto wsv_x = spread.wind().wsvX() + wse * heading_sin;
     const auto wsv_y = spread.wind().wsvY() + wse * heading_cos;
     wsv = sqrt(wsv_x * wsv_x + wsv_y * wsv_y);
-    raz = (0 == wsv) ? 0 : acos(wsv_y / wsv);
+    raz = (0 == wsv) ? 0 : util::trig::acos(wsv_y / wsv);
     if (wsv_x < 0)
     {
       raz = util::RAD_360 - raz;
@@ -122,6 +127,7 @@ MathSize SpreadInfo::initial(SpreadInfo& spread,
                                         weather,
                                         isi)
                    * bui_eff;
+  spread.addRosCheck(spread.head_ros_, INVALID_ROS);
   if (min_ros > spread.head_ros_)
   {
     spread.head_ros_ = INVALID_ROS;
@@ -156,14 +162,97 @@ SpreadInfo::SpreadInfo(const Scenario& scenario,
                        const int nd,
                        const wx::FwiWeather* weather,
                        const wx::FwiWeather* weather_daily)
-  : SpreadInfo(time,
-               find_min_ros(scenario, time),
-               scenario.cellSize(),
-               key,
-               nd,
-               weather,
-               weather_daily)
+  : SpreadInfo(scenario.model().spreadInfoCache().calculate(scenario,
+                                                            time,
+                                                            key,
+                                                            nd,
+                                                            weather,
+                                                            weather_daily,
+                                                            find_min_ros(scenario, time)))
+{
+}
+SpreadInfo::SpreadInfo(const SpreadInfo& rhs,
+                       const DurationSize time,
+                       const MathSize min_ros,
+                       std::pmr::memory_resource* memory)
+  : offsets_(memory),
+    max_intensity_(rhs.max_intensity_),
+    key_(rhs.key_),
+    weather_(rhs.weather_),
+    time_(time),
+    l_b_(rhs.l_b_),
+    head_ros_(rhs.head_ros_),
+    cfb_(rhs.cfb_),
+    cfc_(rhs.cfc_),
+    tfc_(rhs.tfc_),
+    sfc_(rhs.sfc_),
+    is_crown_(rhs.is_crown_),
+    raz_(rhs.raz_),
+    nd_(rhs.nd_)
+{
+  for (size_t i = 0; i < rhs.num_ros_checks_; ++i)
+  {
+    const auto& [limit, head_ros] = rhs.ros_checks_[i];
+    if (min_ros > limit)
+    {
+      // would have stopped before calculating offsets
+      head_ros_ = head_ros;
+      max_intensity_ = INVALID_INTENSITY;
+      return;
+    }
+  }
+  if (isInvalid())
+  {
+    return;
+  }
+  // keep offsets the same way the spread algorithm would have if it used min_ros
+  offsets_.reserve(rhs.offsets_.size());
+  size_t begin = 0;
+  for (const auto& [end, is_required] : rhs.groups_)
+  {
+    bool added = false;
+    for (size_t i = begin; i < end; ++i)
+    {
+      const auto& offset = rhs.offsets_[i];
+      if (!(std::get<1>(offset) < min_ros))
+      {
+        offsets_.emplace_back(offset);
+        added = true;
+      }
+    }
+    if (is_required && !added)
+    {
+      break;
+    }
+    begin = end;
+  }
+  if (offsets_.empty())
+  {
+    invalidate();
+  }
+}
+void SpreadInfo::addRosCheck(const MathSize limit, const MathSize head_ros)
+{
+  logging::check_fatal(num_ros_checks_ >= ros_checks_.size(),
+                       "Too many checks against minimum rate of spread");
+  ros_checks_[num_ros_checks_++] = {limit, head_ros};
+}
+bool SpreadInfo::checkRos(const MathSize min_ros, const MathSize head_ros)
+{
+  const auto is_no_fuel = sfc_ < COMPARE_LIMIT;
+  addRosCheck(is_no_fuel ? NO_ROS_LIMIT : head_ros, head_ros);
+  return !(is_no_fuel || min_ros > head_ros);
+}
+void SpreadInfo::invalidate() noexcept
 {
+  head_ros_ = INVALID_ROS;
+  max_intensity_ = INVALID_INTENSITY;
+  cfb_ = -1;
+  cfc_ = -1;
+  tfc_ = -1;
+  sfc_ = -1;
+  is_crown_ = false;
+  raz_ = tbd::wx::Direction::Invalid;
 }
 static topo::SpreadKey make_key(const SlopeSize slope,
                                 const AspectSize aspect,
@@ -274,8 +363,7 @@ SpreadInfo::SpreadInfo(const DurationSize time,
   {
     const auto heading = util::to_heading(
       util::to_radians(static_cast<MathSize>(slope_azimuth)));
-    heading_sin = _sin(heading);
-    heading_cos = _cos(heading);
+    util::trig::sin_cos(heading, &heading_sin, &heading_cos);
   }
   // HACK: only use BUI from hourly weather for both calculations
   const auto _bui = bui().asValue();
@@ -285,20 +373,20 @@ SpreadInfo::SpreadInfo(const DurationSize time,
   MathSize ffmc_effect;
   MathSize wsv;
   MathSize rso;
-  if (min_ros > SpreadInfo::initial(
-        *this,
-        *weather_daily,
-        ffmc_effect,
-        wsv,
-        rso,
-        fuel,
-        has_no_slope,
-        heading_sin,
-        heading_cos,
-        bui_eff,
-        min_ros,
-        critical_surface_intensity)
-      || sfc_ < COMPARE_LIMIT)
+  if (!checkRos(min_ros,
+                SpreadInfo::initial(
+                  *this,
+                  *weather_daily,
+                  ffmc_effect,
+                  wsv,
+                  rso,
+                  fuel,
+                  has_no_slope,
+                  heading_sin,
+                  heading_cos,
+                  bui_eff,
+                  min_ros,
+                  critical_surface_intensity)))
   {
     return;
   }
@@ -306,19 +394,19 @@ SpreadInfo::SpreadInfo(const DurationSize time,
   // don't check again if pointing at same weather
   if (weather != weather_daily)
   {
-    if ((min_ros > SpreadInfo::initial(*this,
-                                       *weather,
-                                       ffmc_effect,
-                                       wsv,
-                                       rso,
-                                       fuel,
-                                       has_no_slope,
-                                       heading_sin,
-                                       heading_cos,
-                                       bui_eff,
-                                       min_ros,
-                                       critical_surface_intensity)
-         || sfc_ < COMPARE_LIMIT))
+    if (!checkRos(min_ros,
+                  SpreadInfo::initial(*this,
+                                      *weather,
+                                      ffmc_effect,
+                                      wsv,
+                                      rso,
+                                      fuel,
+                                      has_no_slope,
+                                      heading_sin,
+                                      heading_cos,
+                                      bui_eff,
+                                      min_ros,
+                                      critical_surface_intensity)))
     {
       // no spread with hourly weather
       // NOTE: only would happen if FFMC hourly is lower than FFMC daily?
@@ -358,7 +446,8 @@ SpreadInfo::SpreadInfo(const DurationSize time,
                                                 raz_.asRadians(),
                                                 head_ros_,
                                                 back_ros,
-                                                l_b_);
+                                                l_b_,
+                                                &groups_);
   // might not be correct depending on slope angle correction
   // #ifdef DEBUG_POINTS
   //   // if (head_ros_ >= min_ros)
@@ -373,14 +462,7 @@ SpreadInfo::SpreadInfo(const DurationSize time,
   // if no offsets then not spreading so invalidate head_ros_
   if (0 == offsets_.size())
   {
-    head_ros_ = INVALID_ROS;
-    max_intensity_ = INVALID_INTENSITY;
-    cfb_ = -1;
-    cfc_ = -1;
-    tfc_ = -1;
-    sfc_ = -1;
-    is_crown_ = false;
-    raz_ = tbd::wx::Direction::Invalid;
+    invalidate();
   }
 }
 // MathSize SpreadInfo::calculateSpreadProbability(const MathSize ros)
@@ -18,6 +18,7 @@ static constexpr MathSize INVALID_ROS = -1.0;
 static constexpr MathSize INVALID_INTENSITY = -1.0;
 
 class Scenario;
+class SpreadInfoCache;
 /**
  * \brief Possible results of an attempt to spread.
  */
@@ -305,6 +306,26 @@ public:
     return tfc_;
   }
 private:
+  friend class SpreadInfoCache;
+  /**
+   * \brief Maximum number of times head fire rate of spread gets checked against minimum
+   */
+  static constexpr size_t MAX_ROS_CHECKS = 4;
+  /**
+   * \brief Copy of spread calculated at a lower minimum rate of spread, limited to what
+   * would have been calculated at the given minimum
+   *
+   * Only head fire rate of spread, intensity and offsets are adjusted if the higher
+   * minimum means there would have been no spread.
+   * \param rhs SpreadInfo calculated at a minimum rate of spread lower than min_ros
+   * \param time Time spread is occurring
+   * \param min_ros Minimum rate of spread (m/min)
+   * \param memory Memory to allocate offsets from
+   */
+  SpreadInfo(const SpreadInfo& rhs,
+             DurationSize time,
+             MathSize min_ros,
+             std::pmr::memory_resource* memory);
   /**
    * Actual fire spread calculation without needing to worry about settings or scenarios
    */
@@ -345,10 +366,40 @@ private:
                           MathSize bui_eff,
                           MathSize min_ros,
                           MathSize critical_surface_intensity);
+  /**
+   * \brief Remember a check against the minimum rate of spread so it can be repeated for a higher minimum
+   * \param limit Highest minimum rate of spread that passes the check (m/min)
+   * \param head_ros Head fire rate of spread if the check fails (m/min)
+   */
+  void addRosCheck(MathSize limit, MathSize head_ros);
+  /**
+   * \brief Check result of initial spread calculations against minimum rate of spread
+   * \param min_ros Minimum rate of spread (m/min)
+   * \param head_ros Head fire rate of spread from initial calculations (m/min)
+   * \return Whether there is spread
+   */
+  [[nodiscard]] bool checkRos(MathSize min_ros, MathSize head_ros);
+  /**
+   * \brief Mark as not spreading
+   */
+  void invalidate() noexcept;
   /**
    * \brief Offsets from origin point that represent spread under these conditions
    */
   OffsetSet offsets_{};
+  /**
+   * \brief Groups that offsets were calculated in
+   */
+  OffsetGroups groups_{};
+  /**
+   * \brief Checks against minimum rate of spread that were done before calculating offsets,
+   * as the highest minimum that passes and the head fire rate of spread if it fails
+   */
+  array<pair<MathSize, MathSize>, MAX_ROS_CHECKS> ros_checks_{};
+  /**
+   * \brief Number of checks in ros_checks_
+   */
+  size_t num_ros_checks_{0};
   /**
    * \brief Maximum intensity in any direction for spread (kW/m)
    */
@@ -18,13 +18,13 @@ FireWeather::~FireWeather()
   delete weather_by_hour_by_day_;
   delete survival_probability_;
 }
-static unique_ptr<SurvivalMap> make_survival(
+SurvivalMap make_survival(
   const set<const fuel::FuelType*>& used_fuels,
   const Day min_date,
   const Day max_date,
   const vector<const FwiWeather*>& weather_by_hour_by_day)
 {
-  auto result = make_unique<SurvivalMap>();
+  SurvivalMap result{};
   const bool deterministic = tbd::sim::Settings::deterministic();
   for (const auto& in_fuel : used_fuels)
   {
@@ -50,32 +50,48 @@ static unique_ptr<SurvivalMap> make_survival(
                                                : 0.0);
         }
       }
-      result->at(code) = std::move(by_fuel);
+      result.at(code) = std::move(by_fuel);
     }
   }
   return result;
 }
-FireWeather::FireWeather(const set<const fuel::FuelType*>& used_fuels,
-                         const Day min_date,
-                         const Day max_date,
-                         vector<const FwiWeather*>* weather_by_hour_by_day)
-  : weather_by_hour_by_day_(weather_by_hour_by_day),
-    survival_probability_(
-      make_survival(used_fuels, min_date, max_date, *weather_by_hour_by_day).release()),
-    min_date_(min_date),
-    max_date_(max_date)
+size_t make_weighted_dsr(const vector<const FwiWeather*>& weather_by_hour_by_day)
 {
-  weighted_dsr_ = 0;
+  size_t result = 0;
   // make it so that dsr near start of scenario matters more
   auto weight = 1000000000.0;
-  for (auto& w : *weather_by_hour_by_day_)
+  for (auto& w : weather_by_hour_by_day)
   {
     if (nullptr != w)
     {
       const auto dsr = 0.0272 * pow(w->fwi().asValue(), 1.77);
-      weighted_dsr_ += static_cast<size_t>(weight * dsr);
+      result += static_cast<size_t>(weight * dsr);
       weight *= 0.8;
     }
   }
+  return result;
+}
+FireWeather::FireWeather(const set<const fuel::FuelType*>& used_fuels,
+                         const Day min_date,
+                         const Day max_date,
+                         vector<const FwiWeather*>* weather_by_hour_by_day)
+  : FireWeather(min_date,
+                max_date,
+                weather_by_hour_by_day,
+                make_survival(used_fuels, min_date, max_date, *weather_by_hour_by_day),
+                make_weighted_dsr(*weather_by_hour_by_day))
+{
+}
+FireWeather::FireWeather(const Day min_date,
+                         const Day max_date,
+                         vector<const FwiWeather*>* weather_by_hour_by_day,
+                         SurvivalMap&& survival_probability,
+                         const size_t weighted_dsr)
+  : weather_by_hour_by_day_(weather_by_hour_by_day),
+    survival_probability_(new SurvivalMap(std::move(survival_probability))),
+    min_date_(min_date),
+    max_date_(max_date),
+    weighted_dsr_(weighted_dsr)
+{
 }
 }
@@ -22,6 +22,24 @@ namespace wx
 {
 // use an array instead of a map since number of values is so small and access should be faster
 using SurvivalMap = array<vector<float>, NUMBER_OF_FUELS>;
+/**
+ * \brief Calculate probability of survival for each used fuel at each hour of a stream
+ * \param used_fuels set of FuelTypes that are used in the simulation
+ * \param min_date Minimum date present in stream
+ * \param max_date Maximum date present in stream
+ * \param weather_by_hour_by_day FwiWeather by hour by Day
+ * \return Probability of survival for each fuel at each hour
+ */
+[[nodiscard]] SurvivalMap make_survival(const set<const fuel::FuelType*>& used_fuels,
+                                        Day min_date,
+                                        Day max_date,
+                                        const vector<const FwiWeather*>& weather_by_hour_by_day);
+/**
+ * \brief Calculate Weighted Danger Severity Rating for a stream
+ * \param weather_by_hour_by_day FwiWeather by hour by Day
+ * \return Weighted Danger Severity Rating for the stream
+ */
+[[nodiscard]] size_t make_weighted_dsr(const vector<const FwiWeather*>& weather_by_hour_by_day);
 /**
  * \brief A stream of weather that gets used by a Scenario every Iteration.
  */
@@ -112,6 +130,19 @@ public:
               Day min_date,
               Day max_date,
               vector<const FwiWeather*>* weather_by_hour_by_day);
+  /**
+   * \brief Constructor using survival probabilities that were already calculated
+   * \param min_date Minimum date present in stream
+   * \param max_date Maximum date present in stream
+   * \param weather_by_hour_by_day FwiWeather by hour by Day
+   * \param survival_probability Probability of survival for each fuel at each hour
+   * \param weighted_dsr Weighted Danger Severity Rating for the stream
+   */
+  FireWeather(Day min_date,
+              Day max_date,
+              vector<const FwiWeather*>* weather_by_hour_by_day,
+              SurvivalMap&& survival_probability,
+              size_t weighted_dsr);
 private:
   /**
    * \brief FwiWeather by hour by Day
@@ -573,4 +573,16 @@ FireWeatherDaily::FireWeatherDaily(
                 make_vector(data).release())
 {
 }
+FireWeatherDaily::FireWeatherDaily(
+  const map<Day, FwiWeather>& data,
+  vector<const FwiWeather*>* weather_by_hour_by_day,
+  SurvivalMap&& survival_probability,
+  const size_t weighted_dsr)
+  : FireWeather(data.begin()->first,
+                data.rbegin()->first,
+                weather_by_hour_by_day,
+                std::move(survival_probability),
+                weighted_dsr)
+{
+}
 }
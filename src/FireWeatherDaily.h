@@ -12,6 +12,12 @@
 #include "FireWeather.h"
 namespace tbd::wx
 {
+/**
+ * \brief Estimate hourly weather from daily weather
+ * \param data map of Day to FwiWeather to estimate from
+ * \return FwiWeather by hour by Day
+ */
+[[nodiscard]] unique_ptr<vector<const FwiWeather*>> make_vector(map<Day, FwiWeather> data);
 /**
  * \brief A stream of weather that gets used by a Scenario every Iteration.
  */
@@ -30,6 +36,17 @@ public:
    */
   FireWeatherDaily(const set<const fuel::FuelType*>& used_fuels,
                    const map<Day, FwiWeather>& data);
+  /**
+   * \brief Constructor using survival probabilities that were already calculated
+   * \param data map of Day to FwiWeather to use for weather stream
+   * \param weather_by_hour_by_day FwiWeather by hour by Day made from data by make_vector()
+   * \param survival_probability Probability of survival for each fuel at each hour
+   * \param weighted_dsr Weighted Danger Severity Rating for the stream
+   */
+  FireWeatherDaily(const map<Day, FwiWeather>& data,
+                   vector<const FwiWeather*>* weather_by_hour_by_day,
+                   SurvivalMap&& survival_probability,
+                   size_t weighted_dsr);
   /**
    * \brief Move constructor
    * \param rhs FireWeatherDaily to move from
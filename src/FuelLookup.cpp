@@ -506,6 +506,19 @@ public:
     }
     return result;
   }
+  /**
+   * \brief Create a set of all FuelTypes that the lookup table has codes for
+   * \return Set of all FuelTypes that the lookup table has codes for
+   */
+  set<const FuelType*> lookupFuels() const
+  {
+    set<const FuelType*> result{};
+    for (const auto& kv : fuel_grid_codes_)
+    {
+      result.insert(kv.first);
+    }
+    return result;
+  }
   FuelLookupImpl(const FuelLookupImpl& rhs) = delete;
   FuelLookupImpl(FuelLookupImpl&& rhs) = delete;
   FuelLookupImpl& operator=(const FuelLookupImpl& rhs) = delete;
@@ -649,6 +662,10 @@ set<const FuelType*> FuelLookup::usedFuels() const
 {
   return impl_->usedFuels();
 }
+set<const FuelType*> FuelLookup::lookupFuels() const
+{
+  return impl_->lookupFuels();
+}
 const FuelType* FuelLookup::byName(const string& name) const
 {
   return impl_->byName(name);
@@ -78,6 +78,11 @@ public:
    * \return set of FuelTypes that are used in the lookup table
    */
   [[nodiscard]] set<const FuelType*> usedFuels() const;
+  /**
+   * \brief Retrieve set of FuelTypes that the lookup table has codes for, whether or not they are used
+   * \return set of FuelTypes that the lookup table has codes for
+   */
+  [[nodiscard]] set<const FuelType*> lookupFuels() const;
   /**
    * \brief Look up a FuelType based on the given name
    * \param name Name of the fuel to find
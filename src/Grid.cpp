@@ -270,4 +270,85 @@ void write_ascii_header(ofstream& out,
 {
   return with_tiff<GridBase>(filename, [](TIFF* tif, GTIF* gtif) { return read_header(tif, gtif); });
 }
+Idx window_size(const MathSize cell_size)
+{
+  static_assert(MAX_ROWS == MAX_COLUMNS);
+  const auto spread = sim::Settings::maximumDailySpread();
+  // surface needs every cell that could be an ignition
+  if (sim::Settings::surface() || spread <= 0)
+  {
+    return MAX_COLUMNS;
+  }
+  // start is partway through the first day, and the outside cells can't burn
+  const auto radius = static_cast<FullIdx>(ceil((sim::Settings::maxDateOffset() + 1) * spread / cell_size)) + 1;
+  // use whole tiles so TiledGrid doesn't have partial ones
+  const auto size = (2 * radius + 1 + TILE_WIDTH - 1) / TILE_WIDTH * TILE_WIDTH;
+  if (size >= static_cast<FullIdx>(MAX_COLUMNS))
+  {
+    // long runs hit this unless spread is low, so make it clear nothing is saved
+    logging::note("Spreading %0.0f m/day until day %d needs %ld cells across, so using largest window",
+                  spread,
+                  sim::Settings::maxDateOffset(),
+                  size);
+    return MAX_COLUMNS;
+  }
+  return static_cast<Idx>(size);
+}
+GridWindow find_window(const GridBase& grid_info, const topo::Point& point)
+{
+  const auto size = static_cast<FullIdx>(window_size(grid_info.cellSize()));
+  logging::note("Using %dx%d cell simulation window", size, size);
+  auto actual_rows = grid_info.calculateRows();
+  auto actual_columns = grid_info.calculateColumns();
+  const auto coordinates = grid_info.findFullCoordinates(point, true);
+  logging::note("Coordinates before reading are (%d, %d => %f, %f)",
+                std::get<0>(*coordinates),
+                std::get<1>(*coordinates),
+                std::get<0>(*coordinates) + std::get<2>(*coordinates) / 1000.0,
+                std::get<1>(*coordinates) + std::get<3>(*coordinates) / 1000.0);
+  auto min_column = max(static_cast<FullIdx>(0),
+                        static_cast<FullIdx>(std::get<1>(*coordinates) - size / static_cast<FullIdx>(2)));
+  if (min_column + size >= actual_columns)
+  {
+    min_column = max(static_cast<FullIdx>(0), actual_columns - size);
+  }
+  const auto max_column = static_cast<FullIdx>(min(min_column + size - 1, actual_columns));
+#ifdef DEBUG_GRIDS
+  logging::check_fatal(min_column < 0, "Column can't be less than 0");
+  logging::check_fatal(max_column - min_column > size, "Can't have more than %d columns", size);
+  logging::check_fatal(max_column > actual_columns, "Can't have more than actual %d columns", actual_columns);
+#endif
+  auto min_row = max(static_cast<FullIdx>(0),
+                     static_cast<FullIdx>(std::get<0>(*coordinates) - size / static_cast<FullIdx>(2)));
+  if (min_row + size >= actual_rows)
+  {
+    min_row = max(static_cast<FullIdx>(0), actual_rows - size);
+  }
+  const auto max_row = static_cast<FullIdx>(min(min_row + size - 1, actual_rows));
+#ifdef DEBUG_GRIDS
+  logging::check_fatal(min_row < 0, "Row can't be less than 0 but is %d", min_row);
+  logging::check_fatal(max_row - min_row > size, "Can't have more than %d rows but have %d", size, max_row - min_row);
+  logging::check_fatal(max_row > actual_rows, "Can't have more than actual %d rows", actual_rows);
+#endif
+  const auto new_xll = grid_info.xllcorner() + (static_cast<MathSize>(min_column) * grid_info.cellSize());
+  const auto new_yll = grid_info.yllcorner()
+                     + (static_cast<MathSize>(actual_rows) - static_cast<MathSize>(max_row))
+                         * grid_info.cellSize();
+#ifdef DEBUG_GRIDS
+  logging::check_fatal(new_yll < grid_info.yllcorner(),
+                       "New yllcorner is outside original grid");
+#endif
+  logging::verbose("Translated lower left is (%f, %f) from (%f, %f)",
+                   new_xll,
+                   new_yll,
+                   grid_info.xllcorner(),
+                   grid_info.yllcorner());
+  return {
+    min_row,
+    max_row,
+    min_column,
+    max_column,
+    new_xll,
+    new_yll};
+}
 }
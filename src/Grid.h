@@ -4,6 +4,7 @@
 /* SPDX-License-Identifier: AGPL-3.0-or-later */
 
 #pragma once
+#include <charconv>
 #include <limits>
 #include <memory>
 #include <string>
@@ -13,6 +14,7 @@
 #include "Log.h"
 #include "Point.h"
 #include "Settings.h"
+#include "TileCompression.h"
 
 using tbd::topo::Location;
 using tbd::topo::Position;
@@ -209,6 +211,32 @@ void write_ascii_header(ofstream& out,
                         MathSize yll,
                         MathSize cell_size,
                         MathSize no_data);
+/**
+ * \brief Longest text that a value in an .asc file can be
+ */
+static constexpr size_t ASCII_VALUE_MAX = 32;
+/**
+ * \brief Write value the same way operator<< would, for use in an .asc file
+ * \tparam R Type of value
+ * \param first Start of buffer to write into
+ * \param value Value to write
+ * \return End of text that was written
+ */
+template <class R>
+char* format_ascii_value(char* first, const R value)
+{
+  const auto last = first + ASCII_VALUE_MAX;
+  if constexpr (std::is_floating_point_v<R>)
+  {
+    // stream default is 6 significant digits in general format
+    return std::to_chars(first, last, value, std::chars_format::general, 6).ptr;
+  }
+  else
+  {
+    // use + so char types get promoted to a printable number
+    return std::to_chars(first, last, +value).ptr;
+  }
+}
 template <class R>
 [[nodiscard]] R with_tiff(const string& filename, function<R(TIFF*, GTIF*)> fct)
 {
@@ -240,6 +268,73 @@ template <class R>
 }
 GridBase read_header(TIFF* tif, GTIF* gtif);
 GridBase read_header(const string& filename);
+/**
+ * \brief Section of a raster that gets loaded into memory around a Point
+ *
+ * Rows are counted from the top of the raster, as they are stored in the file.
+ */
+struct GridWindow
+{
+  /**
+   * \brief First row of raster that is in the window
+   */
+  FullIdx min_row;
+  /**
+   * \brief Last row of raster that is in the window
+   */
+  FullIdx max_row;
+  /**
+   * \brief First column of raster that is in the window
+   */
+  FullIdx min_column;
+  /**
+   * \brief Last column of raster that is in the window
+   */
+  FullIdx max_column;
+  /**
+   * \brief Lower left corner X coordinate of window (m)
+   */
+  MathSize xllcorner;
+  /**
+   * \brief Lower left corner Y coordinate of window (m)
+   */
+  MathSize yllcorner;
+  /**
+   * \brief Number of rows in window
+   * \return Number of rows in window
+   */
+  [[nodiscard]] constexpr FullIdx rows() const noexcept
+  {
+    return max_row - min_row + 1;
+  }
+  /**
+   * \brief Number of columns in window
+   * \return Number of columns in window
+   */
+  [[nodiscard]] constexpr FullIdx columns() const noexcept
+  {
+    return max_column - min_column + 1;
+  }
+};
+/**
+ * \brief Number of rows and columns to load around a Point
+ *
+ * This is enough for a fire spreading at the worst case daily distance to stay inside it
+ * until the last output date, but never more than MAX_ROWS or MAX_COLUMNS. Rows are
+ * still MAX_COLUMNS wide so hashes don't change, which means only the rows outside the
+ * window are saved. The window doesn't grow if a fire reaches its edge, so the default
+ * maximum daily spread of 0 always uses the largest window and smaller ones are opt in.
+ * \param cell_size Cell width and height (m)
+ * \return Number of rows and columns to load around a Point
+ */
+[[nodiscard]] Idx window_size(MathSize cell_size);
+/**
+ * \brief Determine the section of a raster to load so that it is centered on Point if possible
+ * \param grid_info GridBase for the full raster
+ * \param point Point to center window on
+ * \return Section of raster to load
+ */
+[[nodiscard]] GridWindow find_window(const GridBase& grid_info, const topo::Point& point);
 /**
  * \brief A GridBase with an associated type of data.
  * \tparam T Type of data after conversion from initialization type.
@@ -506,6 +601,15 @@ public:
   D data;
 protected:
   virtual tuple<Idx, Idx, Idx, Idx> dataBounds() const = 0;
+  /**
+   * \brief Call function for every Location that has a value, if the data structure can list them
+   * \param fct Function to call with Location and value
+   * \return Whether values were listed, or false if every Location needs to be checked instead
+   */
+  virtual bool forEachValue(const function<void(const Location&, T)>& /* fct */) const
+  {
+    return false;
+  }
   /**
    * \brief Save GridMap contents to .asc file
    * \tparam R Type to be written to .asc file
@@ -553,20 +657,75 @@ protected:
       yll,
       this->cellSize(),
       static_cast<MathSize>(no_data));
-    for (Idx ro = 0; ro < num_rows; ++ro)
+    const auto rows_out = static_cast<size_t>(num_rows);
+    const auto columns_out = static_cast<size_t>(num_columns);
+    // values for each output row, by output column
+    vector<vector<pair<size_t, R>>> by_row(rows_out);
+    // if cells without values convert to nodata then only need to look at cells with values
+    const R empty = convert(this->nodataValue());
+    const auto is_sparse = 0 == memcmp(&empty, &no_data, sizeof(R))
+                        && this->forEachValue([&](const Location& loc, const T value) {
+                             // need to output in reverse order since (0,0) is bottom left
+                             const auto ro = static_cast<int64_t>(max_row) - loc.row();
+                             const auto co = static_cast<int64_t>(loc.column()) - min_column;
+                             if (0 > ro
+                                 || 0 > co
+                                 || static_cast<int64_t>(rows_out) <= ro
+                                 || static_cast<int64_t>(columns_out) <= co)
+                             {
+                               return;
+                             }
+                             by_row[static_cast<size_t>(ro)].emplace_back(static_cast<size_t>(co),
+                                                                          convert(value));
+                           });
+    char value_text[ASCII_VALUE_MAX];
+    const auto no_data_end = format_ascii_value(value_text, no_data);
+    string no_data_text(value_text, no_data_end);
+    no_data_text += ' ';
+    string line{};
+    line.reserve(columns_out * no_data_text.size() + 1);
+    for (size_t ro = 0; ro < rows_out; ++ro)
     {
-      // HACK: do this so that we always get at least one pixel in output
-      // need to output in reverse order since (0,0) is bottom left
-      const Idx r = static_cast<Idx>(max_row) - ro;
-      for (Idx co = 0; co < num_columns; ++co)
+      line.clear();
+      if (is_sparse)
+      {
+        auto& values = by_row[ro];
+        const auto by_column = [](const pair<size_t, R>& lhs, const pair<size_t, R>& rhs) {
+          return lhs.first < rhs.first;
+        };
+        if (!std::is_sorted(values.begin(), values.end(), by_column))
+        {
+          std::sort(values.begin(), values.end(), by_column);
+        }
+        size_t co = 0;
+        for (const auto& kv : values)
+        {
+          for (; co < kv.first; ++co)
+          {
+            line += no_data_text;
+          }
+          line.append(value_text, format_ascii_value(value_text, kv.second));
+          line += ' ';
+          ++co;
+        }
+        for (; co < columns_out; ++co)
+        {
+          line += no_data_text;
+        }
+      }
+      else
       {
-        const Location idx(static_cast<Idx>(r), static_cast<Idx>(min_column + co));
-        // HACK: use + here so that it gets promoted to a printable number
-        //       prevents char type being output as characters
-        out << +(convert(this->at(idx)))
-            << " ";
+        // HACK: do this so that we always get at least one pixel in output
+        const Idx r = static_cast<Idx>(max_row - ro);
+        for (size_t co = 0; co < columns_out; ++co)
+        {
+          const Location idx(r, static_cast<Idx>(min_column + co));
+          line.append(value_text, format_ascii_value(value_text, convert(this->at(idx))));
+          line += ' ';
+        }
       }
-      out << "\n";
+      line += '\n';
+      out.write(line.data(), static_cast<std::streamsize>(line.size()));
     }
     out.close();
     this->createPrj(dir, base_name);
@@ -578,12 +737,15 @@ protected:
    * \param dir Directory to save into
    * \param base_name File base name to use
    * \param convert Function to convert from V to R
+   * \param no_data Value to use as nodata in output
+   * \param reduction How to combine pixels for overviews if saving as COG
    */
   template <class R>
   string saveToTiffFile(const string& dir,
                         const string& base_name,
                         std::function<R(T value)> convert,
-                        const R no_data) const
+                        const R no_data,
+                        const OverviewReduction reduction) const
   {
     uint32_t tileWidth = min((int)(this->columns()), 256);
     uint32_t tileHeight = min((int)(this->rows()), 256);
@@ -690,7 +852,6 @@ protected:
       logging::extensive("Writing %s with float data type for %s",
                          filename.c_str(),
                          typeid(R).name());
-      TIFFSetField(tif, TIFFTAG_SAMPLEFORMAT, SAMPLEFORMAT_IEEEFP);
     }
     else
     {
@@ -711,62 +872,214 @@ protected:
       str,
       nodata_as_int,
       static_cast<MathSize>(no_data));
-    TIFFSetField(tif, TIFFTAG_GDAL_NODATA, str);
     logging::extensive("%s takes %d bits", base_name.c_str(), bps);
-    TIFFSetField(tif, TIFFTAG_IMAGEWIDTH, num_columns);
-    TIFFSetField(tif, TIFFTAG_IMAGELENGTH, num_rows);
-    TIFFSetField(tif, TIFFTAG_SAMPLESPERPIXEL, 1);
-    TIFFSetField(tif, TIFFTAG_BITSPERSAMPLE, bps);
-    TIFFSetField(tif, TIFFTAG_TILEWIDTH, tileWidth);
-    TIFFSetField(tif, TIFFTAG_TILELENGTH, tileHeight);
-    TIFFSetField(tif, TIFFTAG_PLANARCONFIG, PLANARCONFIG_CONTIG);
-    TIFFSetField(tif, TIFFTAG_ORIENTATION, ORIENTATION_TOPLEFT);
-    TIFFSetField(tif, TIFFTAG_COMPRESSION, COMPRESSION_LZW);
+    const auto compression = tbd::sim::Settings::tiffCompression();
+    // floating point predictor only works on floats, so integers use horizontal instead
+    uint16_t predictor = tbd::sim::Settings::tiffPredictor();
+    if (PREDICTOR_FLOATINGPOINT == predictor && !std::is_floating_point<R>::value)
+    {
+      predictor = PREDICTOR_HORIZONTAL;
+    }
+    // fields for the full resolution image that every overview needs too
+    const auto set_fields = [&](const size_t width, const size_t height) {
+      if (std::is_floating_point<R>::value)
+      {
+        TIFFSetField(tif, TIFFTAG_SAMPLEFORMAT, SAMPLEFORMAT_IEEEFP);
+      }
+      TIFFSetField(tif, TIFFTAG_GDAL_NODATA, str);
+      TIFFSetField(tif, TIFFTAG_IMAGEWIDTH, static_cast<uint32_t>(width));
+      TIFFSetField(tif, TIFFTAG_IMAGELENGTH, static_cast<uint32_t>(height));
+      TIFFSetField(tif, TIFFTAG_SAMPLESPERPIXEL, 1);
+      TIFFSetField(tif, TIFFTAG_BITSPERSAMPLE, bps);
+      TIFFSetField(tif, TIFFTAG_TILEWIDTH, tileWidth);
+      TIFFSetField(tif, TIFFTAG_TILELENGTH, tileHeight);
+      TIFFSetField(tif, TIFFTAG_PLANARCONFIG, PLANARCONFIG_CONTIG);
+      TIFFSetField(tif, TIFFTAG_ORIENTATION, ORIENTATION_TOPLEFT);
+      TIFFSetField(tif, TIFFTAG_COMPRESSION, compression);
+      // libtiff only knows about predictor tag if codec supports it, so don't apply it if not recorded
+      if (PREDICTOR_NONE != predictor && !TIFFSetField(tif, TIFFTAG_PREDICTOR, predictor))
+      {
+        predictor = PREDICTOR_NONE;
+      }
+    };
+    set_fields(num_columns, num_rows);
     GTIFSetFromProj4(gtif, this->proj4().c_str());
     TIFFSetField(tif, TIFFTAG_GEOTIEPOINTS, 6, tiePoints);
     TIFFSetField(tif, TIFFTAG_GEOPIXELSCALE, 3, pixelScale);
     size_t tileSize = tileWidth * tileHeight;
     const auto buf_size = tileSize * sizeof(R);
     logging::extensive("%s has buffer size %d", base_name.c_str(), buf_size);
-    R* buf = (R*)_TIFFmalloc(buf_size);
-    for (size_t co = 0; co < num_columns; co += tileWidth)
+    const size_t tiles_across = tiles_for(num_columns, tileWidth);
+    const size_t tiles_down = tiles_for(num_rows, tileHeight);
+    // buffer for each tile, which is left empty if tile only has nodata
+    TileLevel image{num_columns,
+                    num_rows,
+                    tiles_across,
+                    tiles_down,
+                    vector<vector<uint8_t>>(tiles_across * tiles_down)};
+    auto& tiles = image.tiles;
+    vector<uint8_t> nodata_tile(buf_size);
+    for (size_t i = 0; i < tileSize; ++i)
     {
-      for (size_t ro = 0; ro < num_rows; ro += tileHeight)
-      {
-        std::fill_n(
-          &buf[0],
-          tileWidth * tileHeight,
-          no_data);
-        // NOTE: shouldn't need to check if writing outside of tile because we made bounds on tile edges above
-        // need to put data from grid into buffer, but flipped vertically
-        for (size_t x = 0; x < tileWidth; ++x)
+      memcpy(&nodata_tile[i * sizeof(R)], &no_data, sizeof(R));
+    }
+    // NOTE: need to put data from grid into tiles, but flipped vertically
+    const auto put = [&](vector<uint8_t>& tile, const size_t x, const size_t y, const R value) {
+      // HACK: was getting invalid rasters if assigning directly into buf
+      memcpy(&tile[((y % tileHeight) * tileWidth + (x % tileWidth)) * sizeof(R)], &value, sizeof(R));
+    };
+    // if cells without values convert to nodata then only need to look at cells with values
+    const R empty = convert(this->nodataValue());
+    const auto is_sparse = 0 == memcmp(&empty, &no_data, sizeof(R))
+                        && this->forEachValue([&](const Location& loc, const T value) {
+                             const auto y = static_cast<int64_t>(max_row) - loc.row() - 1;
+                             const auto x = static_cast<int64_t>(loc.column()) - min_column;
+                             if (0 > y
+                                 || 0 > x
+                                 || static_cast<int64_t>(num_rows) <= y
+                                 || static_cast<int64_t>(num_columns) <= x)
+                             {
+                               return;
+                             }
+                             auto& tile = tiles[(y / tileHeight) * tiles_across + x / tileWidth];
+                             if (tile.empty())
+                             {
+                               tile = nodata_tile;
+                             }
+                             put(tile, x, y, convert(value));
+                           });
+    for_each_tile(
+      tiles.size(),
+      [&](const size_t i) {
+        auto& tile = tiles[i];
+        if (!is_sparse)
         {
+          tile = nodata_tile;
+          const auto co = (i % tiles_across) * tileWidth;
+          const auto ro = (i / tiles_across) * tileHeight;
           for (size_t y = 0; y < tileHeight; ++y)
           {
             const Idx r = static_cast<Idx>(max_row) - (ro + y + 1);
-            const Idx c = static_cast<Idx>(min_column) + co + x;
-            const Location idx(r, c);
-            // might be out of bounds if not divisible by number of tiles
-            if (!(this->rows() <= r
-                  || 0 > r
-                  || this->columns() <= c
-                  || 0 > c))
+            for (size_t x = 0; x < tileWidth; ++x)
             {
-              // HACK: was getting invalid rasters if assigning directly into buf
-              const R value = convert(this->at(idx));
-              buf[x + y * tileWidth] = value;
+              const Idx c = static_cast<Idx>(min_column) + co + x;
+              // might be out of bounds if not divisible by number of tiles
+              if (!(this->rows() <= r
+                    || 0 > r
+                    || this->columns() <= c
+                    || 0 > c))
+              {
+                put(tile, co + x, ro + y, convert(this->at(Location(r, c))));
+              }
             }
           }
         }
-        logging::check_fatal(TIFFWriteTile(tif, buf, co, ro, 0, 0) < 0, "Cannot write tile to %s", filename.c_str());
+        if (nodata_tile == tile)
+        {
+          tile.clear();
+        }
+      });
+    const auto is_cog = tbd::sim::Settings::saveAsCog();
+    // compression is the expensive part, so do tiles in parallel and then write them in order
+    auto compressed = compress_tiles(compression, predictor, sizeof(R), tileWidth, tiles);
+    // overviews are made after so they use the same bounded set of threads as full resolution
+    vector<TileLevel> levels{};
+    if (is_cog)
+    {
+      TileLevel last{};
+      const TileLevel* from = &image;
+      while (from->tiles_across > 1 || from->tiles_down > 1)
+      {
+        auto next = reduce_level<R>(*from, tileWidth, tileHeight, no_data, reduction);
+        levels.push_back({next.width,
+                          next.height,
+                          next.tiles_across,
+                          next.tiles_down,
+                          compress_tiles(compression, predictor, sizeof(R), tileWidth, next.tiles)});
+        last = std::move(next);
+        from = &last;
+      }
+    }
+    const auto write_tiles = [&filename](TIFF* out, vector<vector<uint8_t>>& level) {
+      size_t written = 0;
+      for (size_t i = 0; i < level.size(); ++i)
+      {
+        // tiles that aren't written are treated as nodata by readers of sparse files
+        if (!level[i].empty())
+        {
+          logging::check_fatal(TIFFWriteRawTile(out, static_cast<uint32_t>(i), level[i].data(), static_cast<tmsize_t>(level[i].size())) < 0,
+                               "Cannot write tile to %s",
+                               filename.c_str());
+          ++written;
+        }
+      }
+      return written;
+    };
+    if (is_cog)
+    {
+      // directories go at the start of the file so readers can find everything with one request,
+      // which means tile offsets and sizes need to be written after the tiles are
+      GTIFWriteKeys(gtif);
+      const auto write_directory = [&]() {
+        logging::check_fatal(!TIFFDeferStrileArrayWriting(tif)
+                               || !TIFFWriteCheck(tif, 1, "saveToTiffFile")
+                               || !TIFFWriteDirectory(tif),
+                             "Cannot write directory to %s",
+                             filename.c_str());
+      };
+      write_directory();
+      for (const auto& level : levels)
+      {
+        set_fields(level.width, level.height);
+        TIFFSetField(tif, TIFFTAG_SUBFILETYPE, FILETYPE_REDUCEDIMAGE);
+        write_directory();
+      }
+      // reserve space for tile offsets and sizes right after the directories
+      for (size_t k = 0; k <= levels.size(); ++k)
+      {
+        logging::check_fatal(!TIFFSetDirectory(tif, static_cast<tdir_t>(k))
+                               || !TIFFForceStrileArrayWriting(tif),
+                             "Cannot write tile offsets to %s",
+                             filename.c_str());
+      }
+      if (gtif)
+      {
+        GTIFFree(gtif);
       }
+      TIFFClose(tif);
+      // if libtiff defers loading offsets then it updates them in place when tiles are written
+      tif = GeoTiffOpen(filename.c_str(), "r+D");
+      logging::check_fatal(!tif, "Cannot open file %s to write tiles", filename.c_str());
+      // smallest overview goes first so it can be read along with the directories
+      for (auto k = levels.size(); k > 0; --k)
+      {
+        logging::check_fatal(!TIFFSetDirectory(tif, static_cast<tdir_t>(k)),
+                             "Cannot find overview in %s",
+                             filename.c_str());
+        write_tiles(tif, levels[k - 1].tiles);
+        logging::check_fatal(!TIFFFlush(tif), "Cannot write tile offsets to %s", filename.c_str());
+      }
+      logging::check_fatal(!TIFFSetDirectory(tif, 0), "Cannot find image in %s", filename.c_str());
+    }
+    const auto written = write_tiles(tif, compressed);
+    if (0 == written)
+    {
+      // don't leave file without any tile data at all
+      auto tile = nodata_tile;
+      auto data = compress_tile(compression, predictor, sizeof(R), tileWidth, tile);
+      logging::check_fatal(TIFFWriteRawTile(tif, 0, data.data(), static_cast<tmsize_t>(data.size())) < 0,
+                           "Cannot write tile to %s",
+                           filename.c_str());
     }
-    GTIFWriteKeys(gtif);
-    if (gtif)
+    logging::extensive("Wrote %ld of %ld tiles to %s", written, tiles.size(), filename.c_str());
+    if (!is_cog)
     {
-      GTIFFree(gtif);
+      GTIFWriteKeys(gtif);
+      if (gtif)
+      {
+        GTIFFree(gtif);
+      }
     }
-    _TIFFfree(buf);
     TIFFClose(tif);
     return filename;
   }
@@ -778,12 +1091,14 @@ public:
    * \param base_name File base name to use
    * \param convert Function to convert from V to R
    * \param no_data Value to use as nodata in output
+   * \param reduction How to combine pixels for overviews if saving as COG
    */
   template <class R>
   string saveToFileWithoutRetry(const string& dir,
                                 const string& base_name,
                                 std::function<R(T value)> convert,
-                                const R no_data) const
+                                const R no_data,
+                                const OverviewReduction reduction) const
   {
     // NOTE: do this instead of function pointer because it's using templates
     if (tbd::sim::Settings::saveAsAscii())
@@ -800,7 +1115,8 @@ public:
         dir,
         base_name,
         convert,
-        no_data);
+        no_data,
+        reduction);
     }
   }
   /**
@@ -810,18 +1126,20 @@ public:
    * \param base_name File base name to use
    * \param convert Function to convert from V to R
    * \param no_data Value to use as nodata in output
+   * \param reduction How to combine pixels for overviews if saving as COG
    */
   template <class R>
   string saveToFileWithRetry(const string& dir,
                              const string& base_name,
                              std::function<R(T value)> convert,
-                             const R no_data) const
+                             const R no_data,
+                             const OverviewReduction reduction) const
   {
     // HACK: (hopefully) ensure that write works
     try
     {
       // HACK: use different function name to prevent infinite recursion warning
-      return this->template saveToFileWithoutRetry<R>(dir, base_name, convert, no_data);
+      return this->template saveToFileWithoutRetry<R>(dir, base_name, convert, no_data, reduction);
     }
     catch (const std::exception& err)
     {
@@ -831,7 +1149,7 @@ public:
                      err.what());
       try
       {
-        return this->template saveToFileWithoutRetry<R>(dir, base_name, convert, no_data);
+        return this->template saveToFileWithoutRetry<R>(dir, base_name, convert, no_data, reduction);
       }
       catch (const std::exception& err_fatal)
       {
@@ -851,14 +1169,16 @@ public:
    * \param base_name File base name to use
    * \param convert Function to convert from V to R
    * \param no_data Value to use as nodata in output
+   * \param reduction How to combine pixels for overviews if saving as COG
    */
   template <class R>
   string saveToFile(const string& dir,
                     const string& base_name,
                     std::function<R(T value)> convert,
-                    const R no_data) const
+                    const R no_data,
+                    const OverviewReduction reduction = OverviewReduction::Mode) const
   {
-    return this->template saveToFileWithRetry<R>(dir, base_name, convert, no_data);
+    return this->template saveToFileWithRetry<R>(dir, base_name, convert, no_data, reduction);
   }
   /**
    * \brief Save GridMap contents to file based on settings
@@ -866,28 +1186,34 @@ public:
    * \param dir Directory to save into
    * \param base_name File base name to use
    * \param convert Function to convert from V to R
+   * \param reduction How to combine pixels for overviews if saving as COG
    */
   template <class R>
   string saveToFile(const string& dir,
                     const string& base_name,
-                    std::function<R(T value)> convert) const
+                    std::function<R(T value)> convert,
+                    const OverviewReduction reduction = OverviewReduction::Mode) const
   {
-    return this->template saveToFile<R>(dir, base_name, convert, static_cast<R>(this->nodataInput()));
+    return this->template saveToFile<R>(dir, base_name, convert, static_cast<R>(this->nodataInput()), reduction);
   }
   /**
    * \brief Save GridMap contents to file based on settings
    * \param dir Directory to save into
    * \param base_name File base name to use
+   * \param reduction How to combine pixels for overviews if saving as COG
    */
   template <class R = V>
-  string saveToFile(const string& dir, const string& base_name) const
+  string saveToFile(const string& dir,
+                    const string& base_name,
+                    const OverviewReduction reduction = OverviewReduction::Mode) const
   {
     return this->template saveToFile<R>(
       dir,
       base_name,
       [](T value) -> R {
         return static_cast<R>(value);
-      });
+      },
+      reduction);
   }
 };
 }
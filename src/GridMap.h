@@ -63,8 +63,19 @@ public:
   void set(const Location& location, const T value) override
   {
     this->data[location] = value;
+    include(location);
     assert(at(location) == value);
   }
+  /**
+   * \brief Add to value at Location, where Locations without a value start at 0
+   * \param location Location to add to
+   * \param value Amount to add
+   */
+  void add(const Location& location, const T value)
+  {
+    this->data[location] += value;
+    include(location);
+  }
   template <class P>
   void set(const Position<P>& position, const T value)
   {
@@ -172,7 +183,11 @@ public:
    * \param rhs GridMap to move from
    */
   GridMap(GridMap&& rhs) noexcept
-    : GridData<T, V, map<Location, T>>(std::move(rhs))
+    : GridData<T, V, map<Location, T>>(std::move(rhs)),
+      min_row_(rhs.min_row_),
+      max_row_(rhs.max_row_),
+      min_column_(rhs.min_column_),
+      max_column_(rhs.max_column_)
   {
     this->data = std::move(rhs.data);
   }
@@ -181,7 +196,11 @@ public:
    * \param rhs GridMap to copy from
    */
   GridMap(const GridMap& rhs)
-    : GridData<T, V, map<Location, T>>(rhs)
+    : GridData<T, V, map<Location, T>>(rhs),
+      min_row_(rhs.min_row_),
+      max_row_(rhs.max_row_),
+      min_column_(rhs.min_column_),
+      max_column_(rhs.max_column_)
   {
     this->data = rhs.data;
   }
@@ -195,6 +214,7 @@ public:
     if (this != &rhs)
     {
       this->data = std::move(rhs.data);
+      copyBounds(rhs);
     }
     return *this;
   }
@@ -208,6 +228,7 @@ public:
     if (this != &rhs)
     {
       this->data = rhs.data;
+      copyBounds(rhs);
     }
     return *this;
   }
@@ -218,24 +239,28 @@ public:
   {
     //    this->data.clear();
     this->data = {};
+    min_row_ = numeric_limits<Idx>::max();
+    max_row_ = 0;
+    min_column_ = numeric_limits<Idx>::max();
+    max_column_ = 0;
     //    this->data.reserve(static_cast<size_t>(numeric_limits<Idx>::max() / 4));
   }
 protected:
-  tuple<Idx, Idx, Idx, Idx> dataBounds() const override
+  bool forEachValue(const function<void(const Location&, T)>& fct) const override
   {
-    Idx min_row = this->rows();
-    Idx max_row = 0;
-    Idx min_column = this->columns();
-    Idx max_column = 0;
     for (const auto& kv : this->data)
     {
-      const Idx r = kv.first.row();
-      const Idx c = kv.first.column();
-      min_row = min(min_row, r);
-      max_row = max(max_row, r);
-      min_column = min(min_column, c);
-      max_column = max(max_column, c);
+      fct(kv.first, kv.second);
     }
+    return true;
+  }
+  tuple<Idx, Idx, Idx, Idx> dataBounds() const override
+  {
+    // bounds are kept up to date as values are set so there's no need to look at data
+    auto min_row = min_row_;
+    auto max_row = max_row_;
+    auto min_column = min_column_;
+    auto max_column = max_column_;
     // do this so that we take the center point when there's no data since it should
     // stay the same if the grid is centered on the fire
     if (min_row > max_row)
@@ -267,7 +292,7 @@ public:
     auto div = [divisor](T value) -> R {
       return static_cast<R>(value / divisor);
     };
-    return this->template saveToFile<R>(dir, base_name, div);
+    return this->template saveToFile<R>(dir, base_name, div, OverviewReduction::Average);
   }
   /**
    * \brief Calculate area for cells that have a value (ha)
@@ -329,5 +354,46 @@ public:
                    [](const pair<const Location, const T>& kv) { return kv.first; });
     return result;
   }
+private:
+  /**
+   * \brief Expand bounds to include Location
+   * \param location Location to include
+   */
+  void include(const Location& location) noexcept
+  {
+    const Idx r = location.row();
+    const Idx c = location.column();
+    min_row_ = min(min_row_, r);
+    max_row_ = max(max_row_, r);
+    min_column_ = min(min_column_, c);
+    max_column_ = max(max_column_, c);
+  }
+  /**
+   * \brief Use bounds from another GridMap
+   * \param rhs GridMap to use bounds from
+   */
+  void copyBounds(const GridMap& rhs) noexcept
+  {
+    min_row_ = rhs.min_row_;
+    max_row_ = rhs.max_row_;
+    min_column_ = rhs.min_column_;
+    max_column_ = rhs.max_column_;
+  }
+  /**
+   * \brief Lowest row that has a value, or more than max_row_ if there are none
+   */
+  Idx min_row_{numeric_limits<Idx>::max()};
+  /**
+   * \brief Highest row that has a value
+   */
+  Idx max_row_{0};
+  /**
+   * \brief Lowest column that has a value, or more than max_column_ if there are none
+   */
+  Idx min_column_{numeric_limits<Idx>::max()};
+  /**
+   * \brief Highest column that has a value
+   */
+  Idx max_column_{0};
 };
 }
@@ -4,6 +4,7 @@
 
 #pragma once
 #include "stdafx.h"
+#include <memory_resource>
 #include "Cell.h"
 
 namespace tbd
@@ -46,7 +47,16 @@ public:
   using BoundedPoint<DistanceSize, -1, 1, -1, 1>::BoundedPoint;
 };
 using ROSOffset = std::tuple<IntensitySize, ROSSize, Direction, Offset>;
-using OffsetSet = vector<ROSOffset>;
+using OffsetSet = std::pmr::vector<ROSOffset>;
+/**
+ * \brief Index just past the last offset in a group that was calculated together, and
+ * whether no more offsets are calculated after it if none in the group spread
+ */
+using OffsetGroup = pair<size_t, bool>;
+/**
+ * \brief Collection of OffsetGroups in the order they were calculated
+ */
+using OffsetGroups = vector<OffsetGroup>;
 }
 namespace tbd::sim
 {
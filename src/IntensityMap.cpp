@@ -12,23 +12,23 @@ namespace tbd::sim
 
 // FIX: maybe this can be more generic but just want to keep allocated objects and reuse them
 template <class K>
-class GridMapCache
+class TiledGridCache
 {
 public:
-  GridMapCache(K nodata)
+  TiledGridCache(K nodata)
     : nodata_(nodata)
   {
   }
   // // use maximum value as nodata if not given
   // // HACK: need to be able to convert to int, so don't use a value bigger than that can hold
-  // GridMapCache()
-  //   : GridMapCache(
+  // TiledGridCache()
+  //   : TiledGridCache(
   //       static_cast<K>(
   //         min(static_cast<long double>(std::numeric_limits<int>::max()),
   //             static_cast<long double>(std::numeric_limits<K>::max()))))
   // {
   // }
-  void release_map(unique_ptr<data::GridMap<K>> map) noexcept
+  void release_map(unique_ptr<data::TiledGrid<K>> map) noexcept
   {
     map->clear();
     try
@@ -42,7 +42,7 @@ public:
       std::terminate();
     }
   }
-  unique_ptr<data::GridMap<K>> acquire_map(const Model& model) noexcept
+  unique_ptr<data::TiledGrid<K>> acquire_map(const Model& model) noexcept
   {
     try
     {
@@ -53,7 +53,7 @@ public:
         maps_.pop_back();
         return result;
       }
-      return model.environment().makeMap<K>(nodata_);
+      return model.environment().makeTiledGrid<K>(nodata_);
     }
     catch (const std::exception& ex)
     {
@@ -61,15 +61,20 @@ public:
       std::terminate();
     }
   }
+  void clear() noexcept
+  {
+    lock_guard<mutex> lock(mutex_);
+    maps_.clear();
+  }
 protected:
   K nodata_;
-  vector<unique_ptr<data::GridMap<K>>> maps_;
+  vector<unique_ptr<data::TiledGrid<K>>> maps_;
   mutex mutex_;
 };
 
-static auto CacheIntensitySize = GridMapCache<IntensitySize>(NO_INTENSITY);
-static auto CacheMathSize = GridMapCache<MathSize>(-1);
-static auto CacheDegreesSize = GridMapCache<DegreesSize>(-1);
+static auto CacheIntensitySize = TiledGridCache<IntensitySize>(NO_INTENSITY);
+static auto CacheMathSize = TiledGridCache<MathSize>(-1);
+static auto CacheDegreesSize = TiledGridCache<DegreesSize>(-1);
 
 // IntensityMap::IntensityMap(const Model& model, topo::Perimeter* perimeter) noexcept
 //   : model_(model),
@@ -106,6 +111,13 @@ IntensityMap::IntensityMap(const Model& model) noexcept
 {
 }
 
+void IntensityMap::clearCache() noexcept
+{
+  CacheIntensitySize.clear();
+  CacheMathSize.clear();
+  CacheDegreesSize.clear();
+}
+
 IntensityMap::IntensityMap(const IntensityMap& rhs)
   // : IntensityMap(rhs.model_, nullptr)
   : IntensityMap(rhs.model_)
@@ -220,7 +232,7 @@ void IntensityMap::burn(const Location& location,
     intensity_max_->set(location, intensity);
     rate_of_spread_at_max_->set(location, ros);
     direction_of_spread_at_max_->set(location, static_cast<DegreesSize>(raz.asDegrees()));
-    (*is_burned_).set(location.hash());
+    is_burned_->set(location.hash());
   }
   else
   {
@@ -256,26 +268,17 @@ void IntensityMap::save(const string& dir, const string& base_name) const
   //   return static_cast<DegreesSize>(raz.asDegrees());
   // };
   // FIX: already done in IntensityObserver?
-  intensity_max_->saveToFile(dir, name_intensity);
+  intensity_max_->saveToFile(dir, name_intensity, data::OverviewReduction::Average);
   // // HACK: writing a double to a tiff seems to not work?
   // double is way too much precision for outputs
-  rate_of_spread_at_max_->saveToFile<float>(dir, name_ros);
+  rate_of_spread_at_max_->saveToFile<float>(dir, name_ros, data::OverviewReduction::Average);
   // rate_of_spread_at_max_->saveToFile(dir, name_ros);
-  direction_of_spread_at_max_->saveToFile(dir, name_raz);
+  // averaging directions is wrong where they wrap past north
+  direction_of_spread_at_max_->saveToFile(dir, name_raz, data::OverviewReduction::Mode);
 }
 MathSize IntensityMap::fireSize() const
 {
   lock_guard<mutex> lock(mutex_);
   return intensity_max_->fireSize();
 }
-map<Location, IntensitySize>::const_iterator
-  IntensityMap::cend() const noexcept
-{
-  return intensity_max_->data.cend();
-}
-map<Location, IntensitySize>::const_iterator
-  IntensityMap::cbegin() const noexcept
-{
-  return intensity_max_->data.cbegin();
-}
 }
@@ -5,8 +5,8 @@
 #pragma once
 #include <memory>
 #include <string>
-#include <bitset>
-#include "GridMap.h"
+#include "BurnedData.h"
+#include "TiledGrid.h"
 #include "Location.h"
 namespace tbd
 {
@@ -20,7 +20,6 @@ namespace sim
 using tbd::topo::Position;
 class ProbabilityMap;
 class Model;
-using BurnedData = std::bitset<static_cast<size_t>(MAX_ROWS) * MAX_COLUMNS>;
 /**
  * \brief Represents a map of intensities that cells have burned at for a single Scenario.
  */
@@ -43,6 +42,13 @@ public:
   // IntensityMap(IntensityMap&& rhs);
   IntensityMap& operator=(const IntensityMap& rhs) = delete;
   IntensityMap& operator=(IntensityMap&& rhs) noexcept = delete;
+  /**
+   * \brief Drop grids kept for reuse so the next ones use the current Environment
+   *
+   * Must be called when a different Environment is loaded in the same process
+   * and no IntensityMap for the previous one is still alive.
+   */
+  static void clearCache() noexcept;
   /**
    * \brief Number of rows in this extent
    * \return Number of rows in this extent
@@ -143,17 +149,14 @@ public:
    */
   [[nodiscard]] MathSize fireSize() const;
   /**
-   * \brief Iterator for underlying GridMap
-   * \return Iterator for underlying GridMap
-   */
-  [[nodiscard]] map<Location, IntensitySize>::const_iterator
-    cbegin() const noexcept;
-  /**
-   * \brief Iterator for underlying GridMap
-   * \return Iterator for underlying GridMap
+   * \brief Call function with every Location that has burned and its intensity
+   * \param fct Function to call with Location and intensity
    */
-  [[nodiscard]] map<Location, IntensitySize>::const_iterator
-    cend() const noexcept;
+  template <class F>
+  void forEach(F fct) const
+  {
+    intensity_max_->forEach(fct);
+  }
 private:
   /**
    * \brief Model map is for
@@ -162,15 +165,15 @@ private:
   /**
    * \brief Map of intensity that cells have burned  at
    */
-  unique_ptr<data::GridMap<IntensitySize>> intensity_max_;
+  unique_ptr<data::TiledGrid<IntensitySize>> intensity_max_;
   // HACK: just add ROS/RAZ into this object for now
   /**
    * \brief Map of rate of spread/direction that cells have burned with at max ros
    */
-  unique_ptr<data::GridMap<MathSize>> rate_of_spread_at_max_;
-  unique_ptr<data::GridMap<DegreesSize>> direction_of_spread_at_max_;
+  unique_ptr<data::TiledGrid<MathSize>> rate_of_spread_at_max_;
+  unique_ptr<data::TiledGrid<DegreesSize>> direction_of_spread_at_max_;
   /**
-   * \brief bitset denoting cells that can no longer burn
+   * \brief BurnedData denoting cells that can no longer burn
    */
   BurnedData* is_burned_;
 };
@@ -11,6 +11,7 @@
  */
 #include "stdafx.h"
 #include <chrono>
+#include "EnvironmentCache.h"
 #include "Model.h"
 #include "Scenario.h"
 #include "Test.h"
@@ -20,6 +21,8 @@
 #include "SpreadAlgorithm.h"
 #include "Util.h"
 #include "FireWeather.h"
+#include "WeatherReader.h"
+#include "Batch.h"
 using tbd::logging::Log;
 using tbd::sim::Settings;
 using tbd::AspectSize;
@@ -51,7 +54,10 @@ enum MODE
 {
   SIMULATION,
   TEST,
-  SURFACE
+  SURFACE,
+  PREPROCESS,
+  CONVERT_WX,
+  BATCH
 };
 string get_args()
 {
@@ -79,8 +85,15 @@ void show_usage_and_exit(int exit_code)
   printf("Run simulations and save output in the specified directory\n\n\n");
   printf("Usage: %s surface <output_dir> <yyyy-mm-dd> <lat> <lon> <HH:MM> [options]\n\n", BIN_NAME);
   printf("Calculate probability surface and save output in the specified directory\n\n\n");
+  printf("Usage: %s batch <output_dir> <manifest.csv> [options]\n\n", BIN_NAME);
+  printf("Run simulations for each ignition in manifest (lat,lon,date,time,output_dir,perim,size) and save log in the specified directory\n");
+  printf(" Fires run one at a time, but nearby fires reuse loaded rasters and weather\n\n\n");
   printf("Usage: %s test <output_dir> [options]\n\n", BIN_NAME);
   printf(" Run test cases and save output in the specified directory\n\n");
+  printf("Usage: %s preprocess <output_dir> [options]\n\n", BIN_NAME);
+  printf(" Preprocess rasters in raster root so simulations load faster and save log in the specified directory\n\n");
+  printf("Usage: %s convert-wx <output_dir> <weather.csv> <weather.bin> [options]\n\n", BIN_NAME);
+  printf(" Convert hourly weather .csv to binary weather that loads faster and save log in the specified directory\n\n");
   printf(" Input Options\n");
   // FIX: this should show arguments specific to mode, but it doesn't indicate that on the outputs
   for (auto& kv : PARSE_HELP)
@@ -308,11 +321,34 @@ int main(const int argc, const char* const argv[])
     register_flag(&Settings::setForceGreenup, true, "--force-greenup", "Force green up for all fires");
     register_flag(&Settings::setForceNoGreenup, true, "--force-no-greenup", "Force no green up for all fires");
   }
+  else if (ARGC > 1 && 0 == strcmp(ARGV[1], "preprocess"))
+  {
+    tbd::logging::note("Running in preprocess mode");
+    mode = PREPROCESS;
+    CUR_ARG += 1;
+    SKIPPED_ARGS = 1;
+    register_setter<const char*>(&Settings::setRasterRoot, "--raster-root", "Use specified directory as raster root", false, &parse_raw);
+    register_setter<const char*>(&Settings::setFuelLookupTable, "--fuel-lut", "Use specified fuel lookup table", false, &parse_raw);
+    register_setter<string>(log_file_name, "--log", "Output log file", false, &parse_string);
+  }
+  else if (ARGC > 1 && 0 == strcmp(ARGV[1], "convert-wx"))
+  {
+    tbd::logging::note("Running in weather conversion mode");
+    mode = CONVERT_WX;
+    CUR_ARG += 1;
+    SKIPPED_ARGS = 1;
+    register_setter<string>(log_file_name, "--log", "Output log file", false, &parse_string);
+  }
   else
   {
     register_flag(&Settings::setSaveIndividual, true, "-i", "Save individual maps for simulations");
     register_flag(&Settings::setRunAsync, false, "-s", "Run in synchronous mode");
+    register_flag(&Settings::setParallelSpread, true, "--parallel-spread", "Spread each simulation using multiple threads");
+    register_setter<MathSize>(&Settings::setMaximumDailySpread, "--max-daily-spread", "Worst case spread distance per day (m) used to shrink simulation window, which doesn't grow if fire reaches its edge (default 0 for largest window)", false, &parse_value<MathSize>);
     register_flag(&Settings::setSaveAsAscii, true, "--ascii", "Save grids as .asc");
+    register_flag(&Settings::setSaveAsCog, true, "--cog", "Save grids as Cloud Optimized GeoTIFFs with overviews");
+    register_setter<const char*>(&Settings::setTiffCompression, "--tiff-compression", "Compression for .tif grids (lzw, deflate, zstd)", false, &parse_raw);
+    register_setter<const char*>(&Settings::setTiffPredictor, "--tiff-predictor", "Predictor for .tif grids (none, horizontal, floatingpoint), where integer grids use horizontal instead of floatingpoint (default none)", false, &parse_raw);
     register_flag(&Settings::setSavePoints, true, "--points", "Save simulation points to file");
     register_flag(&Settings::setSaveIntensity, false, "--no-intensity", "Do not output intensity grids");
     register_flag(&Settings::setSaveProbability, false, "--no-probability", "Do not output probability grids");
@@ -346,12 +382,24 @@ int main(const int argc, const char* const argv[])
     }
     else
     {
-      register_setter<string>(wx_file_name, "--wx", "Input weather file", true, &parse_string);
+      if (ARGC > 1 && 0 == strcmp(ARGV[1], "batch"))
+      {
+        tbd::logging::note("Running in batch mode");
+        mode = BATCH;
+        // skip 'batch' argument if present
+        CUR_ARG += 1;
+        SKIPPED_ARGS = 1;
+      }
+      register_setter<string>(wx_file_name, "--wx", "Input weather file (.csv or binary from convert-wx)", true, &parse_string);
       register_flag(&Settings::setDeterministic, true, "--deterministic", "Run deterministically (100% chance of spread & survival)");
       register_setter<size_t>(&Settings::setStaticCuring, "--curing", "Specify static grass curing", false, &parse_size_t);
       register_setter<ThresholdSize>(&Settings::setConfidenceLevel, "--confidence", "Use specified confidence level", false, &parse_value<ThresholdSize>);
-      register_setter<string>(perim, "--perim", "Start from perimeter", false, &parse_string);
-      register_setter<size_t>(size, "--size", "Start from size", false, &parse_size_t);
+      if (BATCH != mode)
+      {
+        // batch has these for each ignition in the manifest
+        register_setter<string>(perim, "--perim", "Start from perimeter", false, &parse_string);
+        register_setter<size_t>(size, "--size", "Start from size", false, &parse_size_t);
+      }
       // HACK: want different text for same flag so define here too
       register_index<Ffmc>(ffmc, "--ffmc", "Startup Fine Fuel Moisture Code", true);
       register_index<Dmc>(dmc, "--dmc", "Startup Duff Moisture Code", true);
@@ -474,7 +522,54 @@ int main(const int argc, const char* const argv[])
                               log_file.c_str());
     tbd::logging::note("Output directory is %s", dir_out);
     tbd::logging::note("Output log is %s", log_file.c_str());
-    if (mode != TEST)
+    if (mode == PREPROCESS)
+    {
+      done_positional();
+      log_args();
+      const auto num_rasters = tbd::topo::EnvironmentCache::createAll(Settings::rasterRoot());
+      tbd::logging::note("Preprocessed %ld rasters in %s", num_rasters, Settings::rasterRoot());
+      result = 0;
+      Log::closeLogFile();
+    }
+    else if (mode == CONVERT_WX)
+    {
+      const auto csv_file = get_positional();
+      const auto bin_file = get_positional();
+      done_positional();
+      log_args();
+      const auto scenarios = tbd::wx::read_weather_csv(csv_file);
+      tbd::wx::write_weather_binary(bin_file, scenarios);
+      tbd::logging::note("Wrote %ld scenarios to %s", scenarios.size(), bin_file.c_str());
+      result = 0;
+      Log::closeLogFile();
+    }
+    else if (mode == BATCH)
+    {
+      const auto manifest = get_positional();
+      done_positional();
+      if (!PARSE_HAVE.contains("--apcp_prev"))
+      {
+        tbd::logging::warning("Assuming 0 precipitation between noon yesterday and weather start for startup indices");
+        apcp_prev = Precipitation::Zero;
+      }
+      // HACK: ISI for yesterday really doesn't matter so just use any wind
+      const auto yesterday = FwiWeather(Temperature::Zero,
+                                        RelativeHumidity::Zero,
+                                        Wind(Direction(wind_direction, false), Speed(wind_speed)),
+                                        Precipitation(apcp_prev),
+                                        ffmc,
+                                        dmc,
+                                        dc);
+      log_args();
+      const auto ignitions = tbd::sim::read_ignitions(manifest);
+      tbd::logging::note("Read %ld ignitions from %s", ignitions.size(), manifest.c_str());
+      result = tbd::sim::Model::runBatch(ignitions,
+                                         wx_file_name.c_str(),
+                                         yesterday,
+                                         Settings::rasterRoot());
+      Log::closeLogFile();
+    }
+    else if (mode != TEST)
     {
       // handle surface/simulation positional arguments
       // positional arguments should be:
@@ -0,0 +1,59 @@
+/* Copyright (c) His Majesty the King in Right of Canada as represented by the Minister of Natural Resources, 2024. */
+
+/* SPDX-License-Identifier: AGPL-3.0-or-later */
+
+#include "stdafx.h"
+#include "MappedFile.h"
+#include "Log.h"
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+namespace tbd::util
+{
+#ifdef _WIN32
+MappedFile::MappedFile(const std::string& filename)
+  : data_(nullptr),
+    size_(0)
+{
+  // HACK: just read the whole file since this isn't used much on Windows
+  ifstream in(filename, std::ios::binary | std::ios::ate);
+  logging::check_fatal(!in.good(), "Unable to open file %s", filename.c_str());
+  contents_.resize(static_cast<size_t>(in.tellg()));
+  in.seekg(0);
+  in.read(contents_.data(), static_cast<std::streamsize>(contents_.size()));
+  data_ = contents_.data();
+  size_ = contents_.size();
+}
+MappedFile::~MappedFile() = default;
+#else
+MappedFile::MappedFile(const std::string& filename)
+  : data_(nullptr),
+    size_(0)
+{
+  const auto fd = open(filename.c_str(), O_RDONLY);
+  logging::check_fatal(-1 == fd, "Unable to open file %s", filename.c_str());
+  struct stat info
+  {
+  };
+  logging::check_fatal(0 != fstat(fd, &info), "Unable to determine size of %s", filename.c_str());
+  size_ = static_cast<size_t>(info.st_size);
+  if (0 < size_)
+  {
+    const auto mapped = mmap(nullptr, size_, PROT_READ, MAP_SHARED, fd, 0);
+    logging::check_fatal(MAP_FAILED == mapped, "Unable to map file %s into memory", filename.c_str());
+    data_ = static_cast<const char*>(mapped);
+  }
+  // mapping stays valid after descriptor is closed
+  close(fd);
+}
+MappedFile::~MappedFile()
+{
+  if (nullptr != data_)
+  {
+    munmap(const_cast<char*>(data_), size_);
+  }
+}
+#endif
+}
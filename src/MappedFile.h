@@ -0,0 +1,73 @@
+/* Copyright (c) His Majesty the King in Right of Canada as represented by the Minister of Natural Resources, 2024. */
+
+/* SPDX-License-Identifier: AGPL-3.0-or-later */
+
+#pragma once
+#include <cstddef>
+#include <string>
+#include <vector>
+namespace tbd::util
+{
+/**
+ * \brief A file that is mapped into memory as read-only.
+ *
+ * Pages are only read when they are used, and processes that map the same file
+ * share the same physical memory for it.
+ */
+class MappedFile
+{
+public:
+  /**
+   * \brief Map the given file into memory
+   * \param filename File to map
+   */
+  explicit MappedFile(const std::string& filename);
+  ~MappedFile();
+  MappedFile(const MappedFile& rhs) = delete;
+  MappedFile(MappedFile&& rhs) = delete;
+  MappedFile& operator=(const MappedFile& rhs) = delete;
+  MappedFile& operator=(MappedFile&& rhs) = delete;
+  /**
+   * \brief Start of file contents
+   * \return Start of file contents
+   */
+  [[nodiscard]] const char* data() const noexcept
+  {
+    return data_;
+  }
+  /**
+   * \brief Size of file (bytes)
+   * \return Size of file (bytes)
+   */
+  [[nodiscard]] size_t size() const noexcept
+  {
+    return size_;
+  }
+  /**
+   * \brief Value of type T at offset in file
+   * \tparam T Type of value
+   * \param offset Offset in file (bytes)
+   * \return Pointer to value at offset
+   */
+  template <class T>
+  [[nodiscard]] const T* at(const size_t offset) const noexcept
+  {
+    return reinterpret_cast<const T*>(data_ + offset);
+  }
+private:
+  /**
+   * \brief Start of file contents
+   */
+  const char* data_;
+  /**
+   * \brief Size of file (bytes)
+   */
+  size_t size_;
+#ifdef _WIN32
+  /**
+   * \brief File contents, since this just reads the file on Windows
+   */
+  std::vector<char> contents_;
+#endif
+};
+}
@@ -13,6 +13,10 @@
 #include "ProbabilityMap.h"
 #include "FireWeatherDaily.h"
 #include "ConstantWeather.h"
+#include "WorkerPool.h"
+#include "WeatherReader.h"
+#include "SurvivalCache.h"
+#include "Batch.h"
 namespace tbd::sim
 {
 #ifdef DEBUG_WEATHER
@@ -107,199 +111,121 @@ void Model::readWeather(const wx::FwiWeather& yesterday,
 {
   map<size_t, vector<const wx::FwiWeather*>*> wx{};
   map<size_t, map<Day, wx::FwiWeather>> wx_daily{};
-  map<Day, struct tm> dates{};
   Day min_date = numeric_limits<Day>::max();
   Day max_date = numeric_limits<Day>::min();
-  time_t prev_time = numeric_limits<time_t>::min();
-  ifstream in;
-  in.open(filename);
-  logging::check_fatal(!in.is_open(),
-                       "Could not open input weather file %s",
-                       filename.c_str());
-  if (in.is_open())
+  logging::info("Reading scenarios from '%s'", filename.c_str());
+  auto scenarios = wx::read_weather(filename);
+  for (const auto& s : scenarios)
   {
+    for (const auto& t : s.times)
+    {
+      min_date = min(min_date, t.day);
+      max_date = max(max_date, t.day);
+    }
+    if (!s.times.empty())
+    {
+      year_ = s.times.back().year;
+    }
+  }
 #ifndef NDEBUG
-    const auto file_out = string(dir_out_) + "/wx_hourly_out_read.csv";
-    FILE* out = fopen(file_out.c_str(), "w");
-    logging::check_fatal(nullptr == out, "Cannot open file %s for output", file_out.c_str());
-    fprintf(out, "Scenario,Date,PREC,TEMP,RH,WS,WD,FFMC,DMC,DC,ISI,BUI,FWI\r\n");
+  const auto file_out = string(dir_out_) + "/wx_hourly_out_read.csv";
+  FILE* out = fopen(file_out.c_str(), "w");
+  logging::check_fatal(nullptr == out, "Cannot open file %s for output", file_out.c_str());
+  fprintf(out, "Scenario,Date,PREC,TEMP,RH,WS,WD,FFMC,DMC,DC,ISI,BUI,FWI\r\n");
 #endif
-    string str;
-    logging::info("Reading scenarios from '%s'", filename.c_str());
-    // read header line
-    getline(in, str);
-    // get rid of whitespace
-    str.erase(std::remove(str.begin(), str.end(), ' '), str.end());
-    str.erase(std::remove(str.begin(), str.end(), '\n'), str.end());
-    str.erase(std::remove(str.begin(), str.end(), '\r'), str.end());
-    constexpr auto expected_header =
-      "Scenario,Date,PREC,TEMP,RH,WS,WD,FFMC,DMC,DC,ISI,BUI,FWI";
-    logging::check_fatal(expected_header != str,
-                         "Input CSV must have columns in this order:\n'%s'\n but got:\n'%s'",
-                         expected_header,
-                         str.c_str());
+  // HACK: can be up until rest of year since start date
+  const size_t num_hours = (static_cast<size_t>(max_date) - min_date + 1) * DAY_HOURS;
+  for (auto& s : scenarios)
+  {
+    const auto cur = s.id;
+    logging::check_fatal(wx_daily.find(cur) != wx_daily.end(),
+                         "Somehow have daily weather for scenario %ld before hourly weather",
+                         cur);
+    auto by_hour = new vector<const wx::FwiWeather*>(num_hours, nullptr);
+    wx.emplace(cur, by_hour);
+    auto& s_daily = wx_daily.emplace(cur, map<Day, wx::FwiWeather>()).first->second;
     auto prev = &yesterday;
     // HACK: adding to original object if we don't do this?
     auto apcp_24h = yesterday.prec().asValue();
-    while (getline(in, str))
+    for (size_t i = 0; i < s.hours.size(); ++i)
     {
-      istringstream iss(str);
-      if (getline(iss, str, ',') && !str.empty())
+      const auto& t = s.times[i];
+      const auto w = &s.hours[i];
+      const auto for_time = static_cast<size_t>(t.day - min_date) * DAY_HOURS + t.hour;
+      logging::verbose("for_time == %d", for_time);
+      by_hour->at(for_time) = w;
+      apcp_24h += w->prec().asValue();
+      logging::extensive("Adding %f to precip results in accumulation of %f",
+                         w->prec().asValue(),
+                         apcp_24h);
+      if (12 == t.hour)
       {
-        // HACK: ignore date and just worry about relative order??
-        // Scenario
-        logging::verbose("Scenario is %s", str.c_str());
-        size_t cur = 0;
-        try
-        {
-          cur = static_cast<size_t>(stoi(str));
-        }
-        catch (const std::exception& ex)
-        {
-          // HACK: somehow stoi() is still getting empty strings
-          logging::fatal(ex, "Error reading weather file %s: %s is not a valid integer", filename.c_str(), str.c_str());
-        }
-        if (wx.find(cur) == wx.end())
-        {
-          logging::debug("Loading scenario %d...", cur);
-          wx.emplace(cur, new vector<const wx::FwiWeather*>());
-          prev_time = std::numeric_limits<time_t>::min();
-          logging::check_fatal(wx_daily.find(cur) != wx_daily.end(),
-                               "Somehow have daily weather for scenario %ld before hourly weather",
-                               cur);
-          wx_daily.emplace(cur, map<Day, wx::FwiWeather>());
-          prev = &yesterday;
-          logging::extensive("Resetting new scenario precip to %f from %f",
-                             yesterday.prec().asValue(),
-                             apcp_24h);
-          apcp_24h = yesterday.prec().asValue();
-        }
-        auto& s = wx.at(cur);
-        struct tm t
-        {
-        };
-        util::read_date(&iss, &str, &t);
-        year_ = t.tm_year + 1900;
-        const auto ticks = mktime(&t);
-        if (1 == cur)
-        {
-          logging::debug("Date '%s' is %ld and calculated jd is %d",
-                         str.c_str(),
-                         ticks,
-                         t.tm_yday);
-          if (!s->empty() && t.tm_yday < min_date)
-          {
-            logging::fatal(
-              "Weather input file crosses year boundary or dates are not sequential");
-          }
-        }
-        min_date = min(min_date, static_cast<Day>(t.tm_yday));
-        max_date = max(max_date, static_cast<Day>(t.tm_yday));
-        time_t cur_time = mktime(&t);
-        if (prev_time != std::numeric_limits<time_t>::min())
-        {
-          auto seconds_diff = (cur_time - prev_time);
-          logging::check_fatal(
-            seconds_diff != HOUR_SECONDS,
-            "Expected sequential hours in weather input but rows are %f hours away from each other",
-            seconds_diff / static_cast<MathSize>(HOUR_SECONDS));
-        }
-        prev_time = cur_time;
-        const auto for_time = (t.tm_yday - min_date) * DAY_HOURS + t.tm_hour;
-        // HACK: can be up until rest of year since start date
-        const size_t new_size = (max_date - min_date + 1) * DAY_HOURS;
-        const auto old_size = s->size();
-        if (old_size != new_size)
-        {
-          s->resize(new_size);
-          for (auto i = old_size; i < new_size; ++i)
-          {
-            s->at(i) = nullptr;
-          }
-        }
-        logging::verbose("for_time == %d", for_time);
-        const wx::FwiWeather* w = new wx::FwiWeather(&iss,
-                                                     &str);
-        s->at(for_time) = w;
-        logging::check_fatal(0 > w->prec().asValue(),
-                             "Hourly weather precip %f is negative",
-                             w->prec().asValue());
-        apcp_24h += w->prec().asValue();
-        logging::extensive("Adding %f to precip results in accumulation of %f",
-                           w->prec().asValue(),
-                           apcp_24h);
-        if (12 == t.tm_hour)
-        {
-          // we just hit noon on a new day, so add the daily value
-          auto& s_daily = wx_daily.at(cur);
-          const auto day = static_cast<Day>(t.tm_yday);
-          logging::check_fatal(s_daily.find(day) != s_daily.end(),
-                               "Day already exists");
-          const auto month = t.tm_mon + 1;
-          s_daily.emplace(day,
-                          wx::FwiWeather(*prev,
-                                         month,
-                                         latitude,
-                                         w->temp(),
-                                         w->rh(),
-                                         w->wind(),
-                                         wx::Precipitation(apcp_24h)));
-          // new 24 hour period
-          logging::extensive("Resetting daily precip to %f from %f", 0.0, apcp_24h);
-          apcp_24h = 0;
-          prev = &s_daily.at(static_cast<Day>(t.tm_yday));
-        }
+        // we just hit noon on a new day, so add the daily value
+        logging::check_fatal(s_daily.find(t.day) != s_daily.end(),
+                             "Day already exists");
+        s_daily.emplace(t.day,
+                        wx::FwiWeather(*prev,
+                                       t.month,
+                                       latitude,
+                                       w->temp(),
+                                       w->rh(),
+                                       w->wind(),
+                                       wx::Precipitation(apcp_24h)));
+        // new 24 hour period
+        logging::extensive("Resetting daily precip to %f from %f", 0.0, apcp_24h);
+        apcp_24h = 0;
+        prev = &s_daily.at(t.day);
+      }
 #ifdef DEBUG_WEATHER
-        const auto month = t.tm_mon + 1;
-        logging::debug(FMT_OUT,
-                       cur,
-                       year_,
-                       month,
-                       t.tm_mday,
-                       t.tm_hour,
-                       t.tm_min,
-                       t.tm_sec,
-                       w->prec().asValue(),
-                       w->temp().asValue(),
-                       w->rh().asValue(),
-                       w->wind().speed().asValue(),
-                       w->wind().direction().asValue(),
-                       w->ffmc().asValue(),
-                       w->dmc().asValue(),
-                       w->dc().asValue(),
-                       w->isi().asValue(),
-                       w->bui().asValue(),
-                       w->fwi().asValue(),
-                       "");
-        fprintf(out,
-                FMT_OUT,
-                cur,
-                year_,
-                month,
-                t.tm_mday,
-                t.tm_hour,
-                t.tm_min,
-                t.tm_sec,
-                w->prec().asValue(),
-                w->temp().asValue(),
-                w->rh().asValue(),
-                w->wind().speed().asValue(),
-                w->wind().direction().asValue(),
-                w->ffmc().asValue(),
-                w->dmc().asValue(),
-                w->dc().asValue(),
-                w->isi().asValue(),
-                w->bui().asValue(),
-                w->fwi().asValue(),
-                "\r\n");
+      logging::debug(FMT_OUT,
+                     cur,
+                     t.year,
+                     t.month,
+                     t.day_of_month,
+                     t.hour,
+                     0,
+                     0,
+                     w->prec().asValue(),
+                     w->temp().asValue(),
+                     w->rh().asValue(),
+                     w->wind().speed().asValue(),
+                     w->wind().direction().asValue(),
+                     w->ffmc().asValue(),
+                     w->dmc().asValue(),
+                     w->dc().asValue(),
+                     w->isi().asValue(),
+                     w->bui().asValue(),
+                     w->fwi().asValue(),
+                     "");
+      fprintf(out,
+              FMT_OUT,
+              cur,
+              t.year,
+              t.month,
+              t.day_of_month,
+              t.hour,
+              0,
+              0,
+              w->prec().asValue(),
+              w->temp().asValue(),
+              w->rh().asValue(),
+              w->wind().speed().asValue(),
+              w->wind().direction().asValue(),
+              w->ffmc().asValue(),
+              w->dmc().asValue(),
+              w->dc().asValue(),
+              w->isi().asValue(),
+              w->bui().asValue(),
+              w->fwi().asValue(),
+              "\r\n");
 #endif
-      }
     }
+    // keep hourly weather alive since FireWeather points into it
+    wx_hours_->emplace_back(std::move(s.hours));
+  }
 #ifndef NDEBUG
-    logging::check_fatal(0 != fclose(out), "Could not close file %s", file_out.c_str());
+  logging::check_fatal(0 != fclose(out), "Could not close file %s", file_out.c_str());
 #endif
-    in.close();
-  }
   //  for (auto& kv : wx)
   //  {
   //    kv.second.emplace(static_cast<Day>(min_date - 1), yesterday);
@@ -337,41 +263,75 @@ void Model::readWeather(const wx::FwiWeather& yesterday,
   //  logging::check_fatal(0 != fclose(out), "Could not close file %s", file_out.c_str());
   const auto fuel_lookup = sim::Settings::fuelLookup();
   const auto& f = fuel_lookup.usedFuels();
+  // hourly streams are first and then daily streams in the same order
+  vector<size_t> ids{};
+  vector<vector<const wx::FwiWeather*>*> daily{};
+  vector<wx::SurvivalInput> inputs{};
   // loop through and try to find duplicates
   for (const auto& kv : wx)
   {
     const auto k = kv.first;
-    const auto s = kv.second;
     // FIX: this is just looking for duplicate scenario ids, not weather?
     if (wx_.find(k) == wx_.end())
     {
-      const auto w = make_shared<wx::FireWeather>(f, min_date, max_date, s);
-      wx_.emplace(k, w);
-      // calculate daily indices
-      auto& s_daily = wx_daily.at(k);
-      // HACK: set yesterday to match today
-      s_daily.emplace(min_date - 1, s_daily.at(min_date));
-      const auto w_daily = make_shared<wx::FireWeatherDaily>(f, s_daily);
-      wx_daily_.emplace(k, w_daily);
+      ids.push_back(k);
+      inputs.push_back({min_date, max_date, kv.second});
     }
   }
+  for (const auto k : ids)
+  {
+    // calculate daily indices
+    auto& s_daily = wx_daily.at(k);
+    // HACK: set yesterday to match today
+    s_daily.emplace(min_date - 1, s_daily.at(min_date));
+    daily.push_back(wx::make_vector(s_daily).release());
+    inputs.push_back({s_daily.begin()->first, s_daily.rbegin()->first, daily.back()});
+  }
+  // survival only depends on inputs, so reuse it if this weather was already used
+  // tables are for every fuel in the lookup table so the cache works for any area
+  const auto lookup_fuels = fuel_lookup.lookupFuels();
+  auto tables = wx::load_survival(filename + ".survival",
+                                  wx::survival_key(filename, yesterday, latitude, lookup_fuels),
+                                  lookup_fuels,
+                                  f,
+                                  inputs);
+  for (size_t i = 0; i < ids.size(); ++i)
+  {
+    const auto k = ids[i];
+    auto& hourly = tables[i];
+    const auto w = make_shared<wx::FireWeather>(min_date,
+                                                max_date,
+                                                wx.at(k),
+                                                std::move(hourly.survival),
+                                                hourly.weighted_dsr);
+    wx_.emplace(k, w);
+    auto& by_day = tables[ids.size() + i];
+    const auto w_daily = make_shared<wx::FireWeatherDaily>(wx_daily.at(k),
+                                                           daily[i],
+                                                           std::move(by_day.survival),
+                                                           by_day.weighted_dsr);
+    wx_daily_.emplace(k, w_daily);
+  }
 }
 void Model::findStarts(const Location location)
 {
   logging::error("Trying to start a fire in non-fuel");
   Idx range = 1;
   // HACK: should always be centered in the grid
-  while (starts_.empty() && (range < (MAX_COLUMNS / 2)))
+  while (starts_.empty() && (range < (max(rows(), columns()) / 2)))
   {
     for (Idx x = -range; x <= range; ++x)
     {
       for (Idx y = -range; y <= range; ++y)
       {
+        const auto row = location.row() + y;
+        const auto column = location.column() + x;
         // make sure we only look at the outside of the box
-        if (1 == range || abs(x) == range || abs(y) == range)
+        if ((1 == range || abs(x) == range || abs(y) == range)
+            && row >= 0 && row < rows() && column >= 0 && column < columns())
         {
           //          const auto loc = env_->cell(location.hash() + (y * MAX_COLUMNS) + x);
-          const auto loc = env_->cell(Location(location.row() + y, location.column() + x));
+          const auto loc = env_->cell(Location(row, column));
           if (!fuel::is_null_fuel(loc))
           {
             starts_.push_back(make_shared<topo::Cell>(cell(loc)));
@@ -598,7 +558,9 @@ ProbabilityMap* Model::makeProbabilityMap(const DurationSize time,
                                           const int med_max,
                                           const int max_value) const
 {
-  return env_->makeProbabilityMap(time,
+  // use this Model's folder since the Environment can be shared between fires
+  return env_->makeProbabilityMap(dir_out_,
+                                  time,
                                   start_time,
                                   min_value,
                                   low_max,
@@ -643,31 +605,31 @@ map<DurationSize, util::SafeVector*> make_size_map(const vector<DurationSize>& s
   }
   return result;
 }
-bool Model::add_statistics(vector<MathSize>* all_sizes,
-                           vector<MathSize>* means,
-                           vector<MathSize>* pct,
+bool Model::add_statistics(util::RunningStatistics* all_sizes,
+                           util::RunningStatistics* means,
+                           util::RunningStatistics* pct,
                            const util::SafeVector& sizes)
 {
   const auto cur_sizes = sizes.getValues();
   logging::check_fatal(cur_sizes.empty(), "No sizes at end of simulation");
   const util::Statistics s{cur_sizes};
-  static_cast<void>(util::insert_sorted(pct, s.percentile(95)));
-  static_cast<void>(util::insert_sorted(means, s.mean()));
+  pct->add(s.percentile(95));
+  means->add(s.mean());
   // NOTE: Used to just look at mean and percentile of each iteration, but should probably look at all the sizes together?
   for (const auto& size : cur_sizes)
   {
-    static_cast<void>(util::insert_sorted(all_sizes, size));
+    all_sizes->add(size);
   }
   if (Settings::surface())
   {
     return true;
   }
-  is_over_simulation_count_ = all_sizes->size() >= Settings::maximumCountSimulations();
+  is_over_simulation_count_ = all_sizes->n() >= Settings::maximumCountSimulations();
   if (isOverSimulationCountLimit())
   {
     logging::note(
       "Stopping after %d iterations. Simulation limit of %d simulations has been reached.",
-      all_sizes->size(),
+      all_sizes->n(),
       Settings::maximumCountSimulations());
     return false;
   }
@@ -675,7 +637,7 @@ bool Model::add_statistics(vector<MathSize>* all_sizes,
   {
     logging::note(
       "Stopping after %d iterations. Time limit of %d seconds has been reached.",
-      pct->size(),
+      pct->n(),
       Settings::maximumTimeSeconds());
     return false;
   }
@@ -693,9 +655,9 @@ bool Model::add_statistics(vector<MathSize>* all_sizes,
  * that is less than the confidence level defined in the settings file
  */
 size_t runs_required(const size_t i,
-                     const vector<MathSize>* all_sizes,
-                     const vector<MathSize>* means,
-                     const vector<MathSize>* pct,
+                     const util::RunningStatistics* all_sizes,
+                     const util::RunningStatistics* means,
+                     const util::RunningStatistics* pct,
                      const Model& model)
 {
   if (Settings::deterministic())
@@ -707,7 +669,7 @@ size_t runs_required(const size_t i,
   {
     logging::note(
       "Stopping after %d iterations. Simulation limit of %d simulations has been reached.",
-      all_sizes->size(),
+      all_sizes->n(),
       Settings::maximumCountSimulations());
     return 0;
   }
@@ -719,9 +681,9 @@ size_t runs_required(const size_t i,
       Settings::maximumTimeSeconds());
     return 0;
   }
-  const auto for_sizes = util::Statistics{*all_sizes};
-  const auto for_means = util::Statistics{*means};
-  const auto for_pct = util::Statistics{*pct};
+  const auto& for_sizes = *all_sizes;
+  const auto& for_means = *means;
+  const auto& for_pct = *pct;
   if (!(!for_means.isConfident(Settings::confidenceLevel())
         || !for_pct.isConfident(Settings::confidenceLevel())
         || !for_sizes.isConfident(Settings::confidenceLevel())))
@@ -788,9 +750,9 @@ map<DurationSize, ProbabilityMap*> Model::runIterations(const topo::StartPoint&
   std::seed_seq seed_extinction{static_cast<size_t>(1), static_cast<size_t>(start_day), lat, lon};
   mt19937 mt_spread(seed_spread);
   mt19937 mt_extinction(seed_extinction);
-  vector<MathSize> all_sizes{};
-  vector<MathSize> means{};
-  vector<MathSize> pct{};
+  util::RunningStatistics all_sizes{};
+  util::RunningStatistics means{};
+  util::RunningStatistics pct{};
   size_t iterations_done = 0;
   size_t scenarios_done = 0;
   size_t scenarios_required_done = 0;
@@ -800,9 +762,30 @@ map<DurationSize, ProbabilityMap*> Model::runIterations(const topo::StartPoint&
                                          start,
                                          start_day,
                                          last_date));
+  const auto scenarios_per_iteration = all_iterations[0].size();
+  const auto num_workers = max(static_cast<size_t>(std::thread::hardware_concurrency()),
+                               static_cast<size_t>(1));
+  // if there are fewer scenarios than workers then keep extra copies of them so
+  // every worker has something to run
+  // no point in running multiple iterations if deterministic, and surface scenarios
+  // keep spread information between starts so a copy would give different results
+  const auto copies = (!Settings::runAsync() || Settings::deterministic())
+                      ? 1
+                      : (num_workers + scenarios_per_iteration - 1) / scenarios_per_iteration;
+  for (size_t x = 1; x < copies; ++x)
+  {
+    all_iterations.push_back(readScenarios(start_point,
+                                           start,
+                                           start_day,
+                                           last_date));
+  }
   // HACK: reference from vector so timer can cancel everything in vector
   auto& iteration = all_iterations[0];
-  const auto scenarios_per_iteration = iteration.size();
+  // lock for anything that changes while scenarios are running
+  mutex mutex_iterations{};
+  std::condition_variable cv_iterations{};
+  // iteration that each Scenario is currently running
+  map<const Scenario*, size_t> running{};
   // put probability maps into map
   logging::verbose("Setting save points");
   const auto saves = iteration.savePoints();
@@ -837,7 +820,7 @@ map<DurationSize, ProbabilityMap*> Model::runIterations(const topo::StartPoint&
   // typedef std::chrono::duration<float> s;
   bool is_being_cancelled = false;
   // HACK: use initial value for type
-  auto timer = std::thread([this, &scenarios_per_iteration, &scenarios_required_done, &scenarios_done, &all_probabilities, &iterations_done, &runs_left, &all_sizes, &all_iterations, &is_being_cancelled, &probabilities, &start_day]() {
+  auto timer = std::thread([this, &scenarios_per_iteration, &scenarios_required_done, &scenarios_done, &all_probabilities, &iterations_done, &runs_left, &all_sizes, &all_iterations, &mutex_iterations, &running, &is_being_cancelled, &probabilities, &start_day]() {
     constexpr auto CHECK_INTERVAL = std::chrono::seconds(1);
     // const auto SLEEP_INTERVAL = std::chrono::seconds(Settings::maximumTimeSeconds());
     do
@@ -859,16 +842,22 @@ map<DurationSize, ProbabilityMap*> Model::runIterations(const topo::StartPoint&
     {
       logging::warning("Ran out of time, but haven't finished any iterations, so cancelling all but first");
     }
-    size_t i = 0;
-    for (auto& iter : all_iterations)
     {
-      // don't cancel first iteration if no iterations are done
-      if (0 != iterations_done || 0 != i)
+      lock_guard<mutex> lock(mutex_iterations);
+      for (auto& iter : all_iterations)
       {
-        // if not over limit then just did all the runs so no warning
-        iter.cancel(shouldStop());
+        for (auto s : iter.getScenarios())
+        {
+          const auto it = running.find(s);
+          const auto cur_iter = (running.end() == it) ? iterations_done : it->second;
+          // don't cancel first iteration if no iterations are done
+          if (0 != iterations_done || 0 != cur_iter)
+          {
+            // if not over limit then just did all the runs so no warning
+            s->cancel(shouldStop());
+          }
+        }
       }
-      ++i;
     }
     // is_being_cancelled = (0 == iterations_done);
     if (0 == iterations_done)
@@ -889,17 +878,8 @@ map<DurationSize, ProbabilityMap*> Model::runIterations(const topo::StartPoint&
                    run_time_seconds,
                    time_left);
   });
-  auto threads = list<std::thread>{};
-  // const auto finalize_probabilities = [&threads, &timer, &probabilities](bool do_cancel) {
-  const auto finalize_probabilities = [this, &start_day, &all_sizes, &is_being_cancelled, &threads, &timer, &probabilities]() {
+  const auto finalize_probabilities = [&timer, &probabilities]() {
     // assume timer is cancelling everything
-    for (auto& t : threads)
-    {
-      if (t.joinable())
-      {
-        t.join();
-      }
-    }
     if (timer.joinable())
     {
       timer.join();
@@ -935,37 +915,11 @@ map<DurationSize, ProbabilityMap*> Model::runIterations(const topo::StartPoint&
   };
   if (Settings::runAsync())
   {
-    // FIX: I think we can just have 2 Iteration objects and roll through starting
-    // threads in the second one as the first one finishes?
-    // const auto MAX_THREADS = static_cast<size_t>(std::thread::hardware_concurrency() * PCT_CPU);
-    // const auto MAX_THREADS = static_cast<size_t>(std::thread::hardware_concurrency() / 4);
-    // const auto MAX_THREADS = std::thread::hardware_concurrency() - 1;
-    const auto HARDWARE_THREADS = static_cast<size_t>(std::thread::hardware_concurrency());
-    // maybe a bit slower but prefer to run all scenarios at the same time
-    const auto MAX_THREADS = max(HARDWARE_THREADS, scenarios_per_iteration);
-    if (MAX_THREADS > HARDWARE_THREADS)
-    {
-      logging::note("Increasing to use at least one thread for each of %ld scenarios", scenarios_per_iteration);
-      Model::task_limiter.set_limit(MAX_THREADS);
-    }
-    // const auto MAX_CONCURRENT = std::max<size_t>(MAX_THREADS, 1);
-    // const auto concurrent_iterations = std::max<size_t>(
-    //   MAX_CONCURRENT / all_iterations[0].getScenarios().size(),
-    //   1);
-    // HACK: just set max of 4 for now
-    // constexpr auto MIN_ITERATIONS_BEFORE_CHECK = 4;
-    // const auto concurrent_iterations = std::min(
-    //   static_cast<size_t>(MIN_ITERATIONS_BEFORE_CHECK),
-    //   MAX_THREADS);
-    // no point in running multiple iterations if deterministic
-    const auto concurrent_iterations = 1;
-    // const auto concurrent_iterations = MAX_THREADS;
-    for (size_t x = 1; x < concurrent_iterations; ++x)
+    // scenarios can start another iteration as soon as they finish, as long as they don't
+    // get more than this many iterations ahead of the oldest one that isn't finished
+    const auto window = copies + 1;
+    for (size_t x = 1; x < window; ++x)
     {
-      all_iterations.push_back(readScenarios(start_point,
-                                             start,
-                                             start_day,
-                                             last_date));
       all_probabilities.push_back(make_prob_map(*this,
                                                 saves,
                                                 started,
@@ -974,112 +928,215 @@ map<DurationSize, ProbabilityMap*> Model::runIterations(const topo::StartPoint&
                                                 Settings::intensityMaxModerate(),
                                                 numeric_limits<int>::max()));
     }
-    auto run_scenario = [this, &is_being_cancelled, &scenarios_per_iteration, &scenarios_required_done, &scenarios_done, &all_probabilities, &all_iterations, &start_day](Scenario* s, size_t i, bool is_required) {
-      auto result = s->run(&all_probabilities[i]);
-      ++scenarios_done;
-      logging::extensive("Done %ld scenarios in iteration %ld which %s required", scenarios_done, i, (is_required ? "is" : "is not"));
-      if (is_required)
+    // iteration i uses index (i % window) for its results
+    vector<util::SafeVector> window_sizes(window);
+    vector<size_t> window_left(window, scenarios_per_iteration);
+    // next iteration for each scenario, and the copies of it that aren't running
+    vector<size_t> next_iteration(scenarios_per_iteration, 0);
+    vector<vector<Scenario*>> idle(scenarios_per_iteration);
+    for (const auto& iter : all_iterations)
+    {
+      const auto& scenarios = iter.getScenarios();
+      for (size_t j = 0; j < scenarios_per_iteration; ++j)
+      {
+        idle[j].push_back(scenarios[j]);
+      }
+    }
+    // random number generator states for scenarios that haven't been reset yet
+    map<size_t, pair<mt19937, mt19937>> pending_seeds{};
+    size_t next_seed = 0;
+    bool is_stopping = false;
+    // NOTE: all of these should only be called while holding mutex_iterations
+    // use the random numbers each scenario would get if they were reset in order
+    const auto take_seeds = [&iteration, &scenarios_per_iteration, &mt_extinction, &mt_spread, &pending_seeds, &next_seed](const size_t index) {
+      const auto& scenarios = iteration.getScenarios();
+      while (next_seed <= index)
+      {
+        pending_seeds.emplace(next_seed, pair<mt19937, mt19937>{mt_extinction, mt_spread});
+        scenarios[next_seed % scenarios_per_iteration]->skipThresholds(&mt_extinction, &mt_spread);
+        ++next_seed;
+      }
+      auto seeds = std::move(pending_seeds.at(index));
+      pending_seeds.erase(index);
+      return seeds;
+    };
+    // find the next iteration for scenario j to run, if it can start one now
+    const auto claim = [this, &window, &iterations_done, &next_iteration, &is_stopping, &running](const size_t j, const Scenario* s, size_t* i) {
+      const auto next = next_iteration[j];
+      if (is_stopping
+          || shouldStop()
+          || next >= iterations_done + window
+          || (Settings::surface() && next >= starts_.size()))
       {
-        logging::verbose("Done %ld scenarios in iteration %ld which %s required", scenarios_done, i, (is_required ? "is" : "is not"));
-        ++scenarios_required_done;
-        logging::debug("Have (%ld of %ld) scenarios and %s being cancelled",
-                       scenarios_required_done,
-                       scenarios_per_iteration,
-                       (is_being_cancelled ? "is" : "not"));
-        if (is_being_cancelled)
+        return false;
+      }
+      *i = next;
+      ++next_iteration[j];
+      running[s] = next;
+      return true;
+    };
+    // use pool that other fires are running on if there is one
+    const auto own_pool = (nullptr == pool_) ? make_unique<util::WorkerPool>(num_workers) : nullptr;
+    auto& pool = (nullptr == pool_) ? *own_pool : *pool_;
+    logging::debug("Running %ld copies of %ld scenarios with %ld workers",
+                   copies,
+                   scenarios_per_iteration,
+                   pool.size());
+    std::function<void(Scenario*, size_t, size_t)> run_scenario;
+    const auto start_scenario = [&pool, &run_scenario](Scenario* s, const size_t j, const size_t i) {
+      pool.submit([&run_scenario, s, j, i]() { run_scenario(s, j, i); });
+    };
+    run_scenario = [this, &start_scenario, &claim, &take_seeds, &mutex_iterations, &cv_iterations, &running, &idle, &window, &window_sizes, &window_left, &scenarios_per_iteration, &is_stopping, &is_being_cancelled, &scenarios_required_done, &scenarios_done, &all_probabilities, &start_day](Scenario* s, const size_t j, const size_t i) {
+      const auto k = i % window;
+      if (Settings::surface())
+      {
+        static_cast<void>(s->reset_with_new_start(starts_[i], &window_sizes[k]));
+      }
+      else
+      {
+        pair<mt19937, mt19937> seeds{};
+        {
+          lock_guard<mutex> lock(mutex_iterations);
+          seeds = take_seeds(i * scenarios_per_iteration + j);
+        }
+        static_cast<void>(s->reset(&seeds.first, &seeds.second, &window_sizes[k]));
+      }
+      bool is_cancelled;
+      {
+        lock_guard<mutex> lock(mutex_iterations);
+        // first iteration always has to finish, but anything else is thrown away if stopping
+        is_cancelled = is_stopping || (0 != i && shouldStop());
+      }
+      if (!is_cancelled)
+      {
+        static_cast<void>(s->run(&all_probabilities[k]));
+        const auto is_required = (0 == i);
+        bool save_interim = false;
         {
-          // no point in saving interim if final is done
-          if (scenarios_per_iteration != scenarios_required_done)
+          lock_guard<mutex> lock(mutex_iterations);
+          ++scenarios_done;
+          logging::extensive("Done %ld scenarios in iteration %ld which %s required", scenarios_done, i, (is_required ? "is" : "is not"));
+          if (is_required)
           {
-            logging::info("Saving interim results for (%ld of %ld) scenarios", scenarios_required_done, scenarios_per_iteration);
-            saveProbabilities(all_probabilities[0], start_day, true);
+            logging::verbose("Done %ld scenarios in iteration %ld which %s required", scenarios_done, i, (is_required ? "is" : "is not"));
+            ++scenarios_required_done;
+            logging::debug("Have (%ld of %ld) scenarios and %s being cancelled",
+                           scenarios_required_done,
+                           scenarios_per_iteration,
+                           (is_being_cancelled ? "is" : "not"));
+            // no point in saving interim if final is done
+            save_interim = is_being_cancelled && scenarios_per_iteration != scenarios_required_done;
           }
         }
+        if (save_interim)
+        {
+          logging::info("Saving interim results for (%ld of %ld) scenarios", scenarios_required_done, scenarios_per_iteration);
+          saveProbabilities(all_probabilities[0], start_day, true);
+        }
+      }
+      size_t next = 0;
+      bool has_next;
+      {
+        lock_guard<mutex> lock(mutex_iterations);
+        running.erase(s);
+        --window_left[k];
+        has_next = claim(j, s, &next);
+        if (!has_next)
+        {
+          idle[j].push_back(s);
+        }
+      }
+      cv_iterations.notify_all();
+      if (has_next)
+      {
+        start_scenario(s, j, next);
       }
-      return result;
     };
-    logging::debug("Created %d iterations to run concurrently", all_iterations.size());
-    size_t cur_iter = 0;
-    for (auto& iter : all_iterations)
-    {
-      if (reset_iter(iter))
+    // start anything that isn't running and has an iteration it can run
+    const auto start_idle = [&mutex_iterations, &idle, &claim, &start_scenario]() {
+      vector<std::tuple<Scenario*, size_t, size_t>> to_start{};
       {
-        auto& scenarios = iter.getScenarios();
-        for (auto s : scenarios)
+        lock_guard<mutex> lock(mutex_iterations);
+        for (size_t j = 0; j < idle.size(); ++j)
         {
-          threads.emplace_back(run_scenario,
-                               s,
-                               cur_iter,
-                               0 == cur_iter);
+          size_t i = 0;
+          while (!idle[j].empty() && claim(j, idle[j].back(), &i))
+          {
+            to_start.emplace_back(idle[j].back(), j, i);
+            idle[j].pop_back();
+          }
         }
-        ++cur_iter;
       }
-    }
-    cur_iter = 0;
+      for (const auto& t : to_start)
+      {
+        start_scenario(std::get<0>(t), std::get<1>(t), std::get<2>(t));
+      }
+    };
+    const auto stop = [this, &mutex_iterations, &is_stopping, &all_iterations, &pool, &finalize_probabilities]() {
+      {
+        lock_guard<mutex> lock(mutex_iterations);
+        is_stopping = true;
+      }
+      // anything still running is past the iterations that are needed
+      for (auto& iter : all_iterations)
+      {
+        iter.cancel(shouldStop());
+      }
+      pool.wait();
+      return finalize_probabilities();
+    };
+    start_idle();
     while (runs_left > 0)
     {
-      // should have completed one iteration, so add it
-      auto& iteration = all_iterations[cur_iter];
-      // so now try to loop through and add iterations as they finish
-      // FIX: look at converting so that new threads get started as others complete
-      // - would have to have multiple Iterations so we keep the data from them separate?
-      size_t k = 0;
-      while (k < scenarios_per_iteration)
+      // wait for iterations to finish in order so results are added the same way every time
+      const auto k = iterations_done % window;
       {
-        threads.front().join();
-        threads.pop_front();
-        ++k;
+        std::unique_lock<mutex> lock(mutex_iterations);
+        cv_iterations.wait(lock, [&window_left, &k] { return 0 == window_left[k]; });
       }
-      auto final_sizes = iteration.finalSizes();
-      ++iterations_done;
-      for (auto& kv : all_probabilities[cur_iter])
+      auto final_sizes = window_sizes[k];
+      // everything in this iteration was cancelled before it could finish, so discard what it had
+      const auto is_cancelled = 0 == final_sizes.size() && shouldStop();
+      for (auto& kv : all_probabilities[k])
       {
-        probabilities[kv.first]->addProbabilities(*kv.second);
+        if (!is_cancelled)
+        {
+          probabilities[kv.first]->addProbabilities(*kv.second);
+        }
         // clear so we don't double count
         kv.second->reset();
       }
+      window_sizes[k] = {};
+      {
+        lock_guard<mutex> lock(mutex_iterations);
+        window_left[k] = scenarios_per_iteration;
+        ++iterations_done;
+      }
+      if (is_cancelled)
+      {
+        return stop();
+      }
       if (!add_statistics(&all_sizes, &means, &pct, final_sizes))
       {
         // ran out of time but timer should cancel everything
-        return finalize_probabilities();
+        return stop();
       }
-      // if (iterations_done >= MIN_ITERATIONS_BEFORE_CHECK)
+      if (Settings::surface())
       {
-        if (Settings::surface())
-        {
-          runs_left = ignitionScenarios() - iterations_done;
-        }
-        else
-        {
-          runs_left = runs_required(iterations_done, &all_sizes, &means, &pct, *this);
-          // runs_left = runs_required(iterations_done, &means, &pct, *this);
-          logging::note("Need another %d iterations", runs_left);
-        }
+        runs_left = ignitionScenarios() - iterations_done;
       }
-      if (runs_left > 0)
+      else
       {
-        if (reset_iter(iteration))
-        {
-          auto& scenarios = iteration.getScenarios();
-          for (auto s : scenarios)
-          {
-            threads.emplace_back(run_scenario,
-                                 s,
-                                 cur_iter,
-                                 false);
-          }
-          ++cur_iter;
-          // loop around to start if required
-          cur_iter %= all_iterations.size();
-        }
+        runs_left = runs_required(iterations_done, &all_sizes, &means, &pct, *this);
+        logging::note("Need another %d iterations", runs_left);
       }
-      else
+      if (runs_left > 0)
       {
-        // no runs required, so stop
-        return finalize_probabilities();
+        start_idle();
       }
     }
-    // everything should be done when this section ends
+    // no runs required, so stop
+    return stop();
   }
   else
   {
@@ -1135,8 +1192,33 @@ int Model::runScenarios(const string dir_out,
                                                 perimeter,
                                                 start_time.tm_year);
   logging::debug("Environment loaded");
+  static_cast<void>(runFire(dir_out,
+                             weather_input,
+                             yesterday,
+                             &env,
+                             start_point,
+                             start_time,
+                             perimeter,
+                             size,
+                             nullptr,
+                             nullptr));
+  return 0;
+}
+unique_ptr<Model> Model::runFire(const string dir_out,
+                                 const char* const weather_input,
+                                 const wx::FwiWeather& yesterday,
+                                 topo::Environment* env,
+                                 const topo::StartPoint& start_point,
+                                 const tm& start_time,
+                                 const string& perimeter,
+                                 const size_t size,
+                                 util::WorkerPool* pool,
+                                 const Model* weather_from)
+{
+  // counts are static, so batch mode would report totals for every fire so far otherwise
+  Scenario::reset_counts();
   // don't flip for Environment because that already happened
-  const auto position = env.findCoordinates(start_point, false);
+  const auto position = env->findCoordinates(start_point, false);
 #ifndef NDEBUG
   logging::check_fatal(
     std::get<0>(*position) > MAX_ROWS || std::get<1>(*position) > MAX_COLUMNS,
@@ -1146,7 +1228,9 @@ int Model::runScenarios(const string dir_out,
 #endif
   logging::info("Position is (%d, %d)", std::get<0>(*position), std::get<1>(*position));
   const Location location{std::get<0>(*position), std::get<1>(*position)};
-  Model model(dir_out, start_point, &env);
+  auto model_ptr = make_unique<Model>(dir_out, start_point, env);
+  auto& model = *model_ptr;
+  model.pool_ = pool;
   // HACK: set after constructor so Test doesn't need to set
   model.start_time_ = start_time;
   // auto x = static_cast<MathSize>(0.0);
@@ -1156,7 +1240,7 @@ int Model::runScenarios(const string dir_out,
   //               zone,
   //               static_cast<int>(x),
   //               static_cast<int>(y));
-  logging::note("Grid has size (%d, %d)", env.rows(), env.columns());
+  logging::note("Grid has size (%d, %d)", env->rows(), env->columns());
   logging::note("Fire start position is cell (%d, %d)",
                 location.row(),
                 location.column());
@@ -1179,7 +1263,14 @@ int Model::runScenarios(const string dir_out,
   }
   else
   {
-    model.readWeather(yesterday, start_point.latitude(), weather_input);
+    if (nullptr != weather_from)
+    {
+      model.shareWeather(*weather_from);
+    }
+    else
+    {
+      model.readWeather(yesterday, start_point.latitude(), weather_input);
+    }
     if (model.wx_.empty())
     {
       logging::fatal("No weather provided");
@@ -1227,6 +1318,123 @@ int Model::runScenarios(const string dir_out,
   {
     delete kv.second;
   }
+  return model_ptr;
+}
+void Model::shareWeather(const Model& rhs)
+{
+  wx_ = rhs.wx_;
+  wx_daily_ = rhs.wx_daily_;
+  wx_hours_ = rhs.wx_hours_;
+  year_ = rhs.year_;
+}
+/**
+ * \brief Whether Ignition is far enough from the edges of an Environment to use it
+ * \param env Environment to check
+ * \param ignition Ignition to check
+ * \return Whether Ignition is far enough from the edges of an Environment to use it
+ */
+static bool is_central(const topo::Environment& env, const Ignition& ignition)
+{
+  // don't want fires to hit the edge sooner than they would in their own Environment
+  constexpr Idx EDGE_FRACTION = 4;
+  if (!ignition.perimeter.empty()
+      && 0 != strcmp(data::read_header(ignition.perimeter).proj4().c_str(), env.proj4().c_str()))
+  {
+    return false;
+  }
+  const auto position = env.findCoordinates(ignition.start_point, false);
+  if (nullptr == position)
+  {
+    return false;
+  }
+  const auto row = std::get<0>(*position);
+  const auto column = std::get<1>(*position);
+  const auto min_row = env.rows() / EDGE_FRACTION;
+  const auto min_column = env.columns() / EDGE_FRACTION;
+  return row >= min_row && row < env.rows() - min_row
+      && column >= min_column && column < env.columns() - min_column;
+}
+/**
+ * \brief Largest difference in latitude (degrees) between fires that share weather
+ *
+ * Weather depends on latitude through sunrise and sunset, which only move by about a
+ * minute over this distance, so fires this close get the same streams anyway.
+ */
+static constexpr MathSize WEATHER_LATITUDE_TOLERANCE = 0.1;
+int Model::runBatch(const vector<Ignition>& ignitions,
+                    const char* const weather_input,
+                    const wx::FwiWeather& yesterday,
+                    const char* const raster_root)
+{
+  util::WorkerPool pool(max(static_cast<size_t>(std::thread::hardware_concurrency()),
+                            static_cast<size_t>(1)));
+  vector<bool> is_done(ignitions.size(), false);
+  size_t num_environments = 0;
+  for (size_t i = 0; i < ignitions.size(); ++i)
+  {
+    if (is_done[i])
+    {
+      continue;
+    }
+    const auto& first = ignitions[i];
+    util::make_directory_recursive(first.output_dir.c_str());
+    // grids kept for reuse have the previous Environment's extent and georeference
+    IntensityMap::clearCache();
+    auto env = topo::Environment::loadEnvironment(first.output_dir,
+                                                  raster_root,
+                                                  first.start_point,
+                                                  first.perimeter,
+                                                  first.start_time.tm_year);
+    ++num_environments;
+    logging::debug("Environment loaded");
+    // weather depends on latitude, so only share it between fires that are close to
+    // where it was read for
+    unique_ptr<Model> weather_from = nullptr;
+    MathSize weather_latitude = 0;
+    for (size_t j = i; j < ignitions.size(); ++j)
+    {
+      const auto& cur = ignitions[j];
+      if (is_done[j]
+          || cur.start_time.tm_year != first.start_time.tm_year
+          || (i != j && !is_central(env, cur)))
+      {
+        continue;
+      }
+      is_done[j] = true;
+      logging::note("Running fire %ld of %ld at (%f, %f) with outputs in %s",
+                    j + 1,
+                    ignitions.size(),
+                    cur.start_point.latitude(),
+                    cur.start_point.longitude(),
+                    cur.output_dir.c_str());
+      util::make_directory_recursive(cur.output_dir.c_str());
+      const auto latitude = cur.start_point.latitude();
+      const auto share_weather = nullptr != weather_from
+                              && abs(latitude - weather_latitude) <= WEATHER_LATITUDE_TOLERANCE;
+      if (share_weather)
+      {
+        logging::note("Using weather read for latitude %f for fire at latitude %f",
+                      weather_latitude,
+                      latitude);
+      }
+      auto model = runFire(cur.output_dir,
+                           weather_input,
+                           yesterday,
+                           &env,
+                           cur.start_point,
+                           cur.start_time,
+                           cur.perimeter,
+                           cur.size,
+                           &pool,
+                           share_weather ? weather_from.get() : nullptr);
+      if (!share_weather)
+      {
+        weather_from = std::move(model);
+        weather_latitude = latitude;
+      }
+    }
+  }
+  logging::note("Ran %ld fires using %ld environments", ignitions.size(), num_environments);
   return 0;
 }
 #ifdef DEBUG_WEATHER
@@ -16,16 +16,23 @@
 #include "Environment.h"
 #include "Iteration.h"
 #include "FireWeather.h"
+#include "SpreadInfoCache.h"
+#include "Statistics.h"
 namespace tbd
 {
 namespace topo
 {
 class StartPoint;
 }
+namespace util
+{
+class WorkerPool;
+}
 namespace sim
 {
 class Event;
 class Scenario;
+struct Ignition;
 /**
  * \brief Provides the ability to limit number of threads running at once.
  */
@@ -153,6 +160,24 @@ public:
                                         const tm& start_time,
                                         const string& perimeter,
                                         size_t size);
+  /**
+   * \brief Run Scenarios for each Ignition in a batch
+   *
+   * Ignitions that are far enough from the edge of an Environment that was loaded for
+   * another Ignition use that Environment, and reuse weather that was read for a latitude
+   * within 0.1 degrees of their own. Fires run one at a time, with the simulations for
+   * each fire spread across the same WorkerPool. Each Ignition still saves outputs to
+   * its own folder.
+   * \param ignitions Ignitions to run
+   * \param weather_input Name of file to read weather from
+   * \param yesterday FwiWeather yesterday used for startup indices
+   * \param raster_root Directory to read raster inputs from
+   * \return
+   */
+  [[nodiscard]] static int runBatch(const vector<Ignition>& ignitions,
+                                    const char* weather_input,
+                                    const wx::FwiWeather& yesterday,
+                                    const char* raster_root);
   /**
    * \brief Cell at the given row and column
    * \param row Row
@@ -292,6 +317,14 @@ public:
    * \return std::chrono::seconds  Duration model has been running for
    */
   [[nodiscard]] std::chrono::seconds runTime() const;
+  /**
+   * \brief Spread calculations shared by all Scenarios
+   * \return Spread calculations shared by all Scenarios
+   */
+  [[nodiscard]] SpreadInfoCache& spreadInfoCache() const noexcept
+  {
+    return spread_info_cache_;
+  }
   /**
    * \brief Create a ProbabilityMap with the same extent as this
    * \param time Time in simulation this ProbabilityMap represents
@@ -380,6 +413,35 @@ public:
     return &yesterday_;
   }
 private:
+  /**
+   * \brief Run Scenarios for a single fire in an Environment that is already loaded
+   * \param dir_out Folder to save outputs to
+   * \param weather_input Name of file to read weather from
+   * \param yesterday FwiWeather yesterday used for startup indices
+   * \param env Environment to run simulations in
+   * \param start_point StartPoint to use for sunrise/sunset
+   * \param start_time Start time for simulation
+   * \param perimeter Perimeter to initialize fire from, if there is one
+   * \param size Size to start fire at if no Perimeter
+   * \param pool WorkerPool to run simulations on, or nullptr to make one
+   * \param weather_from Model to use weather from instead of reading it, or nullptr
+   * \return Model that was run, so that its weather can be used for other fires
+   */
+  [[nodiscard]] static unique_ptr<Model> runFire(const string dir_out,
+                                                 const char* weather_input,
+                                                 const wx::FwiWeather& yesterday,
+                                                 topo::Environment* env,
+                                                 const topo::StartPoint& start_point,
+                                                 const tm& start_time,
+                                                 const string& perimeter,
+                                                 size_t size,
+                                                 util::WorkerPool* pool,
+                                                 const Model* weather_from);
+  /**
+   * \brief Use the same weather streams as another Model
+   * \param rhs Model to use weather from
+   */
+  void shareWeather(const Model& rhs);
   const string dir_out_;
   /**
    * \brief Add statistics for completed iterations
@@ -388,9 +450,9 @@ private:
    * \param pct 95th percentile sizes per iteration
    * \param cur_sizes Sizes to add to statistics
    */
-  [[nodiscard]] bool add_statistics(vector<MathSize>* all_sizes,
-                                    vector<MathSize>* means,
-                                    vector<MathSize>* pct,
+  [[nodiscard]] bool add_statistics(util::RunningStatistics* all_sizes,
+                                    util::RunningStatistics* means,
+                                    util::RunningStatistics* pct,
                                     const util::SafeVector& sizes);
   /**
    * \brief Mutex for parallel access
@@ -404,6 +466,10 @@ private:
    * \brief Pool of BurnedData that can be reused
    */
   mutable vector<unique_ptr<BurnedData>> vectors_{};
+  /**
+   * \brief Spread calculations shared by all Scenarios
+   */
+  mutable SpreadInfoCache spread_info_cache_{};
   /**
    * \brief Run Iterations until confidence is reached
    * \param start_point StartPoint to use for sunrise/sunset
@@ -439,6 +505,11 @@ private:
    * \brief Map of scenario number to weather stream
    */
   map<size_t, shared_ptr<wx::FireWeather>> wx_daily_{};
+  /**
+   * \brief Hourly weather for each scenario, which weather streams point into
+   */
+  shared_ptr<vector<vector<wx::FwiWeather>>> wx_hours_ =
+    make_shared<vector<vector<wx::FwiWeather>>>();
   /**
    * \brief Cell(s) that can burn closest to start Location
    */
@@ -463,6 +534,10 @@ private:
    * \brief Environment to use for Model
    */
   topo::Environment* env_;
+  /**
+   * \brief WorkerPool shared with other Models, or nullptr if this makes its own
+   */
+  util::WorkerPool* pool_ = nullptr;
 #ifdef DEBUG_WEATHER
   /**
    * \brief Write weather that was loaded to an output file
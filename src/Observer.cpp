@@ -14,9 +14,8 @@ string IObserver::makeName(const string& base_name, const string& suffix)
   }
   return suffix;
 }
-constexpr DurationSize NODATA_ARRIVAL = 0;
-ArrivalObserver::ArrivalObserver(const Scenario& scenario)
-  : MapObserver<DurationSize>(scenario, NODATA_ARRIVAL, "arrival")
+ArrivalObserver::ArrivalObserver(const Scenario& scenario) noexcept
+  : scenario_(scenario)
 {
 #ifdef DEBUG_GRIDS
   // enforce converting to an int and back produces same V
@@ -34,15 +33,15 @@ ArrivalObserver::ArrivalObserver(const Scenario& scenario)
     "nodata_value_ from int");
 #endif
 }
-DurationSize ArrivalObserver::getValue(const Event& event) const noexcept
+void ArrivalObserver::handleEvent(const Event&) noexcept
+{
+}
+void ArrivalObserver::save(const string& dir, const string& base_name) const
+{
+  scenario_.saveArrival(dir, makeName(base_name, "arrival"));
+}
+void ArrivalObserver::reset() noexcept
 {
-#ifdef DEBUG_TEMPORARY
-  if (abs(event.time() - 154.9987423154746) < 0.001)
-  {
-    printf("here\n");
-  }
-#endif
-  return event.time();
 }
 SourceObserver::SourceObserver(const Scenario& scenario)
   : MapObserver<CellIndex>(scenario, static_cast<CellIndex>(255), "source")
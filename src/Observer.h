@@ -6,7 +6,7 @@
 #include <memory>
 #include <string>
 #include "Event.h"
-#include "GridMap.h"
+#include "TiledGrid.h"
 #include "Scenario.h"
 namespace tbd::sim
 {
@@ -52,7 +52,7 @@ protected:
   IObserver() = default;
 };
 /**
- * \brief An IObserver that tracks notification data using a GridMap.
+ * \brief An IObserver that tracks notification data using a TiledGrid.
  * \tparam T Type of map that is being tracked
  */
 template <typename T>
@@ -72,7 +72,7 @@ public:
    * \param suffix Suffix to use on saved file
    */
   MapObserver(const Scenario& scenario, T nodata, string suffix)
-    : map_(scenario.model().environment().makeMap<T>(nodata)),
+    : map_(scenario.model().environment().makeTiledGrid<T>(nodata)),
       scenario_(scenario),
       suffix_(std::move(suffix))
   {
@@ -111,7 +111,7 @@ protected:
   /**
    * \brief Map of observations
    */
-  unique_ptr<data::GridMap<T>> map_;
+  unique_ptr<data::TiledGrid<T>> map_;
   /**
    * \brief Scenario being observed
    */
@@ -123,9 +123,12 @@ protected:
 };
 /**
  * \brief Tracks when fire initially arrives in a Cell.
+ *
+ * Scenario already needs arrival times to decide if points survive, so this saves those
+ * instead of keeping its own copy.
  */
 class ArrivalObserver final
-  : public MapObserver<DurationSize>
+  : public IObserver
 {
 public:
   ~ArrivalObserver() override = default;
@@ -137,8 +140,26 @@ public:
    * \brief Constructor
    * \param scenario Scenario to track
    */
-  explicit ArrivalObserver(const Scenario& scenario);
-  [[nodiscard]] DurationSize getValue(const Event& event) const noexcept override;
+  explicit ArrivalObserver(const Scenario& scenario) noexcept;
+  /**
+   * \brief Do nothing because Scenario records arrival when Cell burns
+   */
+  void handleEvent(const Event&) noexcept override;
+  /**
+   * \brief Save observations
+   * \param dir Directory to save to
+   * \param base_name Base file name to save to
+   */
+  void save(const string& dir, const string& base_name) const override;
+  /**
+   * \brief Do nothing because Scenario clears arrival when it resets
+   */
+  void reset() noexcept override;
+private:
+  /**
+   * \brief Scenario being observed
+   */
+  const Scenario& scenario_;
 };
 /**
  * \brief Tracks source Cell that fire arrived in Cell from.
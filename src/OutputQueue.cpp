@@ -0,0 +1,89 @@
+/* Copyright (c) His Majesty the King in Right of Canada as represented by the Minister of Natural Resources, 2024. */
+
+/* SPDX-License-Identifier: AGPL-3.0-or-later */
+
+#include "stdafx.h"
+#include "OutputQueue.h"
+#include "Log.h"
+namespace tbd::util
+{
+OutputQueue::OutputQueue(const size_t capacity)
+  : capacity_(max(capacity, static_cast<size_t>(1))),
+    thread_(&OutputQueue::work, this)
+{
+}
+OutputQueue::~OutputQueue()
+{
+  try
+  {
+    wait();
+    {
+      lock_guard<mutex> lock(mutex_);
+      stopping_ = true;
+    }
+    cv_.notify_all();
+    if (thread_.joinable())
+    {
+      thread_.join();
+    }
+  }
+  catch (const std::exception& ex)
+  {
+    logging::fatal(ex);
+    std::terminate();
+  }
+}
+void OutputQueue::submit(const void* key, const bool replaceable, Task task)
+{
+  {
+    std::unique_lock<mutex> lock(mutex_);
+    if (nullptr != key)
+    {
+      for (auto& entry : tasks_)
+      {
+        if (entry.replaceable && key == entry.key)
+        {
+          logging::debug("Replacing output that hasn't been written yet");
+          entry.replaceable = replaceable;
+          entry.task = std::move(task);
+          return;
+        }
+      }
+    }
+    cv_.wait(lock, [this] { return tasks_.size() < capacity_; });
+    tasks_.push_back({key, replaceable, std::move(task)});
+  }
+  cv_.notify_all();
+}
+void OutputQueue::wait()
+{
+  std::unique_lock<mutex> lock(mutex_);
+  cv_.wait(lock, [this] { return tasks_.empty() && !running_; });
+}
+void OutputQueue::work()
+{
+  while (true)
+  {
+    Task task{};
+    {
+      std::unique_lock<mutex> lock(mutex_);
+      cv_.wait(lock, [this] { return stopping_ || !tasks_.empty(); });
+      if (tasks_.empty())
+      {
+        return;
+      }
+      task = std::move(tasks_.front().task);
+      tasks_.pop_front();
+      running_ = true;
+    }
+    // queue has room again
+    cv_.notify_all();
+    task();
+    {
+      lock_guard<mutex> lock(mutex_);
+      running_ = false;
+    }
+    cv_.notify_all();
+  }
+}
+}
@@ -0,0 +1,103 @@
+/* Copyright (c) His Majesty the King in Right of Canada as represented by the Minister of Natural Resources, 2024. */
+
+/* SPDX-License-Identifier: AGPL-3.0-or-later */
+
+#pragma once
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+namespace tbd::util
+{
+/**
+ * \brief A background thread that runs output tasks in order, with a limit on how many
+ * can be waiting so that memory used by snapshots doesn't grow without bound.
+ */
+class OutputQueue
+{
+public:
+  /**
+   * \brief Function to run on the output thread
+   */
+  using Task = std::function<void()>;
+  /**
+   * \brief Start the output thread
+   * \param capacity Maximum number of tasks that can be waiting to run
+   */
+  explicit OutputQueue(size_t capacity);
+  /**
+   * \brief Wait for all tasks to finish and then stop the output thread
+   */
+  ~OutputQueue();
+  OutputQueue(const OutputQueue& rhs) = delete;
+  OutputQueue(OutputQueue&& rhs) = delete;
+  OutputQueue& operator=(const OutputQueue& rhs) = delete;
+  OutputQueue& operator=(OutputQueue&& rhs) = delete;
+  /**
+   * \brief Queue a task to run
+   *
+   * If a replaceable task with the same key is still waiting then it is replaced, since
+   * it would only be overwritten. Otherwise this blocks while the queue is full.
+   * \param key Identifies what the task writes, or nullptr if nothing should replace it
+   * \param replaceable Whether a later task with the same key can replace this one
+   * \param task Task to run
+   */
+  void submit(const void* key, bool replaceable, Task task);
+  /**
+   * \brief Block until there are no tasks queued or running
+   */
+  void wait();
+private:
+  /**
+   * \brief A task that is waiting to run
+   */
+  struct Entry
+  {
+    /**
+     * \brief Identifies what the task writes
+     */
+    const void* key;
+    /**
+     * \brief Whether a later task with the same key can replace this one
+     */
+    bool replaceable;
+    /**
+     * \brief Task to run
+     */
+    Task task;
+  };
+  /**
+   * \brief Run tasks until queue is stopped
+   */
+  void work();
+  /**
+   * \brief Maximum number of tasks that can be waiting to run
+   */
+  const size_t capacity_;
+  /**
+   * \brief Tasks waiting to run, in the order they were submitted
+   */
+  std::deque<Entry> tasks_{};
+  /**
+   * \brief Mutex for parallel access
+   */
+  std::mutex mutex_{};
+  /**
+   * \brief Signals that the queue changed
+   */
+  std::condition_variable cv_{};
+  /**
+   * \brief Whether a task is running right now
+   */
+  bool running_{false};
+  /**
+   * \brief Whether output thread should exit
+   */
+  bool stopping_{false};
+  /**
+   * \brief Output thread
+   */
+  std::thread thread_;
+};
+}
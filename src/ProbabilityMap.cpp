@@ -5,10 +5,13 @@
 
 #include "stdafx.h"
 #include "ProbabilityMap.h"
+#include <filesystem>
 #include "FBP45.h"
 #include "IntensityMap.h"
 #include "Model.h"
 #include "GridMap.h"
+#include "OutputQueue.h"
+namespace fs = std::filesystem;
 namespace tbd::sim
 {
 static constexpr size_t VALUE_UNPROCESSED = 2;
@@ -20,6 +23,37 @@ static constexpr size_t VALUE_PROCESSED = 4;
  */
 static set<string> PATHS_INTERIM{};
 static mutex PATHS_INTERIM_MUTEX{};
+/**
+ * \brief Replace output file with one that was written under a temporary name
+ * \param tmp_name Temporary file that was written
+ * \param filename File to replace
+ */
+static void replace_output(const string& tmp_name, const string& filename)
+{
+  std::error_code ec;
+  fs::rename(tmp_name, filename, ec);
+  if (ec)
+  {
+    logging::error("Unable to rename %s to %s: %s",
+                   tmp_name.c_str(),
+                   filename.c_str(),
+                   ec.message().c_str());
+    fs::remove(tmp_name, ec);
+  }
+}
+/**
+ * \brief Maximum number of snapshots that can be waiting to be written
+ */
+static constexpr size_t OUTPUT_QUEUE_CAPACITY = 4;
+/**
+ * \brief Queue that writes outputs in the background so simulations don't wait for them
+ * \return Queue that writes outputs in the background
+ */
+static util::OutputQueue& output_queue()
+{
+  static util::OutputQueue queue(OUTPUT_QUEUE_CAPACITY);
+  return queue;
+}
 
 ProbabilityMap::ProbabilityMap(const string dir_out,
                                const DurationSize time,
@@ -30,10 +64,7 @@ ProbabilityMap::ProbabilityMap(const string dir_out,
                                const int max_value,
                                const data::GridBase& grid_info)
   : dir_out_(dir_out),
-    all_(data::GridMap<size_t>(grid_info, 0)),
-    high_(data::GridMap<size_t>(grid_info, 0)),
-    med_(data::GridMap<size_t>(grid_info, 0)),
-    low_(data::GridMap<size_t>(grid_info, 0)),
+    merged_(grid_info),
     time_(time),
     start_time_(start_time),
     min_value_(min_value),
@@ -42,6 +73,17 @@ ProbabilityMap::ProbabilityMap(const string dir_out,
     med_max_(med_max),
     perimeter_(nullptr)
 {
+  const auto n = numShards();
+  shards_.reserve(n);
+  for (size_t i = 0; i < n; ++i)
+  {
+    shards_.push_back(make_unique<Shard>());
+  }
+}
+size_t ProbabilityMap::numShards() noexcept
+{
+  // simulations run on one worker per hardware thread
+  return max(static_cast<size_t>(std::thread::hardware_concurrency()), static_cast<size_t>(1));
 }
 ProbabilityMap* ProbabilityMap::copyEmpty() const
 {
@@ -52,12 +94,49 @@ ProbabilityMap* ProbabilityMap::copyEmpty() const
                             low_max_,
                             med_max_,
                             max_value_,
-                            all_);
+                            merged_.all);
 }
 void ProbabilityMap::setPerimeter(const topo::Perimeter* const perimeter)
 {
   perimeter_ = perimeter;
 }
+ProbabilityMap::Counts::Counts(const data::GridBase& grid_info)
+  : all(grid_info, 0),
+    high(grid_info, 0),
+    med(grid_info, 0),
+    low(grid_info, 0)
+{
+}
+/**
+ * \brief Add to the count for a Location
+ * \param grid Grid to add to
+ * \param location Location to add to
+ * \param value Amount to add
+ */
+static void add_count(data::TiledGrid<size_t>* grid,
+                      const Location& location,
+                      const size_t value)
+{
+  grid->set(location, grid->at(location) + value);
+}
+void ProbabilityMap::Counts::add(const Counts& rhs)
+{
+  if (Settings::saveIntensity())
+  {
+    low.add(rhs.low);
+    med.add(rhs.med);
+    high.add(rhs.high);
+  }
+  all.add(rhs.all);
+  sizes.insert(sizes.end(), rhs.sizes.cbegin(), rhs.sizes.cend());
+}
+ProbabilityMap::Shard& ProbabilityMap::shard() const noexcept
+{
+  // give each thread its own slot the first time it adds anything
+  static atomic<size_t> next_slot{0};
+  static thread_local const size_t slot = next_slot++;
+  return *shards_[slot % shards_.size()];
+}
 void ProbabilityMap::addProbabilities(const ProbabilityMap& rhs)
 {
 #ifndef DEBUG_PROBABILITY
@@ -69,53 +148,48 @@ void ProbabilityMap::addProbabilities(const ProbabilityMap& rhs)
   logging::check_fatal(rhs.med_max_ != med_max_, "Wrong med max value");
 #endif
   lock_guard<mutex> lock(mutex_);
-  if (Settings::saveIntensity())
+  const auto num_merged = merged_.sizes.size();
+  // add straight into merged results so rhs shards don't get copied into more shards
+  for (const auto& from : rhs.shards_)
   {
-    for (auto&& kv : rhs.low_.data)
+    lock_guard<mutex> lock_from(from->mutex);
+    if (nullptr == from->counts || from->counts->sizes.empty())
     {
-      low_.data[kv.first] += kv.second;
+      continue;
     }
-    for (auto&& kv : rhs.med_.data)
-    {
-      med_.data[kv.first] += kv.second;
-    }
-    for (auto&& kv : rhs.high_.data)
-    {
-      high_.data[kv.first] += kv.second;
-    }
-  }
-  for (auto&& kv : rhs.all_.data)
-  {
-    all_.data[kv.first] += kv.second;
-  }
-  for (auto size : rhs.sizes_)
-  {
-    static_cast<void>(util::insert_sorted(&sizes_, size));
+    merged_.add(*from->counts);
   }
+  // anything rhs already merged has to be added too
+  merged_.add(rhs.merged_);
+  const auto middle = merged_.sizes.begin() + static_cast<ptrdiff_t>(num_merged);
+  std::sort(middle, merged_.sizes.end());
+  std::inplace_merge(merged_.sizes.begin(), middle, merged_.sizes.end());
 }
 void ProbabilityMap::addProbability(const IntensityMap& for_time)
 {
-  lock_guard<mutex> lock(mutex_);
-  std::for_each(
-    for_time.cbegin(),
-    for_time.cend(),
-    [this](auto&& kv) {
-      const auto k = kv.first;
-      const auto v = kv.second;
-      all_.data[k] += 1;
+  auto& s = shard();
+  lock_guard<mutex> lock(s.mutex);
+  if (nullptr == s.counts)
+  {
+    s.counts = make_unique<Counts>(merged_.all);
+  }
+  auto& counts = *s.counts;
+  for_time.forEach(
+    [this, &counts](const Location& k, const IntensitySize v) {
+      add_count(&counts.all, k, 1);
       if (Settings::saveIntensity())
       {
         if (v >= min_value_ && v <= low_max_)
         {
-          low_.data[k] += 1;
+          add_count(&counts.low, k, 1);
         }
         else if (v > low_max_ && v <= med_max_)
         {
-          med_.data[k] += 1;
+          add_count(&counts.med, k, 1);
         }
         else if (v > med_max_ && v <= max_value_)
         {
-          high_.data[k] += 1;
+          add_count(&counts.high, k, 1);
         }
         else
         {
@@ -123,23 +197,48 @@ void ProbabilityMap::addProbability(const IntensityMap& for_time)
         }
       }
     });
-  const auto size = for_time.fireSize();
-  static_cast<void>(util::insert_sorted(&sizes_, size));
+  counts.sizes.push_back(for_time.fireSize());
+}
+void ProbabilityMap::merge() const
+{
+  const auto num_merged = merged_.sizes.size();
+  for (auto& s : shards_)
+  {
+    lock_guard<mutex> lock(s->mutex);
+    if (nullptr == s->counts || s->counts->sizes.empty())
+    {
+      continue;
+    }
+    merged_.add(*s->counts);
+    // release tiles so memory doesn't build up in shards that might not be used again
+    s->counts = nullptr;
+  }
+  // sort new sizes and then combine with the ones that were already sorted
+  const auto middle = merged_.sizes.begin() + static_cast<ptrdiff_t>(num_merged);
+  std::sort(middle, merged_.sizes.end());
+  std::inplace_merge(merged_.sizes.begin(), middle, merged_.sizes.end());
 }
 vector<MathSize> ProbabilityMap::getSizes() const
 {
-  return sizes_;
+  // merge() can be adding to sizes from another thread
+  lock_guard<mutex> lock(mutex_);
+  return merged_.sizes;
 }
 util::Statistics ProbabilityMap::getStatistics() const
 {
   return util::Statistics{getSizes()};
 }
-size_t ProbabilityMap::numSizes() const noexcept
+size_t ProbabilityMap::numSizes() const
 {
-  return sizes_.size();
+  lock_guard<mutex> lock(mutex_);
+  return merged_.sizes.size();
 }
 void ProbabilityMap::show() const
 {
+  {
+    lock_guard<mutex> lock(mutex_);
+    merge();
+  }
   // even if we only ran the actuals we'll still have multiple scenarios
   // with different randomThreshold values
   const auto day = static_cast<int>(time_ - floor(start_time_));
@@ -152,7 +251,7 @@ void ProbabilityMap::show() const
     s.mean(),
     s.median());
 }
-bool ProbabilityMap::record_if_interim(const char* filename) const
+bool ProbabilityMap::record_if_interim(const char* filename)
 {
   lock_guard<mutex> lock(PATHS_INTERIM_MUTEX);
   logging::verbose("Checking if %s is interim", filename);
@@ -168,23 +267,20 @@ bool ProbabilityMap::record_if_interim(const char* filename) const
   }
   return false;
 }
-void ProbabilityMap::saveSizes(const string& base_name) const
+void ProbabilityMap::Snapshot::saveSizes(const string& base_name) const
 {
-  ofstream out;
-  string filename = dir_out_ + base_name + ".csv";
+  const string filename = dir_out + base_name + ".csv";
+  const string tmp_name = dir_out + "." + base_name + ".tmp.csv";
   record_if_interim(filename.c_str());
-  out.open(filename.c_str());
-  auto sizes = getSizes();
-  if (!sizes.empty())
   {
-    // don't want to modify original array so that we can still lookup in correct order
-    sort(sizes.begin(), sizes.end());
-  }
-  for (const auto& s : sizes)
-  {
-    out << s << "\n";
+    ofstream out(tmp_name.c_str());
+    // sizes are already sorted when they're merged
+    for (const auto& s : sizes)
+    {
+      out << s << "\n";
+    }
   }
-  out.close();
+  replace_output(tmp_name, filename);
 }
 string make_string(const char* name, const tm& t, const int day)
 {
@@ -199,8 +295,14 @@ string make_string(const char* name, const tm& t, const int day)
            t.tm_mday);
   return string(tmp);
 };
+void ProbabilityMap::waitForSaves()
+{
+  output_queue().wait();
+}
 void ProbabilityMap::deleteInterim()
 {
+  // interim saves that are still queued would write files after they're deleted
+  waitForSaves();
   lock_guard<mutex> lock(PATHS_INTERIM_MUTEX);
   for (const auto& path : PATHS_INTERIM)
   {
@@ -209,8 +311,8 @@ void ProbabilityMap::deleteInterim()
     {
       try
       {
-#ifdef _WIN32
-        _unlink(path.c_str());
+#ifdef _WIN32
+        _unlink(path.c_str());
 #else
         unlink(path.c_str());
 #endif
@@ -228,7 +330,14 @@ void ProbabilityMap::saveAll(const tm& start_time,
                              const DurationSize time,
                              const bool is_interim) const
 {
-  lock_guard<mutex> lock(mutex_);
+  shared_ptr<const Snapshot> snapshot{};
+  {
+    // only hold lock long enough to copy so adding isn't blocked while writing
+    lock_guard<mutex> lock(mutex_);
+    merge();
+    snapshot = make_shared<const Snapshot>(
+      Snapshot{dir_out_, perimeter_, merged_.all, merged_.high, merged_.med, merged_.low, merged_.sizes});
+  }
   auto t = start_time;
   auto ticks = mktime(&t);
   const auto day = static_cast<int>(round(time));
@@ -238,103 +347,144 @@ void ProbabilityMap::saveAll(const tm& start_time,
     auto text = (is_interim ? "interim_" : "") + prefix;
     return make_string(text.c_str(), t, day);
   };
-  if (sim::Settings::runAsync())
-  {
-    vector<std::future<void>> results{};
-    if (Settings::saveProbability())
-    {
-      results.push_back(async(launch::async,
-                              &ProbabilityMap::saveTotal,
-                              this,
-                              fix_string("probability"),
-                              is_interim));
-    }
-    if (Settings::saveOccurrence())
-    {
-      results.push_back(async(launch::async,
-                              &ProbabilityMap::saveTotalCount,
-                              this,
-                              fix_string("occurrence")));
-    }
-    if (Settings::saveIntensity())
-    {
-      results.push_back(async(launch::async,
-                              &ProbabilityMap::saveLow,
-                              this,
-                              fix_string("intensity_L")));
-      results.push_back(async(launch::async,
-                              &ProbabilityMap::saveModerate,
-                              this,
-                              fix_string("intensity_M")));
-      results.push_back(async(launch::async,
-                              &ProbabilityMap::saveHigh,
-                              this,
-                              fix_string("intensity_H")));
-    }
-    results.push_back(async(launch::async,
-                            &ProbabilityMap::saveSizes,
-                            this,
-                            fix_string("sizes")));
-    for (auto& result : results)
-    {
-      result.wait();
-    }
-  }
-  else
+  // work out names now since they depend on when this was called
+  const auto name_probability = fix_string("probability");
+  const auto name_occurrence = fix_string("occurrence");
+  const auto name_low = fix_string("intensity_L");
+  const auto name_moderate = fix_string("intensity_M");
+  const auto name_high = fix_string("intensity_H");
+  const auto name_sizes = fix_string("sizes");
+  // a newer interim save for the same map makes an older one that isn't written yet pointless
+  output_queue().submit(
+    this,
+    is_interim,
+    [=]() {
+      if (sim::Settings::runAsync())
+      {
+        vector<std::future<void>> results{};
+        if (Settings::saveProbability())
+        {
+          results.push_back(async(launch::async,
+                                  &Snapshot::saveTotal,
+                                  snapshot,
+                                  name_probability,
+                                  is_interim));
+        }
+        if (Settings::saveOccurrence())
+        {
+          results.push_back(async(launch::async,
+                                  &Snapshot::saveTotalCount,
+                                  snapshot,
+                                  name_occurrence));
+        }
+        if (Settings::saveIntensity())
+        {
+          results.push_back(async(launch::async,
+                                  &Snapshot::saveLow,
+                                  snapshot,
+                                  name_low));
+          results.push_back(async(launch::async,
+                                  &Snapshot::saveModerate,
+                                  snapshot,
+                                  name_moderate));
+          results.push_back(async(launch::async,
+                                  &Snapshot::saveHigh,
+                                  snapshot,
+                                  name_high));
+        }
+        results.push_back(async(launch::async,
+                                &Snapshot::saveSizes,
+                                snapshot,
+                                name_sizes));
+        for (auto& result : results)
+        {
+          result.wait();
+        }
+      }
+      else
+      {
+        if (Settings::saveProbability())
+        {
+          snapshot->saveTotal(name_probability, is_interim);
+        }
+        if (Settings::saveOccurrence())
+        {
+          snapshot->saveTotalCount(name_occurrence);
+        }
+        if (Settings::saveIntensity())
+        {
+          snapshot->saveLow(name_low);
+          snapshot->saveModerate(name_moderate);
+          snapshot->saveHigh(name_high);
+        }
+        snapshot->saveSizes(name_sizes);
+      }
+    });
+}
+template <class R>
+string ProbabilityMap::Snapshot::saveToProbabilityFile(const data::TiledGrid<size_t>& grid,
+                                                       const string& base_name,
+                                                       const R divisor) const
+{
+  // write under a hidden temporary name so nothing reading outputs sees a partial file
+  const auto tmp_base = "." + base_name + ".tmp";
+  const auto tmp_name = grid.saveToProbabilityFile(dir_out, tmp_base, divisor);
+  const auto extension = tmp_name.substr(tmp_name.find_last_of('.'));
+  const auto filename = dir_out + base_name + extension;
+  record_if_interim(filename.c_str());
+  // .asc files have a .prj next to them
+  const auto tmp_prj = dir_out + tmp_base + ".prj";
+  if (util::file_exists(tmp_prj.c_str()))
   {
-    if (Settings::saveProbability())
-    {
-      saveTotal(fix_string("probability"), is_interim);
-    }
-    if (Settings::saveOccurrence())
-    {
-      saveTotalCount(fix_string("occurrence"));
-    }
-    if (Settings::saveIntensity())
-    {
-      saveLow(fix_string("intensity_L"));
-      saveModerate(fix_string("intensity_M"));
-      saveHigh(fix_string("intensity_H"));
-    }
-    saveSizes(fix_string("sizes"));
+    const auto prj = dir_out + base_name + ".prj";
+    record_if_interim(prj.c_str());
+    replace_output(tmp_prj, prj);
   }
+  replace_output(tmp_name, filename);
+  return filename;
 }
-void ProbabilityMap::saveTotal(const string& base_name, const bool is_interim) const
+void ProbabilityMap::Snapshot::saveTotal(const string& base_name, const bool is_interim) const
 {
   // FIX: do this for other outputs too
-  auto with_perim = all_;
-  if (nullptr != perimeter_)
+  auto with_perim = all;
+  if (nullptr != perimeter)
   {
-    for (auto loc : perimeter_->burned())
+    for (auto loc : perimeter->burned())
     {
       // multiply initial perimeter cells so that probability shows processing status
-      with_perim.data[loc] *= (is_interim ? VALUE_PROCESSING : VALUE_PROCESSED);
+      with_perim.set(loc, with_perim.at(loc) * (is_interim ? VALUE_PROCESSING : VALUE_PROCESSED));
     }
   }
-  saveToProbabilityFile<float>(with_perim, dir_out_, base_name, static_cast<float>(numSizes()));
+  saveToProbabilityFile<float>(with_perim, base_name, static_cast<float>(sizes.size()));
 }
-void ProbabilityMap::saveTotalCount(const string& base_name) const
+void ProbabilityMap::Snapshot::saveTotalCount(const string& base_name) const
 {
-  saveToProbabilityFile<uint32_t>(all_, dir_out_, base_name, 1);
+  saveToProbabilityFile<uint32_t>(all, base_name, 1);
 }
-void ProbabilityMap::saveHigh(const string& base_name) const
+void ProbabilityMap::Snapshot::saveHigh(const string& base_name) const
 {
-  saveToProbabilityFile<float>(high_, dir_out_, base_name, static_cast<float>(numSizes()));
+  saveToProbabilityFile<float>(high, base_name, static_cast<float>(sizes.size()));
 }
-void ProbabilityMap::saveModerate(const string& base_name) const
+void ProbabilityMap::Snapshot::saveModerate(const string& base_name) const
 {
-  saveToProbabilityFile<float>(med_, dir_out_, base_name, static_cast<float>(numSizes()));
+  saveToProbabilityFile<float>(med, base_name, static_cast<float>(sizes.size()));
 }
-void ProbabilityMap::saveLow(const string& base_name) const
+void ProbabilityMap::Snapshot::saveLow(const string& base_name) const
 {
-  saveToProbabilityFile<float>(low_, dir_out_, base_name, static_cast<float>(numSizes()));
+  saveToProbabilityFile<float>(low, base_name, static_cast<float>(sizes.size()));
 }
 void ProbabilityMap::reset()
 {
-  all_.clear();
-  low_.clear();
-  med_.clear();
-  high_.clear();
-  sizes_.clear();
+  for (auto& s : shards_)
+  {
+    lock_guard<mutex> lock(s->mutex);
+    s->counts = nullptr;
+  }
+  lock_guard<mutex> lock(mutex_);
+  merged_.all.clear();
+  merged_.low.clear();
+  merged_.med.clear();
+  merged_.high.clear();
+  merged_.sizes.clear();
 }
 }
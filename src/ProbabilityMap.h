@@ -4,9 +4,11 @@
 /* SPDX-License-Identifier: AGPL-3.0-or-later */
 
 #pragma once
+#include <array>
 #include <string>
 #include <vector>
 #include "GridMap.h"
+#include "TiledGrid.h"
 #include "Statistics.h"
 #include "Perimeter.h"
 namespace tbd
@@ -80,53 +82,31 @@ public:
    * \brief Number of sizes that have been added
    * \return Number of sizes that have been added
    */
-  [[nodiscard]] size_t numSizes() const noexcept;
+  [[nodiscard]] size_t numSizes() const;
   /**
    * \brief Output Statistics to log
    */
   void show() const;
-  /**
-   * \brief Save list of sizes
-   * \param base_name Base name of file to save into
-   */
-  void saveSizes(const string& base_name) const;
   /**
    * \brief Save total, low, moderate, and high maps, and output information to log
+   *
+   * Copies the current counts and writes them on the output thread, so this only
+   * blocks while copying. Use waitForSaves() to know when files have been written.
    * \param start_time Start time of simulation
    * \param time Time for these maps
+   * \param is_interim Whether this is an interim save that can be replaced by a later one
    */
   void saveAll(const tm& start_time,
                DurationSize time,
                const bool is_interim) const;
-  /**
-   * \brief Save map representing all intensities
-   * \param base_name Base file name to save to
-   */
-  void saveTotal(const string& base_name, const bool is_interim) const;
-  /**
-   * \brief Save map representing all intensities occurrence
-   * \param base_name Base file name to save to
-   */
-  void saveTotalCount(const string& base_name) const;
-  /**
-   * \brief Save map representing high intensities
-   * \param base_name Base file name to save to
-   */
-  void saveHigh(const string& base_name) const;
-  /**
-   * \brief Save map representing moderate intensities
-   * \param base_name Base file name to save to
-   */
-  void saveModerate(const string& base_name) const;
-  /**
-   * \brief Save map representing low intensities
-   * \param base_name Base file name to save to
-   */
-  void saveLow(const string& base_name) const;
   /**
    * \brief Clear maps and return to initial state
    */
   void reset();
+  /**
+   * \brief Block until everything passed to saveAll() has been written
+   */
+  static void waitForSaves();
   /**
    * Delete interim output files
    */
@@ -135,45 +115,159 @@ private:
   /**
    * \brief Make note of any interim files for later deletion
    */
-  bool record_if_interim(const char* filename) const;
+  static bool record_if_interim(const char* filename);
   /**
-   * \brief Save probability file and record filename if interim
-   * \return Path for file that was written
+   * \brief Copy of merged counts that can be written while simulations keep adding more
    */
-  template <class R>
-  string saveToProbabilityFile(const data::GridMap<size_t>& grid,
-                               const string& dir,
-                               const string& base_name,
-                               const R divisor) const
+  struct Snapshot
   {
-    const string filename = grid.saveToProbabilityFile(dir, base_name, divisor);
-    record_if_interim(filename.c_str());
-    return filename;
+    /**
+     * \brief Save list of sizes
+     * \param base_name Base name of file to save into
+     */
+    void saveSizes(const string& base_name) const;
+    /**
+     * \brief Save map representing all intensities
+     * \param base_name Base file name to save to
+     * \param is_interim Whether perimeter should be marked as still processing
+     */
+    void saveTotal(const string& base_name, const bool is_interim) const;
+    /**
+     * \brief Save map representing all intensities occurrence
+     * \param base_name Base file name to save to
+     */
+    void saveTotalCount(const string& base_name) const;
+    /**
+     * \brief Save map representing high intensities
+     * \param base_name Base file name to save to
+     */
+    void saveHigh(const string& base_name) const;
+    /**
+     * \brief Save map representing moderate intensities
+     * \param base_name Base file name to save to
+     */
+    void saveModerate(const string& base_name) const;
+    /**
+     * \brief Save map representing low intensities
+     * \param base_name Base file name to save to
+     */
+    void saveLow(const string& base_name) const;
+    /**
+     * \brief Save probability file under a temporary name and then rename it
+     * \return Path for file that was written
+     */
+    template <class R>
+    string saveToProbabilityFile(const data::TiledGrid<size_t>& grid,
+                                 const string& base_name,
+                                 const R divisor) const;
+    /**
+     * \brief Directory to write outputs to
+     */
+    string dir_out;
+    /**
+     * \brief Initial ignition grid to apply to outputs
+     */
+    const topo::Perimeter* perimeter;
+    /**
+     * \brief Map representing all intensities
+     */
+    data::TiledGrid<size_t> all;
+    /**
+     * \brief Map representing high intensities
+     */
+    data::TiledGrid<size_t> high;
+    /**
+     * \brief Map representing moderate intensities
+     */
+    data::TiledGrid<size_t> med;
+    /**
+     * \brief Map representing low intensities
+     */
+    data::TiledGrid<size_t> low;
+    /**
+     * \brief Sorted list of sizes for perimeters that have been added
+     */
+    vector<MathSize> sizes;
   };
+  /**
+   * \brief Combine everything that has been added to shards into the merged results
+   *
+   * Expects mutex_ to already be locked.
+   */
+  void merge() const;
   /**
    * \brief Directory to write outputs to
    */
   const string dir_out_;
   /**
-   * \brief Map representing all intensities
+   * \brief Counts for IntensityMaps that have been added
    */
-  data::GridMap<size_t> all_;
+  struct Counts
+  {
+    /**
+     * \brief Construct with the same extent as the given grid
+     * \param grid_info Grid to use extent from
+     */
+    explicit Counts(const data::GridBase& grid_info);
+    /**
+     * \brief Add counts and sizes from other Counts tile by tile
+     * \param rhs Counts to add from
+     */
+    void add(const Counts& rhs);
+    /**
+     * \brief Counts for all intensities
+     */
+    data::TiledGrid<size_t> all;
+    /**
+     * \brief Counts for high intensities
+     */
+    data::TiledGrid<size_t> high;
+    /**
+     * \brief Counts for moderate intensities
+     */
+    data::TiledGrid<size_t> med;
+    /**
+     * \brief Counts for low intensities
+     */
+    data::TiledGrid<size_t> low;
+    /**
+     * \brief Sizes for perimeters that have been added, which are only sorted once merged
+     */
+    vector<MathSize> sizes{};
+  };
+  /**
+   * \brief Counts used by a subset of threads so they don't contend with each other
+   */
+  struct Shard
+  {
+    /**
+     * \brief Mutex for parallel access
+     */
+    std::mutex mutex{};
+    /**
+     * \brief Counts for this Shard, which are only allocated once something is added
+     * and released once they're merged
+     */
+    unique_ptr<Counts> counts{};
+  };
   /**
-   * \brief Map representing high intensities
+   * \brief Number of Shards that threads are spread across, which is one per worker
+   * \return Number of Shards that threads are spread across
    */
-  data::GridMap<size_t> high_;
+  [[nodiscard]] static size_t numShards() noexcept;
   /**
-   * \brief Map representing moderate intensities
+   * \brief Shard that the calling thread adds to
+   * \return Shard that the calling thread adds to
    */
-  data::GridMap<size_t> med_;
+  [[nodiscard]] Shard& shard() const noexcept;
   /**
-   * \brief Map representing low intensities
+   * \brief Counts that have been merged from all Shards, with sizes sorted
    */
-  data::GridMap<size_t> low_;
+  mutable Counts merged_;
   /**
-   * \brief List of sizes for perimeters that have been added
+   * \brief Counts that haven't been merged yet, by thread
    */
-  vector<MathSize> sizes_{};
+  mutable vector<unique_ptr<Shard>> shards_{};
   /**
    * \brief Time in simulation this ProbabilityMap represents
    */
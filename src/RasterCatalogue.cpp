@@ -0,0 +1,303 @@
+/* Copyright (c) His Majesty the King in Right of Canada as represented by the Minister of Natural Resources, 2024. */
+
+/* SPDX-License-Identifier: AGPL-3.0-or-later */
+
+#include "stdafx.h"
+#include "RasterCatalogue.h"
+#include <cmath>
+#include <cstdio>
+#include "EnvironmentInfo.h"
+#include "UTM.h"
+#ifdef _WIN32
+#include <process.h>
+#else
+#include <unistd.h>
+#endif
+namespace tbd::topo
+{
+/**
+ * \brief First line of catalogue file, which needs to change if the format does
+ */
+static const string CATALOGUE_VERSION = "FireSTARR raster catalogue 2";
+/**
+ * \brief Margin added around raster bounds so edges that curve in lat/long are covered (decimal degrees)
+ */
+static constexpr MathSize BOUNDS_MARGIN = 0.1;
+/**
+ * \brief Number of points along each edge of raster to use when finding bounds
+ */
+static constexpr int BOUNDS_SAMPLES = 8;
+/**
+ * \brief Modification time of a file or directory
+ * \param path Path to check
+ * \return Modification time, or -1 if it does not exist
+ */
+static int64_t modified_time(const string& path)
+{
+  struct stat info
+  {
+  };
+  if (0 != stat(path.c_str(), &info))
+  {
+    return -1;
+  }
+  return static_cast<int64_t>(info.st_mtime);
+}
+/**
+ * \brief Key for the 1 degree square that a lat/long is in
+ */
+static int64_t index_key(const MathSize latitude, const MathSize longitude)
+{
+  return static_cast<int64_t>(floor(latitude)) * 1000 + static_cast<int64_t>(floor(longitude));
+}
+RasterCatalogue::RasterCatalogue(const string& path, const int year)
+  : raster_root_(util::find_raster_root(path, year)),
+    file_name_(raster_root_ + "/rasters.catalogue"),
+    changed_(false)
+{
+  const auto has_file = read();
+  auto fuels = util::find_rasters(path, year);
+  for (auto& fuel : fuels)
+  {
+    // make sure we're using a consistent directory separator
+    std::replace(fuel.begin(), fuel.end(), '\\', '/');
+  }
+  // catalogue and .cells files are written into this directory, so its modification
+  // time always changes and only the list of rasters in it says if it needs updating
+  const auto same_rasters = has_file
+                         && fuels.size() == entries_.size()
+                         && std::all_of(fuels.begin(),
+                                        fuels.end(),
+                                        [this](const string& fuel) {
+                                          return entries_.end()
+                                              != std::find_if(entries_.begin(),
+                                                              entries_.end(),
+                                                              [&fuel](const RasterEntry& e) { return e.fuel == fuel; });
+                                        });
+  if (!same_rasters)
+  {
+    // rasters were added or removed, so update list but keep entries that exist
+    logging::note("Updating raster catalogue for %s", raster_root_.c_str());
+    vector<RasterEntry> entries{};
+    for (const auto& fuel : fuels)
+    {
+      const auto existing = std::find_if(entries_.begin(),
+                                         entries_.end(),
+                                         [&fuel](const RasterEntry& e) { return e.fuel == fuel; });
+      if (entries_.end() != existing
+          && existing->fuel_modified == modified_time(existing->fuel)
+          && existing->elevation_modified == modified_time(existing->elevation))
+      {
+        entries.emplace_back(std::move(*existing));
+      }
+      else
+      {
+        entries.emplace_back(readEntry(fuel));
+      }
+    }
+    entries_ = std::move(entries);
+    changed_ = true;
+  }
+  // changes to rasters that are still listed get picked up by find() when they're used
+  index();
+  save();
+}
+vector<const RasterEntry*> RasterCatalogue::find(const Point& point)
+{
+  vector<const RasterEntry*> result{};
+  const auto it = index_.find(index_key(point.latitude(), point.longitude()));
+  if (index_.end() != it)
+  {
+    auto reindex = false;
+    for (const auto i : it->second)
+    {
+      auto& entry = entries_[i];
+      if (entry.fuel_modified != modified_time(entry.fuel)
+          || entry.elevation_modified != modified_time(entry.elevation))
+      {
+        logging::note("Raster %s has changed so reading header again", entry.fuel.c_str());
+        entry = readEntry(entry.fuel);
+        changed_ = true;
+        reindex = true;
+      }
+    }
+    if (reindex)
+    {
+      index();
+      save();
+      return find(point);
+    }
+    for (const auto i : it->second)
+    {
+      const auto& entry = entries_[i];
+      if (entry.min_latitude <= point.latitude()
+          && point.latitude() <= entry.max_latitude
+          && entry.min_longitude <= point.longitude()
+          && point.longitude() <= entry.max_longitude)
+      {
+        result.emplace_back(&entry);
+      }
+    }
+  }
+  logging::debug("Found %ld possible rasters for (%f, %f) in catalogue of %ld rasters",
+                 result.size(),
+                 point.latitude(),
+                 point.longitude(),
+                 entries_.size());
+  return result;
+}
+RasterEntry RasterCatalogue::readEntry(const string& fuel)
+{
+  const auto elevation = EnvironmentInfo::elevationFor(fuel);
+  // use same checks as loading so we don't list anything that wouldn't load
+  const auto info = EnvironmentInfo::loadInfo(fuel, elevation);
+  const auto& grid = info->gridInfo();
+  auto min_latitude = numeric_limits<MathSize>::max();
+  auto min_longitude = numeric_limits<MathSize>::max();
+  auto max_latitude = numeric_limits<MathSize>::lowest();
+  auto max_longitude = numeric_limits<MathSize>::lowest();
+  const auto include = [&](const MathSize x, const MathSize y) {
+    const auto p = to_lat_long(grid.proj4(), x, y);
+    min_latitude = min(min_latitude, p.latitude());
+    min_longitude = min(min_longitude, p.longitude());
+    max_latitude = max(max_latitude, p.latitude());
+    max_longitude = max(max_longitude, p.longitude());
+  };
+  // edges of a UTM raster curve in lat/long, so check along them and not just corners
+  for (auto i = 0; i <= BOUNDS_SAMPLES; ++i)
+  {
+    const auto x = grid.xllcorner() + (grid.xurcorner() - grid.xllcorner()) * i / BOUNDS_SAMPLES;
+    const auto y = grid.yllcorner() + (grid.yurcorner() - grid.yllcorner()) * i / BOUNDS_SAMPLES;
+    include(x, grid.yllcorner());
+    include(x, grid.yurcorner());
+    include(grid.xllcorner(), y);
+    include(grid.xurcorner(), y);
+  }
+  return {
+    fuel,
+    elevation,
+    modified_time(fuel),
+    modified_time(elevation),
+    grid,
+    min_latitude - BOUNDS_MARGIN,
+    min_longitude - BOUNDS_MARGIN,
+    max_latitude + BOUNDS_MARGIN,
+    max_longitude + BOUNDS_MARGIN};
+}
+bool RasterCatalogue::read()
+{
+  ifstream in(file_name_);
+  if (!in.good())
+  {
+    return false;
+  }
+  string line;
+  if (!getline(in, line) || CATALOGUE_VERSION != line)
+  {
+    logging::warning("Ignoring invalid raster catalogue %s", file_name_.c_str());
+    return false;
+  }
+  try
+  {
+    while (getline(in, line))
+    {
+      vector<string> fields{};
+      istringstream iss(line);
+      string field;
+      while (getline(iss, field, '\t'))
+      {
+        fields.emplace_back(field);
+      }
+      if (14 != fields.size())
+      {
+        throw runtime_error("Expected 14 fields but got " + to_string(fields.size()));
+      }
+      entries_.push_back({fields[0],
+                          fields[1],
+                          stol(fields[2]),
+                          stol(fields[3]),
+                          data::GridBase(stod(fields[4]),
+                                         stod(fields[5]),
+                                         stod(fields[6]),
+                                         stod(fields[7]),
+                                         stod(fields[8]),
+                                         string(fields[13])),
+                          stod(fields[9]),
+                          stod(fields[10]),
+                          stod(fields[11]),
+                          stod(fields[12])});
+    }
+  }
+  catch (const std::exception& ex)
+  {
+    logging::warning("Ignoring invalid raster catalogue %s: %s", file_name_.c_str(), ex.what());
+    entries_.clear();
+    return false;
+  }
+  return true;
+}
+void RasterCatalogue::save()
+{
+  if (!changed_)
+  {
+    return;
+  }
+  // write to temporary file and rename so other processes never read a partial file
+#ifdef _WIN32
+  const auto pid = _getpid();
+#else
+  const auto pid = getpid();
+#endif
+  const auto tmp_name = file_name_ + "." + to_string(pid) + ".tmp";
+  {
+    ofstream out(tmp_name);
+    if (!out.good())
+    {
+      logging::warning("Unable to save raster catalogue %s", file_name_.c_str());
+      return;
+    }
+    // need enough digits that values are exactly the same when read back
+    out << setprecision(17);
+    out << CATALOGUE_VERSION << "\n";
+    for (const auto& e : entries_)
+    {
+      out << e.fuel << "\t"
+          << e.elevation << "\t"
+          << e.fuel_modified << "\t"
+          << e.elevation_modified << "\t"
+          << e.grid.cellSize() << "\t"
+          << e.grid.xllcorner() << "\t"
+          << e.grid.yllcorner() << "\t"
+          << e.grid.xurcorner() << "\t"
+          << e.grid.yurcorner() << "\t"
+          << e.min_latitude << "\t"
+          << e.min_longitude << "\t"
+          << e.max_latitude << "\t"
+          << e.max_longitude << "\t"
+          << e.grid.proj4() << "\n";
+    }
+  }
+  if (0 != std::rename(tmp_name.c_str(), file_name_.c_str()))
+  {
+    logging::warning("Unable to save raster catalogue %s", file_name_.c_str());
+    std::remove(tmp_name.c_str());
+    return;
+  }
+  changed_ = false;
+}
+void RasterCatalogue::index()
+{
+  index_.clear();
+  for (size_t i = 0; i < entries_.size(); ++i)
+  {
+    const auto& e = entries_[i];
+    for (auto lat = floor(e.min_latitude); lat <= e.max_latitude; ++lat)
+    {
+      for (auto lon = floor(e.min_longitude); lon <= e.max_longitude; ++lon)
+      {
+        index_[index_key(lat, lon)].emplace_back(i);
+      }
+    }
+  }
+}
+}
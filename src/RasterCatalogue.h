@@ -0,0 +1,118 @@
+/* Copyright (c) His Majesty the King in Right of Canada as represented by the Minister of Natural Resources, 2024. */
+
+/* SPDX-License-Identifier: AGPL-3.0-or-later */
+
+#pragma once
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "Grid.h"
+#include "Point.h"
+namespace tbd::topo
+{
+/**
+ * \brief A fuel raster and its elevation raster, as listed in a RasterCatalogue
+ */
+struct RasterEntry
+{
+  /**
+   * \brief Fuel raster path
+   */
+  string fuel;
+  /**
+   * \brief Elevation raster path
+   */
+  string elevation;
+  /**
+   * \brief Modification time of fuel raster when header was read
+   */
+  int64_t fuel_modified;
+  /**
+   * \brief Modification time of elevation raster when header was read
+   */
+  int64_t elevation_modified;
+  /**
+   * \brief Extent and projection of rasters
+   */
+  data::GridBase grid;
+  /**
+   * \brief Southern edge of raster, with a margin (decimal degrees)
+   */
+  MathSize min_latitude;
+  /**
+   * \brief Western edge of raster, with a margin (decimal degrees)
+   */
+  MathSize min_longitude;
+  /**
+   * \brief Northern edge of raster, with a margin (decimal degrees)
+   */
+  MathSize max_latitude;
+  /**
+   * \brief Eastern edge of raster, with a margin (decimal degrees)
+   */
+  MathSize max_longitude;
+};
+/**
+ * \brief List of rasters in a directory with their extents, so the rasters that
+ * could contain a Point can be found without reading every raster header.
+ *
+ * The list is saved in the raster directory and gets updated when rasters are added,
+ * removed, or modified.
+ */
+class RasterCatalogue
+{
+public:
+  /**
+   * \brief Load catalogue for rasters in directory, updating it if anything has changed
+   * \param path Root directory to look for rasters in
+   * \param year Year to use rasters for if available, else default
+   */
+  RasterCatalogue(const string& path, int year);
+  /**
+   * \brief Find rasters that could contain Point, rereading headers for any that changed
+   * \param point Point to find rasters for
+   * \return Rasters that could contain Point
+   */
+  [[nodiscard]] vector<const RasterEntry*> find(const Point& point);
+private:
+  /**
+   * \brief Read header for rasters and determine their bounds
+   * \param fuel Fuel raster path
+   * \return Catalogue entry for raster
+   */
+  [[nodiscard]] static RasterEntry readEntry(const string& fuel);
+  /**
+   * \brief Read catalogue file
+   * \return Whether file was read
+   */
+  bool read();
+  /**
+   * \brief Save catalogue file if it has changed
+   */
+  void save();
+  /**
+   * \brief Build index from bounds of all entries
+   */
+  void index();
+  /**
+   * \brief Directory rasters are in
+   */
+  string raster_root_;
+  /**
+   * \brief Catalogue file
+   */
+  string file_name_;
+  /**
+   * \brief Rasters in directory
+   */
+  vector<RasterEntry> entries_;
+  /**
+   * \brief Entries that overlap each 1 degree square, keyed by square
+   */
+  unordered_map<int64_t, vector<size_t>> index_;
+  /**
+   * \brief Whether catalogue has changed since it was read
+   */
+  bool changed_;
+};
+}
@@ -20,6 +20,7 @@
 #include "Location.h"
 #include "Cell.h"
 #include "LogPoints.h"
+#include "WorkerPool.h"
 
 namespace tbd::sim
 {
@@ -31,30 +32,31 @@ using topo::StartPoint;
 
 constexpr auto CELL_CENTER = static_cast<InnerSize>(0.5);
 constexpr auto PRECISION = static_cast<MathSize>(0.001);
+/**
+ * \brief Largest allocation that Scenario memory keeps pools for, which needs to fit offsets for a SpreadKey
+ */
+constexpr size_t MAX_POOLED_BLOCK = static_cast<size_t>(64) * 1024;
 static atomic<size_t> COUNT = 0;
 static atomic<size_t> COMPLETED = 0;
 static atomic<size_t> TOTAL_STEPS = 0;
 static std::mutex MUTEX_SIM_COUNTS;
 static map<size_t, size_t> SIM_COUNTS{};
 
-template <typename T, typename F>
-void do_each(T& for_list, F fct)
-{
-  std::for_each(
-    std::execution::seq,
-    for_list.begin(),
-    for_list.end(),
-    fct);
-}
-
-template <typename T, typename F>
-void do_par(T& for_list, F fct)
+/**
+ * \brief Pool to spread in parallel with, which is the pool running the Scenario if
+ * there is one so that spreading only uses workers that would otherwise be idle
+ * \return Pool to spread in parallel with
+ */
+static util::WorkerPool& spread_pool()
 {
-  std::for_each(
-    std::execution::par_unseq,
-    for_list.begin(),
-    for_list.end(),
-    fct);
+  const auto pool = util::WorkerPool::current();
+  if (nullptr != pool)
+  {
+    return *pool;
+  }
+  static util::WorkerPool POOL(max(static_cast<size_t>(std::thread::hardware_concurrency()),
+                                   static_cast<size_t>(1)));
+  return POOL;
 }
 void IObserver_deleter::operator()(IObserver* ptr) const
 {
@@ -62,15 +64,16 @@ void IObserver_deleter::operator()(IObserver* ptr) const
 }
 void Scenario::clear() noexcept
 {
-  //  scheduler_.clear();
-  scheduler_ = set<Event, EventCompare>();
-  //  arrival_.clear();
-  arrival_ = {};
-  //  points_.clear();
-  points_ = {};
+  scheduler_.clear();
+  // might have been moved from
+  if (nullptr != arrival_)
+  {
+    arrival_->clear();
+  }
+  points_.clear();
   if (!Settings::surface())
   {
-    spread_info_ = {};
+    spread_info_.clear();
   }
   extinction_thresholds_.clear();
   spread_thresholds_by_ros_.clear();
@@ -95,6 +98,14 @@ size_t Scenario::total_steps() noexcept
 {
   return TOTAL_STEPS;
 }
+void Scenario::reset_counts()
+{
+  COUNT = 0;
+  COMPLETED = 0;
+  TOTAL_STEPS = 0;
+  std::lock_guard<std::mutex> lk(MUTEX_SIM_COUNTS);
+  SIM_COUNTS.clear();
+}
 Scenario::~Scenario()
 {
   clear();
@@ -228,7 +239,7 @@ Scenario* Scenario::reset_with_new_start(const shared_ptr<Cell>& start_cell,
     o->reset();
   }
   current_time_ = start_time_ - 1;
-  points_ = {};
+  points_.clear();
   intensity_ = make_unique<IntensityMap>(model());
   // HACK: never reset these if using a surface
   // if (!Settings::surface())
@@ -295,7 +306,7 @@ Scenario* Scenario::reset(mt19937* mt_extinction,
     o->reset();
   }
   current_time_ = start_time_ - 1;
-  points_ = {};
+  points_.clear();
   // don't do this until we run so that we don't allocate memory too soon
   // log_verbose("Applying initial intensity map");
   // // HACK: if initial_intensity is null then perimeter must be too?
@@ -303,8 +314,8 @@ Scenario* Scenario::reset(mt19937* mt_extinction,
   //   ? make_unique<IntensityMap>(model(), nullptr)
   //   : make_unique<IntensityMap>(*initial_intensity_);
   intensity_ = make_unique<IntensityMap>(model());
-  spread_info_ = {};
-  arrival_ = {};
+  spread_info_.clear();
+  arrival_->clear();
   max_ros_ = 0;
   // surrounded_ = POOL_BURNED_DATA.acquire();
   current_time_index_ = numeric_limits<size_t>::max();
@@ -316,6 +327,15 @@ Scenario* Scenario::reset(mt19937* mt_extinction,
   }
   return this;
 }
+void Scenario::skipThresholds(mt19937* mt_extinction,
+                              mt19937* mt_spread) const
+{
+  // generate the same way reset() does so the same amount of numbers get used
+  const auto num = (static_cast<size_t>(last_date_) - start_day_ + 2) * DAY_HOURS;
+  vector<ThresholdSize> thresholds(num);
+  make_threshold(&thresholds, mt_extinction, start_day_, last_date_);
+  make_threshold(&thresholds, mt_spread, start_day_, last_date_);
+}
 void Scenario::evaluate(const Event& event)
 {
 #ifdef DEBUG_SIMULATION
@@ -408,6 +428,10 @@ Scenario::Scenario(Model* model,
     // initial_intensity_(initial_intensity),
     perimeter_(perimeter),
     // surrounded_(nullptr),
+    memory_(make_unique<std::pmr::unsynchronized_pool_resource>(
+      std::pmr::pool_options{0, MAX_POOLED_BLOCK})),
+    spread_info_(memory_.get()),
+    arrival_(model->environment().makeTiledGrid<DurationSize>(NODATA_ARRIVAL)),
     max_ros_(0),
     start_cell_(start_cell),
     weather_(weather),
@@ -480,6 +504,10 @@ void Scenario::saveIntensity(const string& dir, const string& base_name) const
 {
   intensity_->save(dir, base_name);
 }
+void Scenario::saveArrival(const string& dir, const string& base_name) const
+{
+  arrival_->saveToFile(dir, base_name);
+}
 bool Scenario::ran() const noexcept
 {
   return ran_;
@@ -496,6 +524,7 @@ Scenario::Scenario(Scenario&& rhs) noexcept
     intensity_(std::move(rhs.intensity_)),
     // initial_intensity_(std::move(rhs.initial_intensity_)),
     perimeter_(std::move(rhs.perimeter_)),
+    memory_(std::move(rhs.memory_)),
     spread_info_(std::move(rhs.spread_info_)),
     arrival_(std::move(rhs.arrival_)),
     max_ros_(rhs.max_ros_),
@@ -571,7 +600,7 @@ void Scenario::burn(const Event& event)
     !intensity_->hasBurned(event.cell()),
     "Wasn't marked as burned after burn");
 #endif
-  arrival_[event.cell()] = event.time();
+  arrival_->set(event.cell(), event.time());
   // scheduleFireSpread(event);
 }
 bool Scenario::isSurrounded(const Location& location) const
@@ -670,22 +699,22 @@ Scenario* Scenario::run(map<DurationSize, ProbabilityMap*>* probabilities)
   log_verbose("Creating simulation end event for %f", last_save_);
   addEvent(Event::makeEnd(last_save_));
   // mark all original points as burned at start
-  for (auto& kv : points_.map_)
-  {
-    const auto& location = cell(kv.first);
-    // const auto& location = kv.first;
-    // would be burned already if perimeter applied
-    if (canBurn(location))
-    {
-      const auto fake_event = Event::makeFireSpread(
-        start_time_,
-        0,
-        0,
-        Direction::Invalid,
-        location);
-      burn(fake_event);
-    }
-  }
+  points_.for_each(
+    [this](pair<Location, CellPoints>& kv) {
+      const auto& location = cell(kv.first);
+      // const auto& location = kv.first;
+      // would be burned already if perimeter applied
+      if (canBurn(location))
+      {
+        const auto fake_event = Event::makeFireSpread(
+          start_time_,
+          0,
+          0,
+          Direction::Invalid,
+          location);
+        burn(fake_event);
+      }
+    });
   while (!cancelled_ && !scheduler_.empty())
   {
     evaluateNextEvent();
@@ -754,20 +783,24 @@ Scenario* Scenario::run(map<DurationSize, ProbabilityMap*>* probabilities)
 #endif
   if (oob_spread_ > 0)
   {
-    log_warning("Tried to spread out of bounds %ld times", oob_spread_);
+    // window is sized from --max-daily-spread, so unless it hit the edge of the rasters that was too low
+    log_warning("Tried to spread out of bounds %ld times, so --max-daily-spread may be too low", oob_spread_);
   }
   return this;
 }
-CellPointsMap apply_offsets_spreadkey(
+void apply_offsets_spreadkey(
   const DurationSize& arrival_time,
   const DurationSize& duration,
   const OffsetSet& offsets,
-  spreading_points::mapped_type& cell_pts_map)
+  spreading_points::mapped_type& cell_pts_map,
+  CellPointsMap* result)
 {
   // NOTE: really tried to do this in parallel, but not enough points
   // in a cell for it to work well
-  CellPointsMap r1{};
-  OffsetSet offsets_after_duration{};
+  CellPointsMap& r1 = *result;
+  r1.clear();
+  // each worker keeps its own buffer so this doesn't allocate every time
+  static thread_local OffsetSet offsets_after_duration{};
   logging::verbose("Applying %ld offsets", offsets.size());
   // // offsets_after_duration.resize(offsets.size());
   // std::transform(
@@ -814,15 +847,14 @@ CellPointsMap apply_offsets_spreadkey(
 #endif
       continue;
     }
-    auto& pts = cell_pts.pts_.points();
     auto& dirs = cell_pts.pts_.directions();
     // combine point and direction that lead to it so we can get unique values
     // c++23 is where zip() gets implemented
     // auto pt_dirs = std::ranges::views::zip(pts, dirs);
     std::array<std::pair<InnerPos, MathSize>, NUM_DIRECTIONS> pt_dirs{};
-    for (size_t i = 0; i < pts.size(); ++i)
+    for (size_t i = 0; i < NUM_DIRECTIONS; ++i)
     {
-      pt_dirs[i] = {pts[i], dirs[i]};
+      pt_dirs[i] = {cell_pts.pts_.point(i), dirs[i]};
     }
     std::sort(pt_dirs.begin(), pt_dirs.end());
     const auto it_pt_dirs_last = std::unique(pt_dirs.begin(), pt_dirs.end());
@@ -918,7 +950,6 @@ CellPointsMap apply_offsets_spreadkey(
       ++it_pt_dirs;
     }
   }
-  return r1;
 }
 void Scenario::scheduleFireSpread(const Event& event)
 {
@@ -960,60 +991,51 @@ void Scenario::scheduleFireSpread(const Event& event)
     // seemed like it would be good to keep offsets but max_ros_ needs to reset or things slow to a crawl?
     if (!Settings::surface())
     {
-      spread_info_ = {};
+      spread_info_.clear();
     }
     max_ros_ = 0.0;
   }
   // get once and keep
   const auto ros_min = Settings::minimumRos();
-  spreading_points to_spread{};
-  // make block to prevent it being visible beyond use
+  // keep vectors for each SpreadKey so they don't need to be allocated every time
+  for (auto& kv : to_spread_)
   {
-    // if we use an iterator this way we don't need to copy keys to erase things
-    auto it = points_.map_.begin();
-    while (it != points_.map_.end())
-    {
-      const Location& loc = it->first;
+    kv.second.clear();
+  }
+  auto is_spreading = false;
+  points_.remove_if(
+    [&](pair<Location, CellPoints>& kv) {
+      const Location& loc = kv.first;
       const Cell for_cell = cell(loc);
       const auto key = for_cell.key();
-      // HACK: need to lookup before emplace since might try to create Cell without fuel
-      // if (!fuel::is_null_fuel(loc))
-      // const auto h = for_cell.hash();
-      // if (!(*unburnable_)[h])
-      // if (canBurn(for_cell))
+      const auto& origin_inserted = spread_info_.try_emplace(key, *this, time, key, nd(time), wx);
+      // any cell that has the same fuel, slope, and aspect has the same spread
+      const auto& origin = origin_inserted.first->second;
+      // filter out things not spreading fast enough here so they get copied if they aren't
+      // isNotSpreading() had better be true if ros is lower than minimum
+      const auto ros = origin.headRos();
+      if (ros >= ros_min)
       {
-        const auto& origin_inserted = spread_info_.try_emplace(key, *this, time, key, nd(time), wx);
-        // any cell that has the same fuel, slope, and aspect has the same spread
-        const auto& origin = origin_inserted.first->second;
-        // filter out things not spreading fast enough here so they get copied if they aren't
-        // isNotSpreading() had better be true if ros is lower than minimum
-        const auto ros = origin.headRos();
-        if (ros >= ros_min)
-        {
-          max_ros_ = max(max_ros_, ros);
-          // NOTE: shouldn't be Cell if we're looking up by just Location later
-          to_spread[key].emplace_back(loc, std::move(it->second));
-          it = points_.map_.erase(it);
+        max_ros_ = max(max_ros_, ros);
+        // NOTE: shouldn't be Cell if we're looking up by just Location later
+        to_spread_[key].emplace_back(loc, std::move(kv.second));
+        is_spreading = true;
 #ifdef DEBUG_CELLPOINTS
-          auto& v = to_spread[key];
-          const auto n = v.size();
-          const auto& p = v[n - 1].second;
-          logging::note("added %ld items to to_spread[%d][(%d, %d)]",
-                        p.size(),
-                        key,
-                        loc.column(),
-                        loc.row());
+        auto& v = to_spread_[key];
+        const auto n = v.size();
+        const auto& p = v[n - 1].second;
+        logging::note("added %ld items to to_spread[%d][(%d, %d)]",
+                      p.size(),
+                      key,
+                      loc.column(),
+                      loc.row());
 #endif
-        }
-        else
-        {
-          ++it;
-        }
+        return true;
       }
-    }
-  }
+      return false;
+    });
   // if nothing in to_spread then nothing is spreading
-  if (to_spread.empty())
+  if (!is_spreading)
   {
     // if no spread then we left everything back in points_ still
     log_verbose("Waiting until %f", max_time);
@@ -1029,41 +1051,103 @@ void Scenario::scheduleFireSpread(const Event& event)
                            : max_duration);
   // note("Spreading for %f minutes", duration);
   const auto new_time = time + duration / DAY_MINUTES;
-  CellPointsMap cell_pts{};
-  auto spread = std::views::transform(
-    to_spread,
-    [this, &duration, &new_time](
-      spreading_points::value_type& kv0) -> CellPointsMap {
+  CellPointsMap& cell_pts = spread_points_;
+  cell_pts.clear();
+  // outside edge of the window is always unburnable, so fire stops there without this
+  // count every point that gets dropped there, so serial and parallel count the same thing
+  atomic<size_t> at_edge = 0;
+  const auto count_edge = [this, &at_edge](const Location& location) {
+    if (0 == location.row()
+        || 0 == location.column()
+        || (rows() - 1) == location.row()
+        || (columns() - 1) == location.column())
+    {
+      ++at_edge;
+    }
+  };
+  if (Settings::parallelSpread())
+  {
+    // look up offsets first since spread_info_ can't be changed while running in parallel
+    spread_work_.clear();
+    for (auto& kv0 : to_spread_)
+    {
+      if (!kv0.second.empty())
+      {
+        spread_work_.emplace_back(&spread_info_[kv0.first].offsets(), &kv0.second, nullptr);
+      }
+    }
+    const auto n = spread_work_.size();
+    if (spread_results_.size() < n)
+    {
+      spread_results_.resize(n);
+    }
+    for (size_t i = 0; i < n; ++i)
+    {
+      std::get<2>(spread_work_[i]) = &spread_results_[i];
+    }
+    auto& pool = spread_pool();
+    pool.for_each(
+      n,
+      [this, &duration, &new_time](const size_t i) {
+        auto& w = spread_work_[i];
+        apply_offsets_spreadkey(new_time, duration, *std::get<0>(w), *std::get<1>(w), std::get<2>(w));
+      });
+    // merging keeps the first closest point, so merging neighbours in order gives
+    // the same result as merging everything one after another
+    for (size_t stride = 1; stride < n; stride *= 2)
+    {
+      spread_merges_.clear();
+      for (size_t i = 0; i + stride < n; i += 2 * stride)
+      {
+        spread_merges_.emplace_back(std::get<2>(spread_work_[i]), std::get<2>(spread_work_[i + stride]));
+      }
+      pool.for_each(
+        spread_merges_.size(),
+        [this, &count_edge](const size_t i) {
+          auto& m = spread_merges_[i];
+          m.first->merge(*unburnable_, *m.second, count_edge);
+        });
+    }
+    // anything unburnable that was in the first result gets removed and counted below
+    std::swap(cell_pts, *std::get<2>(spread_work_[0]));
+  }
+  else
+  {
+    for (auto& kv0 : to_spread_)
+    {
+      // skip keys that were spreading before but aren't now
+      if (kv0.second.empty())
+      {
+        continue;
+      }
       auto& key = kv0.first;
       const auto& offsets = spread_info_[key].offsets();
-      spreading_points::mapped_type& cell_pts = kv0.second;
-      auto r = apply_offsets_spreadkey(new_time, duration, offsets, cell_pts);
-      return r;
-    });
-  auto it = spread.begin();
-  while (spread.end() != it)
-  {
-    const CellPointsMap& cell_pts_cur = *it;
-    // // HACK: keep old behaviour until we can figure out whey removing isn't the same as not adding
-    // const auto h = cell_pts.location().hash();
-    // if (!unburnable[h])
-    // {
-    cell_pts.merge(*unburnable_, cell_pts_cur);
-    // }
-    ++it;
+      apply_offsets_spreadkey(new_time, duration, offsets, kv0.second, &spread_key_points_);
+      // // HACK: keep old behaviour until we can figure out whey removing isn't the same as not adding
+      // const auto h = cell_pts.location().hash();
+      // if (!unburnable[h])
+      // {
+      cell_pts.merge(*unburnable_, spread_key_points_, count_edge);
+      // }
+    }
   }
 #ifdef DEBUG_CELLPOINTS
   const auto n_c = cell_pts.size();
 #endif
   cell_pts.remove_if(
-    [this](
+    [this, &count_edge](
       const pair<Location, CellPoints>& kv) {
       const auto& location = kv.first;
       const auto h = location.hash();
       // clear out if unburnable
       const auto do_clear = (*unburnable_)[h];
+      if (do_clear)
+      {
+        count_edge(location);
+      }
       return do_clear;
     });
+  oob_spread_ += at_edge;
 #ifdef DEBUG_CELLPOINTS
   logging::note("%ld cell_pts before remove_if() and %ld after", n_c, cell_pts.size());
 #endif
@@ -1072,9 +1156,8 @@ void Scenario::scheduleFireSpread(const Event& event)
     *unburnable_,
     cell_pts);
   // if we move everything out of points_ we can parallelize this check?
-  do_each(
-    points_.map_,
-    [this, &new_time](pair<const Location, CellPoints>& kv) {
+  points_.for_each(
+    [this, &new_time](pair<Location, CellPoints>& kv) {
       const auto for_cell = cell(kv.first);
       CellPoints& pts = kv.second;
       // logging::check_fatal(pts.empty(), "Empty points for some reason");
@@ -1108,24 +1191,20 @@ void Scenario::scheduleFireSpread(const Event& event)
       }
       if (!(*unburnable_)[for_cell.hash()]
           // && canBurn(for_cell)
-          && ((survives(new_time, for_cell, new_time - arrival_[for_cell])
+          && ((survives(new_time, for_cell, new_time - arrival_->at(for_cell))
                && !isSurrounded(for_cell))))
       {
+        // points are already in points_ so they stay for the next step
         log_points(step_, STAGE_CONDENSE, new_time, pts);
-        const auto r = for_cell.row();
-        const auto c = for_cell.column();
-        const Location loc{r, c};
-        std::swap(points_.map_[loc], pts);
       }
       else
       {
         // just inserted false, so make sure unburnable gets updated
         // whether it went out or is surrounded just mark it as unburnable
-        (*unburnable_)[for_cell.hash()] = true;
-        // not swapping means these points get dropped
+        unburnable_->set(for_cell.hash());
       }
     });
-  log_extensive("Spreading %d cells until %f", points_.map_.size(), new_time);
+  log_extensive("Spreading %d cells until %f", points_.size(), new_time);
   addEvent(Event::makeFireSpread(new_time));
 }
 MathSize
@@ -1152,8 +1231,7 @@ bool Scenario::hasBurned(const Location& location) const
 void Scenario::endSimulation() noexcept
 {
   log_verbose("Ending simulation");
-  //  scheduler_.clear();
-  scheduler_ = set<Event, EventCompare>();
+  scheduler_.clear();
 }
 void Scenario::addSaveByOffset(const int offset)
 {
@@ -1178,13 +1256,7 @@ void Scenario::addEvent(Event&& event)
 // bool Scenario::evaluateNextEvent()
 void Scenario::evaluateNextEvent()
 {
-  // make sure to actually copy it before we erase it
-  const auto& event = *scheduler_.begin();
-  evaluate(event);
-  if (!scheduler_.empty())
-  {
-    scheduler_.erase(event);
-  }
+  evaluate(scheduler_.next());
   // return !model_->isOutOfTime();
   // return cancelled_;
 }
@@ -5,18 +5,24 @@
 
 #pragma once
 #include "stdafx.h"
-#include "EventCompare.h"
+#include <memory_resource>
+#include "EventScheduler.h"
 #include "FireWeather.h"
 #include "IntensityMap.h"
 #include "Model.h"
 #include "Settings.h"
 #include "StartPoint.h"
+#include "TiledGrid.h"
 #include "InnerPos.h"
 #include "FireSpread.h"
 #include "CellPoints.h"
 
 namespace tbd::sim
 {
+/**
+ * \brief Arrival time for cells that fire hasn't arrived in
+ */
+static constexpr DurationSize NODATA_ARRIVAL = 0;
 class LogPoints;
 class IObserver;
 class Event;
@@ -52,6 +58,10 @@ public:
    * \return Total number of spread events for all Scenarios
    */
   [[nodiscard]] static size_t total_steps() noexcept;
+  /**
+   * \brief Start counting Scenarios and spread events from 0, so a batch reports each fire separately
+   */
+  static void reset_counts();
   /**
    * \brief Weighted Danger Severity Rating
    * \return Weighted Danger Severity Rating
@@ -137,6 +147,13 @@ public:
   [[nodiscard]] Scenario* reset(mt19937* mt_extinction,
                                 mt19937* mt_spread,
                                 util::SafeVector* final_sizes);
+  /**
+   * \brief Advance random number generators past the numbers that reset() would use
+   * \param mt_extinction Used for extinction random numbers
+   * \param mt_spread Used for spread random numbers
+   */
+  void skipThresholds(mt19937* mt_extinction,
+                      mt19937* mt_spread) const;
   /**
    * \brief Burn cell that Event takes place in
    * \param event Event with cell location
@@ -236,6 +253,16 @@ public:
   {
     return *model_;
   }
+  /**
+   * \brief Memory for things that only last as long as a step or run of this Scenario
+   *
+   * Only used from the thread running this Scenario, so doesn't need to be synchronized.
+   * \return Memory for things that only last as long as a step or run of this Scenario
+   */
+  [[nodiscard]] std::pmr::memory_resource* memory() const noexcept
+  {
+    return memory_.get();
+  }
   /**
    * \brief Sunrise time for given day
    * \param for_day Day to get sunrise time for
@@ -419,6 +446,12 @@ public:
    * \param base_name Base file name
    */
   void saveIntensity(const string& dir, const string& base_name) const;
+  /**
+   * \brief Save time fire first arrived in each cell
+   * \param dir Directory to save to
+   * \param base_name Base file name
+   */
+  void saveArrival(const string& dir, const string& base_name) const;
   /**
    * \brief Whether or not this Scenario has run already
    * \return Whether or not this Scenario has run already
@@ -549,6 +582,34 @@ protected:
    * \brief Map of Cells to the PointSets within them
    */
   CellPointsMap points_;
+  /**
+   * \brief Points that are spreading during the current step, by SpreadKey
+   */
+  spreading_points to_spread_{};
+  /**
+   * \brief Points after spreading during the current step
+   */
+  CellPointsMap spread_points_{};
+  /**
+   * \brief Points after spreading for a single SpreadKey during the current step
+   */
+  CellPointsMap spread_key_points_{};
+  /**
+   * \brief Offsets to apply, points to apply them to, and where to put the result
+   */
+  using SpreadWork = std::tuple<const OffsetSet*, spreading_points::mapped_type*, CellPointsMap*>;
+  /**
+   * \brief Work for each SpreadKey when spreading in parallel
+   */
+  vector<SpreadWork> spread_work_{};
+  /**
+   * \brief Points after spreading for each SpreadKey when spreading in parallel
+   */
+  vector<CellPointsMap> spread_results_{};
+  /**
+   * \brief Pairs of results to merge at the current level when spreading in parallel
+   */
+  vector<pair<CellPointsMap*, const CellPointsMap*>> spread_merges_{};
   /**
    * \brief Contains information on cells that are not burnable
    */
@@ -556,7 +617,7 @@ protected:
   /**
    * \brief Event scheduler used for ordering events
    */
-  set<Event, EventCompare> scheduler_;
+  EventScheduler scheduler_;
   /**
    * \brief Map of what intensity each cell has burned at
    */
@@ -569,14 +630,19 @@ protected:
    * \brief Perimeter used to start Scenario from
    */
   shared_ptr<topo::Perimeter> perimeter_;
+  /**
+   * \brief Pools that spread_info_ allocates from, which keep memory that is freed so it
+   * can be reused after clearing it instead of going back to the global heap
+   */
+  unique_ptr<std::pmr::unsynchronized_pool_resource> memory_;
   /**
    * \brief Calculated SpreadInfo for SpreadKey for current time
    */
-  map<topo::SpreadKey, SpreadInfo> spread_info_{};
+  std::pmr::map<topo::SpreadKey, SpreadInfo> spread_info_;
   /**
-   * \brief Map of when Cell had first Point arrive in it
+   * \brief Time that fire first arrived in each Cell, or NODATA_ARRIVAL if it hasn't
    */
-  map<topo::Cell, DurationSize> arrival_{};
+  unique_ptr<data::TiledGrid<DurationSize>> arrival_;
   /**
    * \brief Maximum rate of spread for current time
    */
@@ -651,7 +717,7 @@ protected:
    */
   size_t step_;
   /**
-   * \brief How many times this scenario tried to spread out of bounds
+   * \brief How many times this scenario tried to spread into the outside edge of the window
    */
   size_t oob_spread_;
 };
@@ -6,6 +6,7 @@
 #include "stdafx.h"
 #include <filesystem>
 #include "Settings.h"
+#include "TileCompression.h"
 #include "Trim.h"
 namespace tbd::sim
 {
@@ -53,6 +54,14 @@ public:
   {
     return raster_root_.c_str();
   }
+  /**
+   * \brief Fuel lookup table file
+   * \return Fuel lookup table file
+   */
+  [[nodiscard]] const char* fuelLookupTable() const noexcept
+  {
+    return fuel_lookup_table_file_.c_str();
+  }
   /**
    * \brief Fuel lookup table
    * \return Fuel lookup table
@@ -396,11 +405,36 @@ public:
    * \return Whether or not to create a probability surface
    */
   atomic<bool> surface = false;
+  /**
+   * \brief Whether or not to spread points for each Scenario in parallel
+   * \return Whether or not to spread points for each Scenario in parallel
+   */
+  atomic<bool> parallel_spread = false;
+  /**
+   * \brief Worst case distance a fire can spread in a day (m), or 0 to use the largest window
+   * \return Worst case distance a fire can spread in a day (m), or 0 to use the largest window
+   */
+  atomic<MathSize> maximum_daily_spread = 0.0;
   /**
    * \brief Whether or not to save grids as .asc
    * \return Whether or not to save grids as .asc
    */
   atomic<bool> save_as_ascii = false;
+  /**
+   * \brief Whether or not to save .tif grids as Cloud Optimized GeoTIFFs with overviews
+   * \return Whether or not to save .tif grids as Cloud Optimized GeoTIFFs with overviews
+   */
+  atomic<bool> save_as_cog = false;
+  /**
+   * \brief TIFF compression tag value to use when saving grids as .tif
+   * \return TIFF compression tag value to use when saving grids as .tif
+   */
+  atomic<uint16_t> tiff_compression = COMPRESSION_LZW;
+  /**
+   * \brief TIFF predictor tag value to use when saving grids as .tif
+   * \return TIFF predictor tag value to use when saving grids as .tif
+   */
+  atomic<uint16_t> tiff_predictor = PREDICTOR_NONE;
   /**
    * \brief Whether or not to save points used for spread
    * \return Whether or not to save points used for spread
@@ -593,6 +627,10 @@ void Settings::setFuelLookupTable(const char* filename) noexcept
 {
   return SettingsImplementation::instance().setFuelLookupTable(filename);
 }
+const char* Settings::fuelLookupTable() noexcept
+{
+  return SettingsImplementation::instance().fuelLookupTable();
+}
 const fuel::FuelLookup& Settings::fuelLookup() noexcept
 {
   return SettingsImplementation::instance().fuelLookup();
@@ -629,6 +667,22 @@ void Settings::setDeterministic(const bool value) noexcept
 {
   SettingsImplementation::instance().deterministic = value;
 }
+bool Settings::parallelSpread() noexcept
+{
+  return SettingsImplementation::instance().parallel_spread;
+}
+void Settings::setParallelSpread(const bool value) noexcept
+{
+  SettingsImplementation::instance().parallel_spread = value;
+}
+MathSize Settings::maximumDailySpread() noexcept
+{
+  return SettingsImplementation::instance().maximum_daily_spread;
+}
+void Settings::setMaximumDailySpread(const MathSize value) noexcept
+{
+  SettingsImplementation::instance().maximum_daily_spread = value;
+}
 bool Settings::saveAsAscii() noexcept
 {
   return SettingsImplementation::instance().save_as_ascii;
@@ -637,6 +691,30 @@ void Settings::setSaveAsAscii(const bool value) noexcept
 {
   SettingsImplementation::instance().save_as_ascii = value;
 }
+bool Settings::saveAsCog() noexcept
+{
+  return SettingsImplementation::instance().save_as_cog;
+}
+void Settings::setSaveAsCog(const bool value) noexcept
+{
+  SettingsImplementation::instance().save_as_cog = value;
+}
+uint16_t Settings::tiffCompression() noexcept
+{
+  return SettingsImplementation::instance().tiff_compression;
+}
+void Settings::setTiffCompression(const char* value)
+{
+  SettingsImplementation::instance().tiff_compression = data::parse_tiff_compression(value);
+}
+uint16_t Settings::tiffPredictor() noexcept
+{
+  return SettingsImplementation::instance().tiff_predictor;
+}
+void Settings::setTiffPredictor(const char* value)
+{
+  SettingsImplementation::instance().tiff_predictor = data::parse_tiff_predictor(value);
+}
 bool Settings::savePoints() noexcept
 {
   return SettingsImplementation::instance().save_points;
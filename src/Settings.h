@@ -41,6 +41,11 @@ public:
    * \param dirname Directory to use for rasters
    */
   static void setFuelLookupTable(const char* filename) noexcept;
+  /**
+   * \brief Fuel lookup table file
+   * \return Fuel lookup table file
+   */
+  [[nodiscard]] static const char* fuelLookupTable() noexcept;
   /**
    * \brief Fuel lookup table
    * \return Fuel lookup table
@@ -90,6 +95,28 @@ public:
    * \return None
    */
   static void setSurface(bool value) noexcept;
+  /**
+   * \brief Whether or not to spread points for each Scenario in parallel
+   * \return Whether or not to spread points for each Scenario in parallel
+   */
+  [[nodiscard]] static bool parallelSpread() noexcept;
+  /**
+   * \brief Set whether or not to spread points for each Scenario in parallel
+   * \param value Whether or not to spread points for each Scenario in parallel
+   * \return None
+   */
+  static void setParallelSpread(bool value) noexcept;
+  /**
+   * \brief Worst case distance a fire can spread in a day (m), used to size simulation window
+   * \return Worst case distance a fire can spread in a day (m), or 0 to use the largest window
+   */
+  [[nodiscard]] static MathSize maximumDailySpread() noexcept;
+  /**
+   * \brief Set worst case distance a fire can spread in a day (m), used to size simulation window
+   * \param value Worst case distance a fire can spread in a day (m), or 0 to use the largest window
+   * \return None
+   */
+  static void setMaximumDailySpread(MathSize value) noexcept;
   /**
    * \brief Whether or not to save grids as .asc
    * \return Whether or not to save grids as .asc
@@ -101,6 +128,39 @@ public:
    * \return None
    */
   static void setSaveAsAscii(bool value) noexcept;
+  /**
+   * \brief Whether or not to save .tif grids as Cloud Optimized GeoTIFFs with overviews
+   * \return Whether or not to save .tif grids as Cloud Optimized GeoTIFFs with overviews
+   */
+  [[nodiscard]] static bool saveAsCog() noexcept;
+  /**
+   * \brief Set whether or not to save .tif grids as Cloud Optimized GeoTIFFs with overviews
+   * \param value Whether or not to save .tif grids as Cloud Optimized GeoTIFFs with overviews
+   * \return None
+   */
+  static void setSaveAsCog(bool value) noexcept;
+  /**
+   * \brief TIFF compression tag value to use when saving grids as .tif
+   * \return TIFF compression tag value to use when saving grids as .tif
+   */
+  [[nodiscard]] static uint16_t tiffCompression() noexcept;
+  /**
+   * \brief Set compression to use when saving grids as .tif
+   * \param value Name of compression ("lzw", "deflate", or "zstd")
+   * \return None
+   */
+  static void setTiffCompression(const char* value);
+  /**
+   * \brief TIFF predictor tag value to use when saving grids as .tif
+   * \return TIFF predictor tag value to use when saving grids as .tif
+   */
+  [[nodiscard]] static uint16_t tiffPredictor() noexcept;
+  /**
+   * \brief Set predictor to use when saving grids as .tif
+   * \param value Name of predictor ("none", "horizontal", or "floatingpoint")
+   * \return None
+   */
+  static void setTiffPredictor(const char* value);
   /**
    * \brief Whether or not to save points used for spread
    * \return Whether or not to save points used for spread
@@ -5,7 +5,7 @@
 
 #include "SpreadAlgorithm.h"
 #include "Util.h"
-#include "unstable.h"
+#include "Trig.h"
 #include "CellPoints.h"
 namespace tbd
 {
@@ -20,7 +20,7 @@ HorizontalAdjustment horizontal_adjustment(
     // do check once and make function just return 1.0 if no slope
     return no_correction;
   }
-  const auto b_semi = _cos(atan(slope / 100.0));
+  const auto b_semi = util::trig::cos(util::trig::atan(slope / 100.0));
   const auto slope_radians = util::to_radians(slope_azimuth);
   const auto do_correction = [b_semi, slope_radians](const MathSize theta) noexcept {
     // never gets called if isInvalid() so don't check
@@ -45,12 +45,18 @@ HorizontalAdjustment horizontal_adjustment(
   MathSize head_raz,
   MathSize head_ros,
   MathSize back_ros,
-  MathSize length_to_breadth) const noexcept
+  MathSize length_to_breadth,
+  OffsetGroups* groups) const noexcept
 {
   OffsetSet offsets{};
-  const auto add_offset =
+  const auto end_group = [&offsets, groups](const bool is_required) {
+    groups->emplace_back(offsets.size(), is_required);
+  };
+  const auto add_offset_at =
     [this, &offsets, tfc](
       const MathSize direction,
+      const MathSize sin_d,
+      const MathSize cos_d,
       const MathSize ros) {
       if (ros < min_ros_)
       {
@@ -64,13 +70,24 @@ HorizontalAdjustment horizontal_adjustment(
         ros,
         Direction(direction, true),
         Offset{
-          static_cast<DistanceSize>(ros_cell * _sin(direction)),
-          static_cast<DistanceSize>(ros_cell * _cos(direction))});
+          static_cast<DistanceSize>(ros_cell * sin_d),
+          static_cast<DistanceSize>(ros_cell * cos_d)});
       return true;
     };
+  const auto add_offset =
+    [&add_offset_at](
+      const MathSize direction,
+      const MathSize ros) {
+      MathSize sin_d;
+      MathSize cos_d;
+      util::trig::sin_cos(direction, &sin_d, &cos_d);
+      return add_offset_at(direction, sin_d, cos_d, ros);
+    };
   // if not over spread threshold then don't spread
   // HACK: set ros in boolean if we get that far so that we don't have to repeat the if body
-  if (!add_offset(head_raz, head_ros * correction_factor(head_raz)))
+  const auto is_head_added = add_offset(head_raz, head_ros * correction_factor(head_raz));
+  end_group(true);
+  if (!is_head_added)
   {
     return offsets;
   }
@@ -83,48 +100,58 @@ HorizontalAdjustment horizontal_adjustment(
   const auto ac = a * c;
   const auto calculate_ros =
     [a, c, ac, flank_ros, a_sq, flank_ros_sq, a_sq_sub_c_sq](const MathSize theta) noexcept {
-      const auto cos_t = _cos(theta);
+      MathSize sin_t;
+      MathSize cos_t;
+      util::trig::sin_cos(theta, &sin_t, &cos_t);
       const auto cos_t_sq = cos_t * cos_t;
       const auto f_sq_cos_t_sq = flank_ros_sq * cos_t_sq;
       // 1.0 = cos^2 + sin^2
       //    const auto sin_t_sq = 1.0 - cos_t_sq;
-      const auto sin_t = _sin(theta);
       const auto sin_t_sq = sin_t * sin_t;
       return abs((a * ((flank_ros * cos_t * sqrt(f_sq_cos_t_sq + a_sq_sub_c_sq * sin_t_sq) - ac * sin_t_sq) / (f_sq_cos_t_sq + a_sq * sin_t_sq)) + c) / cos_t);
     };
   const auto add_offsets =
-    [this, &correction_factor, &add_offset, head_raz](
+    [this, &correction_factor, &add_offset_at, head_raz](
       const MathSize angle_radians,
       const MathSize ros_flat) {
       if (ros_flat < min_ros_)
       {
         return false;
       }
-      auto direction = util::fix_radians(angle_radians + head_raz);
-      // spread is symmetrical across the center axis, but needs to be adjusted if on a slope
+      // spread is symmetrical across the center axis, so do both sides at once
+      const MathSize directions[2]{
+        util::fix_radians(angle_radians + head_raz),
+        util::fix_radians(head_raz - angle_radians)};
+      MathSize sins[2];
+      MathSize coss[2];
+      util::trig::sin_cos(2, directions, sins, coss);
+      // needs to be adjusted if on a slope
       // intentionally don't use || because we want both of these to happen all the time
-      auto added = add_offset(direction, ros_flat * correction_factor(direction));
-      direction = util::fix_radians(head_raz - angle_radians);
-      added |= add_offset(direction, ros_flat * correction_factor(direction));
+      auto added = add_offset_at(directions[0], sins[0], coss[0], ros_flat * correction_factor(directions[0]));
+      added |= add_offset_at(directions[1], sins[1], coss[1], ros_flat * correction_factor(directions[1]));
       return added;
     };
   const auto add_offsets_calc_ros =
     [&add_offsets, &calculate_ros](const MathSize angle_radians) { return add_offsets(angle_radians, calculate_ros(angle_radians)); };
   // bool added = add_offset(head_raz, head_ros);
   bool added = add_offset(head_raz, head_ros);
+  end_group(true);
   MathSize i = max_angle_;
   while (added && i < 90)
   {
     added = add_offsets_calc_ros(util::to_radians(i));
+    end_group(true);
     i += max_angle_;
   }
   if (added)
   {
     added = add_offsets(util::to_radians(90), flank_ros * sqrt(a_sq_sub_c_sq) / a);
+    end_group(true);
     i = 90 + max_angle_;
     while (added && i < 180)
     {
       added = add_offsets_calc_ros(util::to_radians(i));
+      end_group(true);
       i += max_angle_;
     }
     if (added)
@@ -135,6 +162,7 @@ HorizontalAdjustment horizontal_adjustment(
       {
         const auto direction = util::fix_radians(util::RAD_180 + head_raz);
         static_cast<void>(!add_offset(direction, back_ros * correction_factor(direction)));
+        end_group(true);
       }
     }
   }
@@ -146,12 +174,18 @@ HorizontalAdjustment horizontal_adjustment(
   const MathSize head_raz,
   const MathSize head_ros,
   const MathSize back_ros,
-  const MathSize length_to_breadth) const noexcept
+  const MathSize length_to_breadth,
+  OffsetGroups* groups) const noexcept
 {
   OffsetSet offsets{};
-  const auto add_offset =
+  const auto end_group = [&offsets, groups](const bool is_required) {
+    groups->emplace_back(offsets.size(), is_required);
+  };
+  const auto add_offset_at =
     [this, &offsets, tfc](
       const MathSize direction,
+      const MathSize sin_d,
+      const MathSize cos_d,
       const MathSize ros) {
 #ifdef DEBUG_POINTS
       const auto s0 = offsets.size();
@@ -173,8 +207,8 @@ HorizontalAdjustment horizontal_adjustment(
         ros,
         Direction(direction, true),
         Offset{
-          static_cast<DistanceSize>(ros_cell * _sin(direction)),
-          static_cast<DistanceSize>(ros_cell * _cos(direction))});
+          static_cast<DistanceSize>(ros_cell * sin_d),
+          static_cast<DistanceSize>(ros_cell * cos_d)});
     // // HACK: avoid bounds check
     // offsets.emplace_back(ros_cell * _sin(direction), ros_cell * _cos(direction), false);
 #ifdef DEBUG_POINTS
@@ -184,9 +218,20 @@ HorizontalAdjustment horizontal_adjustment(
 #endif
       return true;
     };
+  const auto add_offset =
+    [&add_offset_at](
+      const MathSize direction,
+      const MathSize ros) {
+      MathSize sin_d;
+      MathSize cos_d;
+      util::trig::sin_cos(direction, &sin_d, &cos_d);
+      return add_offset_at(direction, sin_d, cos_d, ros);
+    };
   // if not over spread threshold then don't spread
   // HACK: set ros in boolean if we get that far so that we don't have to repeat the if body
-  if (!add_offset(head_raz, head_ros * correction_factor(head_raz)))
+  const auto is_head_added = add_offset(head_raz, head_ros * correction_factor(head_raz));
+  end_group(true);
+  if (!is_head_added)
   {
     // might not be correct depending on slope angle correction
     // #ifdef DEBUG_POINTS
@@ -213,29 +258,35 @@ HorizontalAdjustment horizontal_adjustment(
   const auto ac = a * c;
   const auto calculate_ros =
     [a, c, ac, flank_ros, a_sq, flank_ros_sq, a_sq_sub_c_sq](const MathSize theta) noexcept {
-      const auto cos_t = _cos(theta);
+      MathSize sin_t;
+      MathSize cos_t;
+      util::trig::sin_cos(theta, &sin_t, &cos_t);
       const auto cos_t_sq = cos_t * cos_t;
       const auto f_sq_cos_t_sq = flank_ros_sq * cos_t_sq;
       // 1.0 = cos^2 + sin^2
       //    const auto sin_t_sq = 1.0 - cos_t_sq;
-      const auto sin_t = _sin(theta);
       const auto sin_t_sq = sin_t * sin_t;
       return abs((a * ((flank_ros * cos_t * sqrt(f_sq_cos_t_sq + a_sq_sub_c_sq * sin_t_sq) - ac * sin_t_sq) / (f_sq_cos_t_sq + a_sq * sin_t_sq)) + c) / cos_t);
     };
   const auto add_offsets =
-    [this, &correction_factor, &add_offset, head_raz](
+    [this, &correction_factor, &add_offset_at, head_raz](
       const MathSize angle_radians,
       const MathSize ros_flat) {
       if (ros_flat < min_ros_)
       {
         return false;
       }
-      auto direction = util::fix_radians(angle_radians + head_raz);
-      // spread is symmetrical across the center axis, but needs to be adjusted if on a slope
+      // spread is symmetrical across the center axis, so do both sides at once
+      const MathSize directions[2]{
+        util::fix_radians(angle_radians + head_raz),
+        util::fix_radians(head_raz - angle_radians)};
+      MathSize sins[2];
+      MathSize coss[2];
+      util::trig::sin_cos(2, directions, sins, coss);
+      // needs to be adjusted if on a slope
       // intentionally don't use || because we want both of these to happen all the time
-      auto added = add_offset(direction, ros_flat * correction_factor(direction));
-      direction = util::fix_radians(head_raz - angle_radians);
-      added |= add_offset(direction, ros_flat * correction_factor(direction));
+      auto added = add_offset_at(directions[0], sins[0], coss[0], ros_flat * correction_factor(directions[0]));
+      added |= add_offset_at(directions[1], sins[1], coss[1], ros_flat * correction_factor(directions[1]));
       return added;
     };
   const auto add_offsets_calc_ros =
@@ -253,7 +304,7 @@ HorizontalAdjustment horizontal_adjustment(
   MathSize cur_x = 1.0;
   // MathSize last_angle = 0;
   // widest point should be at origin, which is 'c' away from origin
-  MathSize widest = atan2(flank_ros, c);
+  MathSize widest = util::trig::atan2(flank_ros, c);
   // printf("head_ros = %f, back_ros = %f, flank_ros = %f, c = %f, widest = %f\n",
   //        head_ros,
   //        back_ros,
@@ -263,15 +314,16 @@ HorizontalAdjustment horizontal_adjustment(
   // MathSize step = 1;
   // MathSize last_step = 0;
   size_t num_angles = 0;
-  MathSize widest_x = _cos(widest);
+  MathSize widest_x = util::trig::cos(widest);
   MathSize step_max = STEP_MAX / pow(length_to_breadth, 0.5);
   while (added && cur_x > (STEP_MAX / 4.0))
   {
     ++num_angles;
-    theta = min(acos(cur_x), last_theta + step_max);
+    theta = min(util::trig::acos(cur_x), last_theta + step_max);
     angle = ellipse_angle(length_to_breadth, theta);
     added = add_offsets_calc_ros(angle);
-    cur_x = _cos(theta);
+    end_group(true);
+    cur_x = util::trig::cos(theta);
     // printf("cur_x = %f, theta = %f, angle = %f, last_theta = %f, last_angle = %f\n",
     //        cur_x,
     //        util::to_degrees(theta),
@@ -294,12 +346,15 @@ HorizontalAdjustment horizontal_adjustment(
   {
     angle = ellipse_angle(length_to_breadth, (util::RAD_090 + theta) / 2.0);
     added = add_offsets_calc_ros(angle);
+    // result gets replaced below so this doesn't stop spread
+    end_group(false);
     // always just do one between the last angle and 90
     theta = util::RAD_090;
     ++num_angles;
     angle = ellipse_angle(length_to_breadth, theta);
     added = add_offsets(util::RAD_090, flank_ros * sqrt(a_sq_sub_c_sq) / a);
-    cur_x = _cos(theta);
+    end_group(true);
+    cur_x = util::trig::cos(theta);
     // printf("cur_x = %f, theta = %f, angle = %f, last_theta = %f, last_angle = %f\n",
     //        cur_x,
     //        util::to_degrees(theta),
@@ -318,11 +373,11 @@ HorizontalAdjustment horizontal_adjustment(
   // just trying random things now
   // MathSize max_angle = util::RAD_180 - (pow(length_to_breadth, 1.5) * STEP_MAX);
   MathSize max_angle = util::RAD_180 - (length_to_breadth * step_max);
-  MathSize min_x = _cos(max_angle);
+  MathSize min_x = util::trig::cos(max_angle);
   while (added && cur_x >= min_x)
   {
     ++num_angles;
-    theta = max(acos(cur_x), last_theta + step_max);
+    theta = max(util::trig::acos(cur_x), last_theta + step_max);
     angle = ellipse_angle(length_to_breadth, theta);
     if (angle > max_angle)
     {
@@ -332,7 +387,8 @@ HorizontalAdjustment horizontal_adjustment(
       // angle = ellipse_angle(length_to_breadth, theta);
     }
     added = add_offsets_calc_ros(angle);
-    cur_x = _cos(theta);
+    end_group(true);
+    cur_x = util::trig::cos(theta);
     // printf("cur_x = %f, theta = %f, angle = %f, last_theta = %f, last_angle = %f\n",
     //        cur_x,
     //        util::to_degrees(theta),
@@ -351,6 +407,7 @@ HorizontalAdjustment horizontal_adjustment(
     {
       const auto direction = util::fix_radians(util::RAD_180 + head_raz);
       static_cast<void>(!add_offset(direction, back_ros * correction_factor(direction)));
+      end_group(true);
     }
   }
 #ifdef DEBUG_POINTS
@@ -23,7 +23,8 @@ public:
     MathSize head_raz,
     MathSize head_ros,
     MathSize back_ros,
-    MathSize length_to_breadth) const
+    MathSize length_to_breadth,
+    OffsetGroups* groups) const
     noexcept = 0;
 };
 
@@ -54,7 +55,8 @@ public:
     MathSize head_raz,
     MathSize head_ros,
     MathSize back_ros,
-    MathSize length_to_breadth) const noexcept override;
+    MathSize length_to_breadth,
+    OffsetGroups* groups) const noexcept override;
 };
 
 class WidestEllipseAlgorithm
@@ -68,6 +70,7 @@ public:
     MathSize head_raz,
     MathSize head_ros,
     MathSize back_ros,
-    MathSize length_to_breadth) const noexcept override;
+    MathSize length_to_breadth,
+    OffsetGroups* groups) const noexcept override;
 };
 }
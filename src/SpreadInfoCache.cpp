@@ -0,0 +1,67 @@
+/* Copyright (c) His Majesty the King in Right of Canada as represented by the Minister of Natural Resources, 2024. */
+
+/* SPDX-License-Identifier: AGPL-3.0-or-later */
+
+#include "stdafx.h"
+#include "SpreadInfoCache.h"
+#include "Scenario.h"
+#include "Settings.h"
+namespace tbd::sim
+{
+SpreadInfoCache::Shard& SpreadInfoCache::shard(const wx::FwiWeather* weather) noexcept
+{
+  // weather for consecutive hours is usually contiguous, so this spreads hours across shards
+  const auto index = reinterpret_cast<uintptr_t>(weather) / sizeof(wx::FwiWeather);
+  return shards_[index % NUM_SHARDS];
+}
+size_t SpreadInfoCache::entryBytes(const SpreadInfo& spread) noexcept
+{
+  // map nodes have a colour and three pointers before the value
+  constexpr auto NODE_BYTES = sizeof(void*) * 4 + sizeof(map<Key, SpreadInfo>::value_type);
+  return NODE_BYTES
+       + spread.offsets_.capacity() * sizeof(ROSOffset)
+       + spread.groups_.capacity() * sizeof(OffsetGroup);
+}
+SpreadInfo SpreadInfoCache::calculate(const Scenario& scenario,
+                                      const DurationSize time,
+                                      const topo::SpreadKey& key,
+                                      const int nd,
+                                      const wx::FwiWeather* weather,
+                                      const wx::FwiWeather* weather_daily,
+                                      const MathSize min_ros)
+{
+  const Key k{weather, weather_daily, nd, key};
+  auto& s = shard(weather);
+  {
+    std::shared_lock<std::shared_mutex> lock(s.mutex);
+    const auto seek = s.spread.find(k);
+    if (s.spread.end() != seek)
+    {
+      return SpreadInfo(seek->second, time, min_ros, scenario.memory());
+    }
+  }
+  // calculate without holding lock since this is the slow part
+  SpreadInfo spread(time,
+                    Settings::minimumRos(),
+                    scenario.cellSize(),
+                    key,
+                    nd,
+                    weather,
+                    weather_daily);
+  SpreadInfo result(spread, time, min_ros, scenario.memory());
+  // offsets are what takes up space, so limit by bytes and not by number of calculations
+  if (bytes_ < MAX_BYTES)
+  {
+    spread.offsets_.shrink_to_fit();
+    const auto bytes = entryBytes(spread);
+    std::unique_lock<std::shared_mutex> lock(s.mutex);
+    // another thread might have calculated the same thing in the meantime
+    if (s.spread.try_emplace(k, std::move(spread)).second)
+    {
+      ++size_;
+      bytes_ += bytes;
+    }
+  }
+  return result;
+}
+}
@@ -0,0 +1,107 @@
+/* Copyright (c) His Majesty the King in Right of Canada as represented by the Minister of Natural Resources, 2024. */
+
+/* SPDX-License-Identifier: AGPL-3.0-or-later */
+
+#pragma once
+#include <array>
+#include <atomic>
+#include <map>
+#include <shared_mutex>
+#include <tuple>
+#include "FireSpread.h"
+namespace tbd::sim
+{
+/**
+ * \brief Spread calculations shared between all Scenarios that use the same weather.
+ *
+ * Spread is calculated once for each weather, foliar moisture and SpreadKey using the
+ * lowest minimum rate of spread, and each Scenario gets a copy limited to its own minimum.
+ */
+class SpreadInfoCache
+{
+public:
+  SpreadInfoCache() = default;
+  ~SpreadInfoCache() = default;
+  SpreadInfoCache(const SpreadInfoCache& rhs) = delete;
+  SpreadInfoCache(SpreadInfoCache&& rhs) = delete;
+  SpreadInfoCache& operator=(const SpreadInfoCache& rhs) = delete;
+  SpreadInfoCache& operator=(SpreadInfoCache&& rhs) = delete;
+  /**
+   * \brief Calculate fire spread for time and place, reusing previous calculations if possible
+   * \param scenario Scenario this is spreading in
+   * \param time Time spread is occurring
+   * \param key Attributes for Cell spread is occurring in
+   * \param nd Difference between date and the date of minimum foliar moisture content
+   * \param weather FwiWeather to use for calculations
+   * \param weather_daily FwiWeather to use for probability of spread
+   * \param min_ros Minimum rate of spread for this Scenario (m/min)
+   * \return Spread limited to the given minimum rate of spread
+   */
+  [[nodiscard]] SpreadInfo calculate(const Scenario& scenario,
+                                     DurationSize time,
+                                     const topo::SpreadKey& key,
+                                     int nd,
+                                     const wx::FwiWeather* weather,
+                                     const wx::FwiWeather* weather_daily,
+                                     MathSize min_ros);
+  /**
+   * \brief Number of calculations that are cached
+   * \return Number of calculations that are cached
+   */
+  [[nodiscard]] size_t size() const noexcept
+  {
+    return size_;
+  }
+private:
+  /**
+   * \brief Weather, daily weather, foliar moisture and SpreadKey that spread depends on
+   */
+  using Key = std::tuple<const wx::FwiWeather*, const wx::FwiWeather*, int, topo::SpreadKey>;
+  /**
+   * \brief Part of the cache with its own lock so different weather doesn't contend
+   */
+  struct Shard
+  {
+    /**
+     * \brief Mutex for parallel access
+     */
+    std::shared_mutex mutex{};
+    /**
+     * \brief Spread calculated at the lowest minimum rate of spread
+     */
+    map<Key, SpreadInfo> spread{};
+  };
+  /**
+   * \brief Number of Shards to split cache into
+   */
+  static constexpr size_t NUM_SHARDS = 64;
+  /**
+   * \brief Stop adding to cache once it uses this many bytes so memory use is limited
+   */
+  static constexpr size_t MAX_BYTES = static_cast<size_t>(1) << 30;
+  /**
+   * \brief Approximate number of bytes a calculation uses once it is in the cache
+   * \param spread Calculation to find size of
+   * \return Approximate number of bytes a calculation uses once it is in the cache
+   */
+  [[nodiscard]] static size_t entryBytes(const SpreadInfo& spread) noexcept;
+  /**
+   * \brief Shard that calculations for the given weather are in
+   * \param weather FwiWeather to find Shard for
+   * \return Shard that calculations for the given weather are in
+   */
+  [[nodiscard]] Shard& shard(const wx::FwiWeather* weather) noexcept;
+  /**
+   * \brief Parts of the cache
+   */
+  array<Shard, NUM_SHARDS> shards_{};
+  /**
+   * \brief Number of calculations that are cached
+   */
+  std::atomic<size_t> size_{0};
+  /**
+   * \brief Approximate number of bytes used by calculations that are cached
+   */
+  std::atomic<size_t> bytes_{0};
+};
+}
@@ -118,6 +118,39 @@ static constexpr array<MathSize, 100> T_VALUES{
   1.290,
   1.290,
   1.290};
+/**
+ * \brief Calculate Student's T value
+ * \param n Number of values
+ * \param mean Mean (average) value
+ * \param sample_variance Sample variance
+ * \return Student's T value
+ */
+[[nodiscard]] inline MathSize students_t(const size_t n,
+                                         const MathSize mean,
+                                         const MathSize sample_variance) noexcept
+{
+  return T_VALUES[std::min(T_VALUES.size(), n) - 1]
+       * sqrt(sample_variance / n) / abs(mean);
+}
+/**
+ * \brief Estimate how many more runs are required to achieve desired confidence
+ * \param n Number of values
+ * \param mean Mean (average) value
+ * \param sample_variance Sample variance
+ * \param relative_error Relative Error to achieve to be confident
+ * \return Number of runs still required
+ */
+[[nodiscard]] inline size_t runs_for_confidence(const size_t n,
+                                                const MathSize mean,
+                                                const MathSize sample_variance,
+                                                const MathSize relative_error)
+{
+  const auto re = relative_error / (1 + relative_error);
+  const std::function<MathSize(size_t)> fct = [mean, sample_variance](const size_t i) noexcept {
+    return students_t(i, mean, sample_variance);
+  };
+  return binary_find_checked(n, 10 * n, re, fct) - n;
+}
 /**
  * \brief Provides statistics calculation for vectors of values.
  */
@@ -277,8 +310,7 @@ public:
    */
   [[nodiscard]] MathSize studentsT() const noexcept
   {
-    const auto result = T_VALUES[std::min(T_VALUES.size(), n()) - 1]
-                      * sqrt(sampleVariance() / n()) / abs(mean());
+    const auto result = students_t(n(), mean(), sampleVariance());
     // printf("%ld %f %f %f\n", n(), mean(), sampleVariance(), result);
     return result;
   }
@@ -304,13 +336,7 @@ public:
     // const size_t cur_runs,
     const MathSize relative_error) const
   {
-    const auto re = relative_error / (1 + relative_error);
-    const std::function<MathSize(size_t)> fct = [this](const size_t i) noexcept {
-      return T_VALUES[std::min(T_VALUES.size(), i) - 1]
-           * sqrt(sampleVariance() / i) / abs(mean());
-    };
-    const auto cur_runs = n();
-    return binary_find_checked(cur_runs, 10 * cur_runs, re, fct) - cur_runs;
+    return runs_for_confidence(n(), mean(), sampleVariance(), relative_error);
   }
 private:
   /**
@@ -355,5 +381,123 @@ private:
    */
   array<MathSize, 101> percentiles_{};
 };
+/**
+ * \brief Statistics that are updated as each value is added, without keeping the values.
+ *
+ * Uses Welford's method so mean and variance match the two-pass calculation that
+ * Statistics does to within floating point rounding (relative error around n * epsilon).
+ */
+class RunningStatistics
+{
+public:
+  /**
+   * \brief Add a value
+   * \param value Value to add
+   */
+  void add(const MathSize value) noexcept
+  {
+    if (0 == n_)
+    {
+      min_ = value;
+      max_ = value;
+    }
+    else
+    {
+      min_ = std::min(min_, value);
+      max_ = std::max(max_, value);
+    }
+    ++n_;
+    const auto delta = value - mean_;
+    mean_ += delta / static_cast<MathSize>(n_);
+    m2_ += delta * (value - mean_);
+  }
+  /**
+   * \brief Number of values
+   * \return Number of values
+   */
+  [[nodiscard]] size_t n() const noexcept
+  {
+    return n_;
+  }
+  /**
+   * \brief Minimum value
+   * \return Minimum value
+   */
+  [[nodiscard]] MathSize min() const noexcept
+  {
+    return min_;
+  }
+  /**
+   * \brief Maximum value
+   * \return Maximum value
+   */
+  [[nodiscard]] MathSize max() const noexcept
+  {
+    return max_;
+  }
+  /**
+   * \brief Mean (average) value
+   * \return Mean (average) value
+   */
+  [[nodiscard]] MathSize mean() const noexcept
+  {
+    return mean_;
+  }
+  /**
+   * \brief Sample variance
+   * \return Sample variance
+   */
+  [[nodiscard]] MathSize sampleVariance() const noexcept
+  {
+    return m2_ / static_cast<MathSize>(n_ - 1);
+  }
+  /**
+   * \brief Calculate Student's T value
+   * \return Student's T value
+   */
+  [[nodiscard]] MathSize studentsT() const noexcept
+  {
+    return students_t(n(), mean(), sampleVariance());
+  }
+  /**
+   * \brief Whether or not we have less than the relative error and can be confident in the results
+   * \param relative_error Relative Error that is required
+   * \return If Student's T value is less than the relative error
+   */
+  [[nodiscard]] bool isConfident(const MathSize relative_error) const noexcept
+  {
+    return studentsT() <= relative_error / (1 + relative_error);
+  }
+  /**
+   * \brief Estimate how many more runs are required to achieve desired confidence
+   * \param relative_error Relative Error to achieve to be confident
+   * \return Number of runs still required
+   */
+  [[nodiscard]] size_t runsRequired(const MathSize relative_error) const
+  {
+    return runs_for_confidence(n(), mean(), sampleVariance(), relative_error);
+  }
+private:
+  /**
+   * \brief Number of values
+   */
+  size_t n_{0};
+  /**
+   * \brief Minimum value
+   */
+  MathSize min_{0};
+  /**
+   * \brief Maximum value
+   */
+  MathSize max_{0};
+  /**
+   * \brief Mean (average) value
+   */
+  MathSize mean_{0};
+  /**
+   * \brief Sum of squared differences from the mean
+   */
+  MathSize m2_{0};
+};
 }
 }
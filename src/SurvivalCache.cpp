@@ -0,0 +1,303 @@
+/* Copyright (c) His Majesty the King in Right of Canada as represented by the Minister of Natural Resources, 2024. */
+
+/* SPDX-License-Identifier: AGPL-3.0-or-later */
+
+#include "stdafx.h"
+#include "SurvivalCache.h"
+#include <cstring>
+#include <filesystem>
+#include <thread>
+#include "FuelType.h"
+#include "Log.h"
+#include "MappedFile.h"
+#include "Settings.h"
+#include "WorkerPool.h"
+#ifdef _WIN32
+#include <process.h>
+#else
+#include <unistd.h>
+#endif
+namespace fs = std::filesystem;
+namespace tbd::wx
+{
+/**
+ * \brief Identifies file as cached survival tables
+ */
+static constexpr char CACHE_MAGIC[8] = {'F', 'S', 'S', 'U', 'R', 'V', '\0', '\0'};
+/**
+ * \brief Version of file layout, which also needs to change if survival calculations do
+ */
+static constexpr uint32_t CACHE_VERSION = 2;
+/**
+ * \brief Start of cached survival tables
+ *
+ * This is followed by a StreamHeader for each stream, and then the tables for each stream
+ * in the same order, with each fuel's table in order of fuel code.
+ */
+struct CacheHeader
+{
+  char magic[8];
+  uint32_t version;
+  uint32_t streams;
+  /**
+   * \brief Hash of everything the tables depend on
+   */
+  uint64_t key;
+};
+/**
+ * \brief Description of tables for a single stream
+ */
+struct StreamHeader
+{
+  uint16_t min_date;
+  uint16_t max_date;
+  uint32_t unused;
+  uint64_t weighted_dsr;
+  /**
+   * \brief Number of values in table for each fuel code, which is 0 for fuels that aren't used
+   */
+  uint32_t lengths[NUMBER_OF_FUELS];
+};
+/**
+ * \brief Modification time and size of a file
+ * \param filename File to check
+ * \return Modification time and size of file
+ */
+static std::array<int64_t, 2> file_stats(const string& filename)
+{
+  struct stat info
+  {
+  };
+  logging::check_fatal(0 != stat(filename.c_str(), &info), "Unable to read %s", filename.c_str());
+  return {static_cast<int64_t>(info.st_mtime), static_cast<int64_t>(info.st_size)};
+}
+uint64_t survival_key(const string& weather_file,
+                      const FwiWeather& yesterday,
+                      const MathSize latitude,
+                      const set<const fuel::FuelType*>& lookup_fuels)
+{
+  auto result = util::hash_bytes(&CACHE_VERSION, sizeof CACHE_VERSION);
+  const auto stats = file_stats(weather_file);
+  result = util::hash_bytes(stats.data(), sizeof stats, result);
+  const MathSize values[] = {
+    yesterday.temp().asValue(),
+    yesterday.rh().asValue(),
+    yesterday.wind().speed().asValue(),
+    yesterday.wind().direction().asValue(),
+    yesterday.prec().asValue(),
+    yesterday.ffmc().asValue(),
+    yesterday.dmc().asValue(),
+    yesterday.dc().asValue(),
+    yesterday.isi().asValue(),
+    yesterday.bui().asValue(),
+    yesterday.fwi().asValue(),
+    latitude};
+  result = util::hash_bytes(values, sizeof values, result);
+  const auto deterministic = sim::Settings::deterministic();
+  result = util::hash_bytes(&deterministic, sizeof deterministic, result);
+  // codes are for the fuels that the lookup table and default percentages map to
+  for (const auto& fuel : lookup_fuels)
+  {
+    const auto code = fuel::FuelType::safeCode(fuel);
+    result = util::hash_bytes(&code, sizeof code, result);
+  }
+  return result;
+}
+/**
+ * \brief Read survival tables from cache file
+ * \param cache_file File to read from
+ * \param key Hash that cache file needs to match
+ * \param streams Streams that tables are needed for
+ * \param result Tables that were read
+ * \return Whether tables were read
+ */
+static bool read_cache(const string& cache_file,
+                       const uint64_t key,
+                       const vector<SurvivalInput>& streams,
+                       vector<SurvivalTables>* result)
+{
+  if (!util::file_exists(cache_file.c_str()))
+  {
+    return false;
+  }
+  const util::MappedFile file(cache_file);
+  const auto data = file.data();
+  const auto size = file.size();
+  CacheHeader header{};
+  if (size < sizeof header)
+  {
+    return false;
+  }
+  memcpy(&header, data, sizeof header);
+  if (0 != memcmp(header.magic, CACHE_MAGIC, sizeof CACHE_MAGIC)
+      || CACHE_VERSION != header.version
+      || key != header.key
+      || streams.size() != header.streams)
+  {
+    return false;
+  }
+  size_t offset = sizeof header + streams.size() * sizeof(StreamHeader);
+  if (size < offset)
+  {
+    return false;
+  }
+  vector<SurvivalTables> tables(streams.size());
+  for (size_t i = 0; i < streams.size(); ++i)
+  {
+    StreamHeader stream{};
+    memcpy(&stream, data + sizeof header + i * sizeof stream, sizeof stream);
+    if (streams[i].min_date != stream.min_date || streams[i].max_date != stream.max_date)
+    {
+      return false;
+    }
+    tables[i].weighted_dsr = static_cast<size_t>(stream.weighted_dsr);
+    for (size_t f = 0; f < NUMBER_OF_FUELS; ++f)
+    {
+      const size_t length = stream.lengths[f];
+      const auto bytes = length * sizeof(float);
+      if (size < offset + bytes)
+      {
+        return false;
+      }
+      auto& table = tables[i].survival[f];
+      table.resize(length);
+      memcpy(table.data(), data + offset, bytes);
+      offset += bytes;
+    }
+  }
+  if (size != offset)
+  {
+    return false;
+  }
+  *result = std::move(tables);
+  return true;
+}
+/**
+ * \brief Save survival tables to cache file
+ * \param cache_file File to save to
+ * \param key Hash of everything the tables depend on
+ * \param streams Streams that tables are for
+ * \param tables Tables to save
+ */
+static void save_cache(const string& cache_file,
+                       const uint64_t key,
+                       const vector<SurvivalInput>& streams,
+                       const vector<SurvivalTables>& tables)
+{
+  // write to temporary file and rename so nothing reads a partial file, using the
+  // process id so processes that save at the same time don't write to the same file
+#ifdef _WIN32
+  const auto pid = _getpid();
+#else
+  const auto pid = getpid();
+#endif
+  const auto tmp_name = cache_file + "." + to_string(pid) + ".tmp";
+  {
+    ofstream out(tmp_name, std::ios::binary);
+    if (!out.good())
+    {
+      logging::warning("Unable to save survival tables to %s", cache_file.c_str());
+      return;
+    }
+    CacheHeader header{};
+    memcpy(header.magic, CACHE_MAGIC, sizeof CACHE_MAGIC);
+    header.version = CACHE_VERSION;
+    header.streams = static_cast<uint32_t>(streams.size());
+    header.key = key;
+    out.write(reinterpret_cast<const char*>(&header), sizeof header);
+    for (size_t i = 0; i < streams.size(); ++i)
+    {
+      StreamHeader stream{};
+      stream.min_date = streams[i].min_date;
+      stream.max_date = streams[i].max_date;
+      stream.weighted_dsr = tables[i].weighted_dsr;
+      for (size_t f = 0; f < NUMBER_OF_FUELS; ++f)
+      {
+        stream.lengths[f] = static_cast<uint32_t>(tables[i].survival[f].size());
+      }
+      out.write(reinterpret_cast<const char*>(&stream), sizeof stream);
+    }
+    for (const auto& t : tables)
+    {
+      for (const auto& table : t.survival)
+      {
+        out.write(reinterpret_cast<const char*>(table.data()),
+                  static_cast<std::streamsize>(table.size() * sizeof(float)));
+      }
+    }
+    if (!out.good())
+    {
+      logging::warning("Unable to save survival tables to %s", cache_file.c_str());
+      out.close();
+      std::remove(tmp_name.c_str());
+      return;
+    }
+  }
+  std::error_code ec;
+  fs::rename(tmp_name, cache_file, ec);
+  if (ec)
+  {
+    logging::warning("Unable to save survival tables to %s: %s",
+                     cache_file.c_str(),
+                     ec.message().c_str());
+    fs::remove(tmp_name, ec);
+  }
+}
+/**
+ * \brief Free tables for fuels that aren't used
+ * \param used_fuels set of FuelTypes that are used in the simulation
+ * \param tables Tables to remove unused fuels from
+ */
+static void keep_used(const set<const fuel::FuelType*>& used_fuels,
+                      vector<SurvivalTables>* tables)
+{
+  std::array<bool, NUMBER_OF_FUELS> is_used{};
+  for (const auto& fuel : used_fuels)
+  {
+    is_used[fuel::FuelType::safeCode(fuel)] = true;
+  }
+  for (auto& t : *tables)
+  {
+    for (size_t f = 0; f < NUMBER_OF_FUELS; ++f)
+    {
+      if (!is_used[f])
+      {
+        vector<float>().swap(t.survival[f]);
+      }
+    }
+  }
+}
+vector<SurvivalTables> load_survival(const string& cache_file,
+                                     const uint64_t key,
+                                     const set<const fuel::FuelType*>& lookup_fuels,
+                                     const set<const fuel::FuelType*>& used_fuels,
+                                     const vector<SurvivalInput>& streams)
+{
+  vector<SurvivalTables> result{};
+  if (read_cache(cache_file, key, streams, &result))
+  {
+    logging::note("Using survival tables from %s", cache_file.c_str());
+    keep_used(used_fuels, &result);
+    return result;
+  }
+  logging::note("Calculating survival tables for %ld weather streams", streams.size());
+  result.resize(streams.size());
+  {
+    util::WorkerPool pool(max(static_cast<size_t>(1),
+                              min(streams.size(),
+                                  static_cast<size_t>(std::thread::hardware_concurrency()))));
+    for (size_t i = 0; i < streams.size(); ++i)
+    {
+      pool.submit([&, i]() {
+        const auto& s = streams[i];
+        result[i].survival = make_survival(lookup_fuels, s.min_date, s.max_date, *s.weather);
+        result[i].weighted_dsr = make_weighted_dsr(*s.weather);
+      });
+    }
+    pool.wait();
+  }
+  save_cache(cache_file, key, streams, result);
+  keep_used(used_fuels, &result);
+  return result;
+}
+}
@@ -0,0 +1,77 @@
+/* Copyright (c) His Majesty the King in Right of Canada as represented by the Minister of Natural Resources, 2024. */
+
+/* SPDX-License-Identifier: AGPL-3.0-or-later */
+
+#pragma once
+#include <set>
+#include <string>
+#include <vector>
+#include "FireWeather.h"
+namespace tbd::wx
+{
+/**
+ * \brief Weather stream that survival probabilities are needed for
+ */
+struct SurvivalInput
+{
+  /**
+   * \brief Minimum date present in stream
+   */
+  Day min_date;
+  /**
+   * \brief Maximum date present in stream
+   */
+  Day max_date;
+  /**
+   * \brief FwiWeather by hour by Day
+   */
+  const vector<const FwiWeather*>* weather;
+};
+/**
+ * \brief Values calculated from a weather stream that only depend on weather and fuels
+ */
+struct SurvivalTables
+{
+  /**
+   * \brief Probability of survival for each fuel at each hour
+   */
+  SurvivalMap survival;
+  /**
+   * \brief Weighted Danger Severity Rating for the stream
+   */
+  size_t weighted_dsr;
+};
+/**
+ * \brief Hash of everything that survival tables for weather from a file depend on
+ *
+ * The weather file is identified by its size and modification time instead of its
+ * contents so that it doesn't need to be read again to check the cache.
+ * \param weather_file File that hourly weather was read from
+ * \param yesterday FwiWeather for yesterday that daily weather starts from
+ * \param latitude Latitude used for daily weather
+ * \param lookup_fuels set of FuelTypes that the fuel lookup table has codes for
+ * \return Hash to identify survival tables with
+ */
+[[nodiscard]] uint64_t survival_key(const string& weather_file,
+                                    const FwiWeather& yesterday,
+                                    MathSize latitude,
+                                    const set<const fuel::FuelType*>& lookup_fuels);
+/**
+ * \brief Read survival tables from cache file if it matches, or else calculate and save them
+ *
+ * Tables are calculated and saved for every fuel in the lookup table so the cache doesn't
+ * depend on which fuels are in the area being simulated, but only tables for fuels that
+ * are used are returned. Streams are calculated in parallel when the cache can't be used.
+ * \param cache_file File to read from and save to
+ * \param key Hash from survival_key() that cache file needs to match
+ * \param lookup_fuels set of FuelTypes that the fuel lookup table has codes for
+ * \param used_fuels set of FuelTypes that are used in the simulation
+ * \param streams Streams to get tables for
+ * \return Tables for each stream, in the same order as streams
+ */
+[[nodiscard]] vector<SurvivalTables> load_survival(const string& cache_file,
+                                                   uint64_t key,
+                                                   const set<const fuel::FuelType*>& lookup_fuels,
+                                                   const set<const fuel::FuelType*>& used_fuels,
+                                                   const vector<SurvivalInput>& streams);
+}
@@ -5,15 +5,36 @@
 
 #include "stdafx.h"
 #include "Test.h"
+#include "CellPoints.h"
+#include "EnvironmentCache.h"
+#include "EventScheduler.h"
 #include "FireSpread.h"
 #include "Model.h"
 #include "Observer.h"
+#include "TileCompression.h"
+#include "Trig.h"
 #include "Util.h"
+#include "UTM.h"
+#include "WeatherReader.h"
 #include "ConstantWeather.h"
 
 namespace tbd::sim
 {
 using tbd::fuel::simplify_fuel_name;
+/**
+ * \brief Summary of the cells that burned in a test, used to check that results don't change
+ */
+struct TestResult
+{
+  /**
+   * \brief Number of cells that burned
+   */
+  size_t cells;
+  /**
+   * \brief Sum of arrival times for cells that burned
+   */
+  MathSize arrival_sum;
+};
 /**
  * \brief An Environment with no elevation and the same value in every Cell.
  */
@@ -78,6 +99,34 @@ public:
     // cast to avoid warning
     static_cast<void*>(reset(nullptr, nullptr, reinterpret_cast<util::SafeVector*>(&final_sizes_)));
   }
+  /**
+   * \brief Summarize cells that have burned
+   * \return Number of cells that burned and sum of their arrival times
+   */
+  [[nodiscard]] TestResult result() const
+  {
+    TestResult r{arrival_->size(), 0.0};
+    arrival_->forEach([&r](const Location&, const DurationSize time) { r.arrival_sum += time; });
+    return r;
+  }
+  /**
+   * \brief How many times spread reached the outside edge of the window
+   * \return How many times spread reached the outside edge of the window
+   */
+  [[nodiscard]] size_t oobSpread() const noexcept
+  {
+    return oob_spread_;
+  }
+  /**
+   * \brief Arrival time for every cell that burned
+   * \return Arrival time for every cell that burned
+   */
+  [[nodiscard]] map<Location, DurationSize> arrivals() const
+  {
+    map<Location, DurationSize> result{};
+    arrival_->forEach([&result](const Location& location, const DurationSize time) { result.emplace(location, time); });
+    return result;
+  }
 };
 void showSpread(const SpreadInfo& spread, const wx::FwiWeather* w, const fuel::FuelType* fuel)
 {
@@ -188,7 +237,9 @@ string run_test(const string base_directory,
                 const wx::Dmc& dmc,
                 const wx::Ffmc& ffmc,
                 const wx::Wind& wind,
-                const bool ignore_existing)
+                const bool ignore_existing,
+                TestResult* result = nullptr,
+                map<Location, DurationSize>* arrivals = nullptr)
 {
   string test_name = generate_test_name(
     fuel_name,
@@ -269,6 +320,14 @@ string run_test(const string base_directory,
   logging::note("Final Size: %0.0f, ROS: %0.2f",
                 scenario.currentFireSize(),
                 info.headRos());
+  if (nullptr != result)
+  {
+    *result = scenario.result();
+  }
+  if (nullptr != arrivals)
+  {
+    *arrivals = scenario.arrivals();
+  }
   return output_directory;
 }
 string run_test_ignore_existing(
@@ -342,6 +401,796 @@ static const wx::Precipitation PREC(0.0);
 const vector<string> FUEL_NAMES{"C-2", "O-1a", "M-1/M-2 (25 PC)", "S-1", "C-3"};
 const auto DEFAULT_FUEL_NAME = simplify_fuel_name(FUEL_NAMES[0]);
 
+/**
+ * \brief Check that a tile written by compress_tile() reads back as the same data through libtiff
+ * \tparam R Type of samples in tile
+ * \param output_directory Folder to write test file to
+ * \param compression TIFF compression tag value
+ * \param predictor TIFF predictor tag value
+ */
+template <class R>
+static void check_tile_round_trip(const string& output_directory,
+                                  const uint16_t compression,
+                                  const uint16_t predictor)
+{
+  // big enough that LZW runs out of codes and has to reset its table
+  constexpr uint32_t TILE_SIZE = 128;
+  constexpr auto NUM_SAMPLES = static_cast<size_t>(TILE_SIZE) * TILE_SIZE;
+  vector<R> values(NUM_SAMPLES);
+  uint32_t state = 12345;
+  for (size_t i = 0; i < NUM_SAMPLES; ++i)
+  {
+    // mix smooth areas that compress well with noise that doesn't
+    state = state * 1664525 + 1013904223;
+    const auto noise = static_cast<R>((state >> 16) % 100);
+    values[i] = (i / TILE_SIZE) % 2 == 0 ? static_cast<R>(i % TILE_SIZE) : noise;
+  }
+  vector<uint8_t> original(NUM_SAMPLES * sizeof(R));
+  memcpy(original.data(), values.data(), original.size());
+  auto tile = original;
+  auto compressed = data::compress_tile(compression, predictor, sizeof(R), TILE_SIZE, tile);
+  const auto file_name = output_directory + "/tile_" + std::to_string(compression) + "_"
+                       + std::to_string(predictor) + "_" + std::to_string(sizeof(R)) + ".tif";
+  auto tif = TIFFOpen(file_name.c_str(), "w");
+  logging::check_fatal(nullptr == tif, "Can't open %s", file_name.c_str());
+  if (std::is_floating_point<R>::value)
+  {
+    TIFFSetField(tif, TIFFTAG_SAMPLEFORMAT, SAMPLEFORMAT_IEEEFP);
+  }
+  TIFFSetField(tif, TIFFTAG_IMAGEWIDTH, TILE_SIZE);
+  TIFFSetField(tif, TIFFTAG_IMAGELENGTH, TILE_SIZE);
+  TIFFSetField(tif, TIFFTAG_SAMPLESPERPIXEL, 1);
+  TIFFSetField(tif, TIFFTAG_BITSPERSAMPLE, static_cast<uint16_t>(8 * sizeof(R)));
+  TIFFSetField(tif, TIFFTAG_TILEWIDTH, TILE_SIZE);
+  TIFFSetField(tif, TIFFTAG_TILELENGTH, TILE_SIZE);
+  TIFFSetField(tif, TIFFTAG_PLANARCONFIG, PLANARCONFIG_CONTIG);
+  TIFFSetField(tif, TIFFTAG_COMPRESSION, compression);
+  TIFFSetField(tif, TIFFTAG_PREDICTOR, predictor);
+  logging::check_fatal(static_cast<tmsize_t>(compressed.size())
+                         != TIFFWriteRawTile(tif, 0, compressed.data(), static_cast<tmsize_t>(compressed.size())),
+                       "Can't write tile to %s",
+                       file_name.c_str());
+  TIFFClose(tif);
+  tif = TIFFOpen(file_name.c_str(), "r");
+  logging::check_fatal(nullptr == tif, "Can't open %s", file_name.c_str());
+  vector<uint8_t> decoded(original.size());
+  const auto size = TIFFReadEncodedTile(tif, 0, decoded.data(), static_cast<tmsize_t>(decoded.size()));
+  TIFFClose(tif);
+  logging::check_fatal(static_cast<tmsize_t>(original.size()) != size || original != decoded,
+                       "Tile in %s doesn't match after compression %d with predictor %d",
+                       file_name.c_str(),
+                       compression,
+                       predictor);
+  std::remove(file_name.c_str());
+}
+/**
+ * \brief Check that tiles compress the way libtiff expects for every compression and predictor
+ * \param output_directory Folder to write test files to
+ */
+static void test_tile_compression(const string& output_directory)
+{
+  util::make_directory_recursive(output_directory.c_str());
+  for (const auto compression : {COMPRESSION_LZW, COMPRESSION_ADOBE_DEFLATE})
+  {
+    check_tile_round_trip<uint8_t>(output_directory, compression, PREDICTOR_NONE);
+    check_tile_round_trip<uint8_t>(output_directory, compression, PREDICTOR_HORIZONTAL);
+    check_tile_round_trip<uint16_t>(output_directory, compression, PREDICTOR_HORIZONTAL);
+    check_tile_round_trip<float>(output_directory, compression, PREDICTOR_FLOATINGPOINT);
+    check_tile_round_trip<double>(output_directory, compression, PREDICTOR_FLOATINGPOINT);
+  }
+  logging::note("Tile compression matches libtiff");
+}
+/**
+ * \brief Check that overviews have every tile at the edges when sizes aren't multiples of tile size
+ */
+static void test_tile_levels()
+{
+  constexpr size_t TILE_WIDTH = 4;
+  constexpr size_t TILE_HEIGHT = 4;
+  constexpr uint8_t NO_DATA = 0;
+  // 5 x 3 tiles so the first overview is 10 x 6 pixels and only partly fills its edge tiles
+  data::TileLevel level{5 * TILE_WIDTH, 3 * TILE_HEIGHT, 5, 3, {}};
+  level.tiles.assign(level.tiles_across * level.tiles_down, vector<uint8_t>(TILE_WIDTH * TILE_HEIGHT, 1));
+  while (level.tiles_across > 1 || level.tiles_down > 1)
+  {
+    level = data::reduce_level<uint8_t>(level, TILE_WIDTH, TILE_HEIGHT, NO_DATA, data::OverviewReduction::Average);
+    logging::check_fatal(data::tiles_for(level.width, TILE_WIDTH) != level.tiles_across
+                           || data::tiles_for(level.height, TILE_HEIGHT) != level.tiles_down
+                           || level.tiles_across * level.tiles_down != level.tiles.size(),
+                         "Overview of %ld x %ld has %ld x %ld tiles",
+                         level.width,
+                         level.height,
+                         level.tiles_across,
+                         level.tiles_down);
+    for (size_t y = 0; y < level.height; ++y)
+    {
+      for (size_t x = 0; x < level.width; ++x)
+      {
+        const auto& tile = level.tiles[(y / TILE_HEIGHT) * level.tiles_across + x / TILE_WIDTH];
+        logging::check_fatal(tile.empty() || 1 != tile[(y % TILE_HEIGHT) * TILE_WIDTH + x % TILE_WIDTH],
+                             "Overview of %ld x %ld is missing pixel (%ld, %ld)",
+                             level.width,
+                             level.height,
+                             x,
+                             y);
+      }
+    }
+  }
+  logging::note("Overviews cover partial tiles at edges");
+  // categories like direction bitmasks need to stay values that were in the image
+  data::TileLevel categories{2 * TILE_WIDTH, 2 * TILE_HEIGHT, 2, 2, {}};
+  const uint8_t BLOCK[4][4]{{1, 4, 4, 4}, {4, 1, 8, 2}, {NO_DATA, NO_DATA, NO_DATA, 2}, {8, 1, 1, 8}};
+  for (size_t i = 0; i < 4; ++i)
+  {
+    categories.tiles.emplace_back(TILE_WIDTH * TILE_HEIGHT);
+    for (size_t p = 0; p < TILE_WIDTH * TILE_HEIGHT; ++p)
+    {
+      // same 2x2 block everywhere in the tile so every overview pixel sees it
+      categories.tiles[i][p] = BLOCK[i][((p / TILE_WIDTH) % 2) * 2 + p % 2];
+    }
+  }
+  const auto reduced = data::reduce_level<uint8_t>(categories, TILE_WIDTH, TILE_HEIGHT, NO_DATA, data::OverviewReduction::Mode);
+  // most common value, then first value if all different, then only value, then first value if tied
+  const uint8_t EXPECTED[4]{4, 4, 2, 8};
+  for (size_t y = 0; y < reduced.height; ++y)
+  {
+    for (size_t x = 0; x < reduced.width; ++x)
+    {
+      const auto quadrant = (y / (TILE_HEIGHT / 2)) * 2 + x / (TILE_WIDTH / 2);
+      const auto value = reduced.tiles[0][y * TILE_WIDTH + x];
+      logging::check_fatal(EXPECTED[quadrant] != value,
+                           "Overview has %d at (%ld, %ld) instead of most common value %d",
+                           value,
+                           x,
+                           y,
+                           EXPECTED[quadrant]);
+    }
+  }
+  logging::note("Overviews of categories only use values from the image");
+}
+/**
+ * \brief Closest point to the outer target for each direction in a cell, found by checking
+ * each point in order like CellPoints did before it stored directions in separate arrays
+ * \param cell Location of cell
+ * \param points Points in cell in the order they were inserted
+ * \return Closest point in each direction, relative to cell
+ */
+static std::array<InnerPos, NUM_DIRECTIONS> expected_cell_points(const Location& cell, const vector<XYPos>& points)
+{
+  constexpr auto DIST_22_5 = static_cast<DistanceSize>(0.2071067811865475244008443621048490392848359376884740365883398689);
+  constexpr auto P_0_5 = static_cast<DistanceSize>(0.5) + DIST_22_5;
+  constexpr auto M_0_5 = static_cast<DistanceSize>(0.5) - DIST_22_5;
+  static constexpr std::array<pair<DistanceSize, DistanceSize>, NUM_DIRECTIONS> OUTER{
+    {{0.5, 1.0},
+     {P_0_5, 1.0},
+     {1.0, 1.0},
+     {1.0, P_0_5},
+     {1.0, 0.5},
+     {1.0, M_0_5},
+     {1.0, 0.0},
+     {P_0_5, 0.0},
+     {0.5, 0.0},
+     {M_0_5, 0.0},
+     {0.0, 0.0},
+     {0.0, M_0_5},
+     {0.0, 0.5},
+     {0.0, P_0_5},
+     {0.0, 1.0},
+     {M_0_5, 1.0}}};
+  const auto cell_x = cell.column();
+  const auto cell_y = cell.row();
+  std::array<pair<DistanceSize, InnerPos>, NUM_DIRECTIONS> closest{};
+  std::fill(closest.begin(), closest.end(), pair<DistanceSize, InnerPos>{numeric_limits<DistanceSize>::max(), {}});
+  for (const auto& p : points)
+  {
+    const auto p0 = InnerPos(static_cast<InnerSize>(p.first - cell_x),
+                             static_cast<InnerSize>(p.second - cell_y));
+    const auto x0 = static_cast<DistanceSize>(p0.first);
+    const auto y0 = static_cast<DistanceSize>(p0.second);
+    for (size_t i = 0; i < NUM_DIRECTIONS; ++i)
+    {
+      const auto& [x1, y1] = OUTER[i];
+      const auto d = ((x0 - x1) * (x0 - x1) + (y0 - y1) * (y0 - y1));
+      if (d < closest[i].first)
+      {
+        closest[i] = {d, p0};
+      }
+    }
+  }
+  std::array<InnerPos, NUM_DIRECTIONS> result{};
+  for (size_t i = 0; i < NUM_DIRECTIONS; ++i)
+  {
+    result[i] = closest[i].second;
+  }
+  return result;
+}
+/**
+ * \brief Check that every cell in CellPointsMap has the expected points
+ * \param name Name of map to use in error message
+ * \param map Map to check
+ * \param by_cell Points that were added to each cell, in order
+ */
+static void check_cell_points(const char* name,
+                              CellPointsMap& map,
+                              const std::map<Location, vector<XYPos>>& by_cell)
+{
+  logging::check_fatal(map.size() != by_cell.size(),
+                       "%s has %ld cells but expected %ld",
+                       name,
+                       map.size(),
+                       by_cell.size());
+  map.for_each([&](const pair<Location, CellPoints>& kv) {
+    const auto it = by_cell.find(kv.first);
+    logging::check_fatal(by_cell.end() == it,
+                         "%s has unexpected cell (%d, %d)",
+                         name,
+                         kv.first.column(),
+                         kv.first.row());
+    const auto expected = expected_cell_points(kv.first, it->second);
+    for (size_t i = 0; i < NUM_DIRECTIONS; ++i)
+    {
+      logging::check_fatal(kv.second.pts_.point(i) != expected[i],
+                           "%s has wrong point in direction %ld for cell (%d, %d)",
+                           name,
+                           i,
+                           kv.first.column(),
+                           kv.first.row());
+    }
+  });
+}
+/**
+ * \brief Check that inserting into and merging CellPointsMaps keeps the closest point in each direction
+ */
+static void test_cell_points()
+{
+  constexpr size_t NUM_POINTS = 5000;
+  constexpr XYSize MIN_XY = 100;
+  constexpr XYSize RANGE_XY = 10;
+  std::mt19937 generator{42};
+  std::uniform_real_distribution<XYSize> distribution{0, RANGE_XY};
+  vector<XYPos> points{};
+  for (size_t i = 0; i < NUM_POINTS; ++i)
+  {
+    points.emplace_back(MIN_XY + distribution(generator), MIN_XY + distribution(generator));
+  }
+  // points a quarter of a cell from the edges are the same distance from the targets in
+  // the middle of the edges, and ties should keep the first point
+  constexpr XYSize MIN_GRID = MIN_XY + 2 * RANGE_XY + 0.25;
+  for (XYSize x = MIN_GRID; x < MIN_GRID + 2; x += 0.5)
+  {
+    for (XYSize y = MIN_GRID; y < MIN_GRID + 2; y += 0.5)
+    {
+      points.emplace_back(x, y);
+    }
+  }
+  const SpreadData spread{1.0, 1, 1.0, wx::Direction(0, false), wx::Direction::Invalid};
+  std::map<Location, vector<XYPos>> by_cell{};
+  CellPointsMap all{};
+  CellPointsMap first{};
+  CellPointsMap second{};
+  for (size_t i = 0; i < points.size(); ++i)
+  {
+    const auto& p = points[i];
+    by_cell[p.location()].push_back(p);
+    all.insert(p, spread, p.first, p.second);
+    // tied points are one or four points apart so every third one splits them up
+    (i % 3 == 0 ? first : second).insert(p, spread, p.first, p.second);
+  }
+  check_cell_points("Inserted CellPointsMap", all, by_cell);
+  // merging should be the same as inserting second half after first
+  std::map<Location, vector<XYPos>> by_cell_merged{};
+  for (const auto is_first : {true, false})
+  {
+    for (size_t i = 0; i < points.size(); ++i)
+    {
+      if (is_first == (i % 3 == 0))
+      {
+        by_cell_merged[points[i].location()].push_back(points[i]);
+      }
+    }
+  }
+  const auto unburnable = make_unique<BurnedData>();
+  first.merge(*unburnable, second);
+  check_cell_points("Merged CellPointsMap", first, by_cell_merged);
+  logging::note("CellPoints match closest point in each direction");
+}
+/**
+ * \brief Check that value from util::trig matches value from std::
+ * \param name Name of function and arguments to use in error message
+ * \param value Value from util::trig
+ * \param expected Value from std::
+ */
+static void check_trig(const char* name, const MathSize value, const MathSize expected)
+{
+  // results at signed zeros and on the axes are exact, so only allow error elsewhere
+  constexpr MathSize TRIG_EPSILON = 1e-15;
+  const auto is_exact = 0 == expected || std::abs(expected) == util::trig::PI_2 || std::abs(expected) == util::trig::PI;
+  const auto is_match = is_exact
+                        ? (value == expected && std::signbit(value) == std::signbit(expected))
+                        : std::abs(value - expected) <= TRIG_EPSILON * max(1.0, std::abs(expected));
+  logging::check_fatal(!is_match,
+                       "%s gives %.17g but std:: gives %.17g",
+                       name,
+                       value,
+                       expected);
+}
+/**
+ * \brief Check that util::trig functions match std:: over a range that includes signed zeros,
+ * the axes, and the boundaries between quadrants
+ */
+static void test_trig()
+{
+  using util::trig::PI;
+  using util::trig::PI_2;
+  vector<MathSize> values{-0.0, 0.0, -1e-300, 1e-300};
+  for (const auto v : {0.5, 1.0, 2.0, PI_2, PI, 1e300})
+  {
+    values.push_back(-v);
+    values.push_back(v);
+  }
+  // go past a full turn in both directions so every quadrant and boundary is covered
+  constexpr int STEPS_PER_QUADRANT = 90;
+  for (int i = -8 * STEPS_PER_QUADRANT; i <= 8 * STEPS_PER_QUADRANT; ++i)
+  {
+    values.push_back(i * PI_2 / STEPS_PER_QUADRANT);
+  }
+  // big enough for a function name and two arguments with every digit
+  char name[96]{0};
+  for (const auto x : values)
+  {
+    if (std::abs(x) < 1e300)
+    {
+      MathSize s;
+      MathSize c;
+      util::trig::sin_cos(x, &s, &c);
+      // sin() and cos() are only approximately 0 at multiples of pi / 2
+      logging::check_fatal(std::abs(s - std::sin(x)) > 1e-15 || std::abs(c - std::cos(x)) > 1e-15,
+                           "sin_cos(%.17g) gives (%.17g, %.17g) but std:: gives (%.17g, %.17g)",
+                           x,
+                           s,
+                           c,
+                           std::sin(x),
+                           std::cos(x));
+    }
+    sxprintf(name, "atan(%.17g)", x);
+    check_trig(name, util::trig::atan(x), std::atan(x));
+    if (std::abs(x) <= 1)
+    {
+      sxprintf(name, "acos(%.17g)", x);
+      check_trig(name, util::trig::acos(x), std::acos(x));
+    }
+    for (const auto y : values)
+    {
+      sxprintf(name, "atan2(%.17g, %.17g)", y, x);
+      check_trig(name, util::trig::atan2(y, x), std::atan2(y, x));
+    }
+  }
+  logging::note("Trigonometric functions match std::");
+}
+/**
+ * \brief Evaluate an Event the way Scenario would for checking an event queue
+ * \param event Event to evaluate
+ * \param generator Generator for when the next spread happens
+ * \param add Function to add an Event to queue
+ * \param clear Function to remove all Events from queue
+ * \param evaluated Time, type and intensity of every Event evaluated, in order
+ */
+template <class A, class C>
+static void evaluate_queued(const Event& event,
+                            std::mt19937* generator,
+                            A add,
+                            C clear,
+                            vector<tuple<DurationSize, int, IntensitySize>>* evaluated)
+{
+  evaluated->emplace_back(event.time(), event.type(), event.intensity());
+  if (Event::END_SIMULATION == event.type())
+  {
+    clear();
+    return;
+  }
+  if (Event::FIRE_SPREAD == event.type())
+  {
+    std::uniform_int_distribution<int> minutes{1, 60};
+    const auto t = event.time() + minutes(*generator) / DAY_MINUTES;
+    const auto intensity = static_cast<IntensitySize>(evaluated->size());
+    // equivalent to Event being evaluated, so should be ignored
+    add(Event::makeFireSpread(event.time(), intensity, 0, wx::Direction()));
+    add(Event::makeFireSpread(t, intensity, 0, wx::Direction()));
+    // equivalent to Event that was just added, so should be ignored
+    add(Event::makeFireSpread(t, intensity + 1, 0, wx::Direction()));
+  }
+}
+/**
+ * \brief Check that EventScheduler evaluates Events in the same order as the set it replaced,
+ * and show how long each takes
+ */
+static void test_event_scheduler()
+{
+  constexpr size_t NUM_RESETS = 2000;
+  constexpr DurationSize NUM_DAYS = 3;
+  const auto reset = [](auto add) {
+    for (DurationSize day = 1; day <= NUM_DAYS; ++day)
+    {
+      add(Event::makeSave(day));
+    }
+    add(Event::makeEnd(NUM_DAYS));
+    add(Event::makeFireSpread(0));
+  };
+  vector<tuple<DurationSize, int, IntensitySize>> expected{};
+  std::mt19937 generator_set{42};
+  std::set<Event, EventCompare> set{};
+  const auto add_set = [&set](Event&& e) { set.insert(std::move(e)); };
+  const auto start_set = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < NUM_RESETS; ++i)
+  {
+    set.clear();
+    reset(add_set);
+    while (!set.empty())
+    {
+      // same as Scenario did when it used a set
+      const auto& event = *set.begin();
+      evaluate_queued(event, &generator_set, add_set, [&set]() { set.clear(); }, &expected);
+      if (!set.empty())
+      {
+        set.erase(event);
+      }
+    }
+  }
+  const auto time_set = std::chrono::steady_clock::now() - start_set;
+  vector<tuple<DurationSize, int, IntensitySize>> evaluated{};
+  std::mt19937 generator{42};
+  EventScheduler scheduler{};
+  const auto add = [&scheduler](Event&& e) { scheduler.insert(std::move(e)); };
+  const auto start = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < NUM_RESETS; ++i)
+  {
+    scheduler.clear();
+    reset(add);
+    while (!scheduler.empty())
+    {
+      evaluate_queued(scheduler.next(), &generator, add, [&scheduler]() { scheduler.clear(); }, &evaluated);
+    }
+  }
+  const auto time_scheduler = std::chrono::steady_clock::now() - start;
+  logging::check_fatal(expected != evaluated,
+                       "EventScheduler evaluated %ld events but set evaluated %ld or they were different",
+                       evaluated.size(),
+                       expected.size());
+  const auto ns_per_event = [&evaluated](const auto duration) {
+    return static_cast<MathSize>(std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count())
+         / static_cast<MathSize>(evaluated.size());
+  };
+  logging::note("EventScheduler matches set and took %0.1f ns per event vs %0.1f ns for set",
+                ns_per_event(time_scheduler),
+                ns_per_event(time_set));
+}
+/**
+ * \brief Check that converting weather to binary doesn't change any values
+ * \param output_directory Directory to write weather files to
+ */
+static void test_weather_binary(const string& output_directory)
+{
+  util::make_directory_recursive(output_directory.c_str());
+  const auto csv_file = output_directory + "/weather.csv";
+  const auto binary_file = output_directory + "/weather.bin";
+  {
+    ofstream out(csv_file);
+    out << "Scenario,Date,PREC,TEMP,RH,WS,WD,FFMC,DMC,DC,ISI,BUI,FWI\n";
+    // use values that need every digit so any loss of precision shows up
+    out << setprecision(17);
+    std::mt19937 generator{42};
+    std::uniform_real_distribution<MathSize> fraction{0, 1};
+    static constexpr array<MathSize, 11> MAX_VALUES{5, 35, 100, 40, 360, 99, 100, 600, 30, 150, 60};
+    for (size_t scenario = 0; scenario < 3; ++scenario)
+    {
+      for (auto hour = 0; hour < 30; ++hour)
+      {
+        out << scenario << ",2024-06-0" << (1 + hour / DAY_HOURS) << " " << (hour % DAY_HOURS) << ":00:00";
+        for (const auto v : MAX_VALUES)
+        {
+          out << "," << v * fraction(generator);
+        }
+        out << "\n";
+      }
+    }
+  }
+  const auto expected = wx::read_weather_csv(csv_file);
+  wx::write_weather_binary(binary_file, expected);
+  logging::check_fatal(!wx::is_weather_binary(binary_file), "Converted weather isn't binary");
+  const auto actual = wx::read_weather(binary_file);
+  logging::check_equal(actual.size(), expected.size(), "number of scenarios");
+  const auto values = [](const wx::FwiWeather& w) {
+    return array<MathSize, 11>{w.prec().asValue(),
+                               w.temp().asValue(),
+                               w.rh().asValue(),
+                               w.wind().speed().asValue(),
+                               w.wind().direction().asValue(),
+                               w.ffmc().asValue(),
+                               w.dmc().asValue(),
+                               w.dc().asValue(),
+                               w.isi().asValue(),
+                               w.bui().asValue(),
+                               w.fwi().asValue()};
+  };
+  for (size_t s = 0; s < expected.size(); ++s)
+  {
+    const auto& x = expected[s];
+    const auto& y = actual[s];
+    logging::check_equal(y.id, x.id, "scenario");
+    logging::check_equal(y.hours.size(), x.hours.size(), "number of hours");
+    for (size_t h = 0; h < x.hours.size(); ++h)
+    {
+      logging::check_equal(y.times[h].day, x.times[h].day, "day");
+      logging::check_equal(y.times[h].hour, x.times[h].hour, "hour");
+      // needs to be exactly the same so the simulation is too
+      logging::check_fatal(values(y.hours[h]) != values(x.hours[h]),
+                           "Binary weather for scenario %ld hour %ld is different from .csv",
+                           x.id,
+                           h);
+    }
+  }
+  logging::note("Binary weather matches .csv");
+}
+/**
+ * \brief Check that a preprocessed environment has the same cells as reading the rasters,
+ * and that rasters are read instead if the preprocessed file can't be used
+ * \param output_directory Folder to write test rasters to
+ */
+static void test_environment_cache(const string& output_directory)
+{
+  util::make_directory_recursive(output_directory.c_str());
+  const auto dir = output_directory + "/";
+  constexpr Idx SIZE = 512;
+  constexpr FuelSize FUEL_NODATA = 0;
+  constexpr ElevationSize ELEVATION_NODATA = -9999;
+  // centered on the central meridian so the whole raster is in the projection
+  const auto xll = 500000.0 - TEST_GRID_SIZE * SIZE / 2;
+  const auto yll = 5400000.0 - TEST_GRID_SIZE * SIZE / 2;
+  const auto xur = xll + TEST_GRID_SIZE * SIZE;
+  const auto yur = yll + TEST_GRID_SIZE * SIZE;
+  data::GridMap<FuelSize> fuel(TEST_GRID_SIZE, SIZE, SIZE, FUEL_NODATA, FUEL_NODATA, xll, yll, xur, yur, TEST_PROJ4);
+  data::GridMap<ElevationSize> elevation(TEST_GRID_SIZE, SIZE, SIZE, ELEVATION_NODATA, ELEVATION_NODATA, xll, yll, xur, yur, TEST_PROJ4);
+  const auto& lookup = Settings::fuelLookup();
+  vector<FuelSize> codes{};
+  for (const auto& name : FUEL_NAMES)
+  {
+    codes.emplace_back(lookup.fuelToCode(lookup.bySimplifiedName(simplify_fuel_name(name))));
+  }
+  std::mt19937 generator{42};
+  std::uniform_int_distribution<size_t> pick{0, codes.size()};
+  for (Idx r = 0; r < SIZE; ++r)
+  {
+    for (Idx c = 0; c < SIZE; ++c)
+    {
+      const Location location(r, c);
+      // leave some fuel and elevation missing, but keep corners so the whole extent is written
+      const auto i = pick(generator);
+      const auto is_corner = (0 == r || SIZE - 1 == r) && (0 == c || SIZE - 1 == c);
+      if (is_corner || codes.size() != i)
+      {
+        fuel.set(location, codes[i % codes.size()]);
+      }
+      if (is_corner || 0 != (r * 7 + c * 13) % 97)
+      {
+        // hills in different directions so slope and aspect vary
+        elevation.set(location, static_cast<ElevationSize>(300 + (r * 37 + c * 11) % 200 + (r / 50) * (c / 40)));
+      }
+    }
+  }
+  const auto in_fuel = fuel.saveToFile(dir, "fuel");
+  const auto in_elevation = elevation.saveToFile(dir, "dem");
+  const auto point = topo::to_lat_long(TEST_PROJ4, (xll + xur) / 2, (yll + yur) / 2);
+  const auto cache_file = topo::EnvironmentCache::fileName(in_fuel);
+  std::remove(cache_file.c_str());
+  const auto expected = topo::Environment::load(dir, point, in_fuel, in_elevation);
+  const auto check_same = [&](const topo::Environment& actual, const char* name) {
+    logging::check_equal(actual.rows(), expected.rows(), "rows");
+    logging::check_equal(actual.columns(), expected.columns(), "columns");
+    logging::check_equal(actual.elevation(), expected.elevation(), "elevation");
+    for (Idx r = 0; r < expected.rows(); ++r)
+    {
+      for (Idx c = 0; c < expected.columns(); ++c)
+      {
+        const Location location(r, c);
+        logging::check_fatal(actual.cell(location).fullHash() != expected.cell(location).fullHash(),
+                             "%s has different cell than rasters at (%d, %d)",
+                             name,
+                             r,
+                             c);
+      }
+    }
+  };
+  topo::EnvironmentCache::create(in_fuel, in_elevation);
+  logging::check_fatal(nullptr == topo::EnvironmentCache::open(in_fuel, in_elevation),
+                       "Can't open %s",
+                       cache_file.c_str());
+  check_same(topo::Environment::load(dir, point, in_fuel, in_elevation), "Preprocessed environment");
+  // damaged file should be ignored instead of stopping the run
+  {
+    ofstream out(cache_file, std::ios::binary | std::ios::trunc);
+    out << "FSCELLS";
+  }
+  logging::check_fatal(nullptr != topo::EnvironmentCache::open(in_fuel, in_elevation),
+                       "Truncated %s was used",
+                       cache_file.c_str());
+  check_same(topo::Environment::load(dir, point, in_fuel, in_elevation), "Environment with truncated file");
+  std::remove(cache_file.c_str());
+  logging::note("Preprocessed environment matches rasters");
+}
+/**
+ * \brief Check that test runs burn the same cells at the same times as before spread used util::trig
+ * \param output_directory Folder to write test outputs to
+ */
+static void test_regression(const string& output_directory)
+{
+  struct RegressionCase
+  {
+    const char* fuel;
+    SlopeSize slope;
+    AspectSize aspect;
+    DirectionSize wind_direction;
+    int wind_speed;
+    TestResult expected;
+  };
+  // recorded with default indices and duration before util::trig replaced _sin() and _cos()
+  static const vector<RegressionCase> CASES{
+    {"C-2", 0, 0, 180, 20, {3059, 508637.62841908092}},
+    {"O-1a", 60, 90, 45, 30, {178, 29593.929385764076}},
+    {"M-1/M-2 (25 PC)", 30, 180, 270, 10, {399, 66341.991030566961}},
+    {"S-1", 0, 0, 135, 25, {4939, 821234.07382266998}},
+    {"C-3", 60, 270, 315, 15, {1599, 265871.56313053792}},
+    {"C-2", 0, 0, 0, 0, {1881, 312767.5984283622}}};
+  // trig functions differ from the library ones in the last bit, so allow for that in arrival times
+  constexpr MathSize ARRIVAL_EPSILON = 1e-9;
+  for (const auto& c : CASES)
+  {
+    const wx::Wind wind(wx::Direction(c.wind_direction, false), wx::Speed(c.wind_speed));
+    TestResult result{};
+    run_test(output_directory + "/regression",
+             c.fuel,
+             c.slope,
+             c.aspect,
+             DEFAULT_HOURS,
+             DEFAULT_DC,
+             DEFAULT_DMC,
+             DEFAULT_FFMC,
+             wind,
+             false,
+             &result);
+    logging::check_fatal(c.expected.cells != result.cells
+                           || std::abs(result.arrival_sum - c.expected.arrival_sum)
+                                > ARRIVAL_EPSILON * c.expected.arrival_sum,
+                         "%s with slope %d, aspect %d and wind %d at %d burned %ld cells with arrival sum %.17g but expected %ld and %.17g",
+                         c.fuel,
+                         c.slope,
+                         c.aspect,
+                         c.wind_direction,
+                         c.wind_speed,
+                         result.cells,
+                         result.arrival_sum,
+                         c.expected.cells,
+                         c.expected.arrival_sum);
+  }
+  logging::note("Test outputs match outputs from before util::trig");
+}
+/**
+ * \brief Check that a fire that reaches the edge of a small window is counted the same way
+ * whether it spreads in serial or in parallel, since that count is what warns that
+ * --max-daily-spread is too low
+ * \param output_directory Folder to write test outputs to
+ */
+static void test_window_edge(const string& output_directory)
+{
+  // smallest window that find_window() would give, which a long run with wind gets out of
+  constexpr Idx SIZE = TILE_WIDTH;
+  constexpr DurationSize HOURS = 48.0;
+  const wx::Wind wind(wx::Direction(225, false), wx::Speed(30));
+  static const topo::StartPoint ForPoint(49.3911, -84.7395);
+  const auto t = util::to_tm(2020, 6, 15, 12, 0);
+  const auto start_date = t.tm_yday;
+  const auto end_date = start_date + HOURS / DAY_HOURS;
+  const auto fuel = Settings::fuelLookup().bySimplifiedName(DEFAULT_FUEL_NAME);
+  const auto was_parallel = Settings::parallelSpread();
+  size_t counts[2]{0, 0};
+  for (const auto is_parallel : {false, true})
+  {
+    Settings::setParallelSpread(is_parallel);
+    const auto dir_out = output_directory + (is_parallel ? "/parallel/" : "/serial/");
+    util::make_directory_recursive(dir_out.c_str());
+    // rows are still MAX_COLUMNS wide so hashes are the same as for a full window
+    auto values = vector<topo::Cell>();
+    for (Idx r = 0; r < SIZE; ++r)
+    {
+      for (Idx c = 0; c < MAX_COLUMNS; ++c)
+      {
+        values.emplace_back(r, c, static_cast<SlopeSize>(0), static_cast<AspectSize>(0), fuel::FuelType::safeCode(fuel));
+      }
+    }
+    const topo::Cell cell_nodata{};
+    const auto cells = new topo::CellGrid{
+      TEST_GRID_SIZE,
+      SIZE,
+      SIZE,
+      cell_nodata.fullHash(),
+      cell_nodata,
+      TEST_XLLCORNER,
+      TEST_YLLCORNER,
+      TEST_XLLCORNER + TEST_GRID_SIZE * SIZE,
+      TEST_YLLCORNER + TEST_GRID_SIZE * SIZE,
+      TEST_PROJ4,
+      std::move(values)};
+    TestEnvironment env(dir_out, cells);
+    Model model(dir_out, ForPoint, &env);
+    const auto start_cell = make_shared<topo::Cell>(model.cell(Location(SIZE / 2, SIZE / 2)));
+    ConstantWeather weather(fuel, start_date, DEFAULT_DC, DEFAULT_DMC, DEFAULT_FFMC, wind);
+    TestScenario scenario(&model, start_cell, ForPoint, start_date, end_date, &weather);
+    map<DurationSize, ProbabilityMap*> probabilities{};
+    scenario.run(&probabilities);
+    counts[is_parallel ? 1 : 0] = scenario.oobSpread();
+  }
+  Settings::setParallelSpread(was_parallel);
+  logging::check_fatal(0 == counts[0],
+                       "Fire in %dx%d window never reached the edge",
+                       SIZE,
+                       SIZE);
+  logging::check_fatal(counts[0] != counts[1],
+                       "Spread reached window edge %ld times in serial but %ld times in parallel",
+                       counts[0],
+                       counts[1]);
+  logging::note("Spread reaching window edge is counted the same in serial and parallel");
+}
+/**
+ * \brief Check that spreading with multiple threads burns exactly the same cells at the same times
+ * \param output_directory Folder to write test outputs to
+ */
+static void test_parallel_spread(const string& output_directory)
+{
+  // different fuels, slopes and winds so cells have several SpreadKeys to apply in parallel
+  static const vector<tuple<const char*, SlopeSize, AspectSize, DirectionSize, int>> CASES{
+    {"C-2", 0, 0, 180, 20},
+    {"M-1/M-2 (25 PC)", 30, 180, 270, 10},
+    {"C-3", 60, 270, 315, 15}};
+  const auto was_parallel = Settings::parallelSpread();
+  for (const auto& [fuel, slope, aspect, wind_direction, wind_speed] : CASES)
+  {
+    const wx::Wind wind(wx::Direction(wind_direction, false), wx::Speed(wind_speed));
+    map<Location, DurationSize> serial{};
+    map<Location, DurationSize> parallel{};
+    for (const auto is_parallel : {false, true})
+    {
+      Settings::setParallelSpread(is_parallel);
+      run_test(output_directory + (is_parallel ? "/parallel" : "/serial"),
+               fuel,
+               slope,
+               aspect,
+               DEFAULT_HOURS,
+               DEFAULT_DC,
+               DEFAULT_DMC,
+               DEFAULT_FFMC,
+               wind,
+               false,
+               nullptr,
+               is_parallel ? &parallel : &serial);
+    }
+    logging::check_fatal(serial.size() != parallel.size(),
+                         "%s burned %ld cells in parallel but %ld in serial",
+                         fuel,
+                         parallel.size(),
+                         serial.size());
+    for (const auto& [location, time] : serial)
+    {
+      const auto seek = parallel.find(location);
+      // needs to be exactly the same, not just close
+      logging::check_fatal(parallel.end() == seek || 0 != memcmp(&seek->second, &time, sizeof(time)),
+                           "%s arrival at (%d, %d) is different in parallel",
+                           fuel,
+                           location.row(),
+                           location.column());
+    }
+  }
+  Settings::setParallelSpread(was_parallel);
+  logging::note("Parallel spread matches serial spread");
+}
 int test(
   const string& output_directory,
   const DurationSize num_hours,
@@ -375,6 +1224,11 @@ int test(
   const auto fuel = (fixed_fuel_name.empty() ? DEFAULT_FUEL_NAME : fixed_fuel_name);
   try
   {
+    test_tile_compression(output_directory);
+    test_cell_points();
+    test_tile_levels();
+    test_trig();
+    test_event_scheduler();
     if (test_all)
     {
       size_t result = 0;
@@ -533,6 +1387,12 @@ int test(
                            "Directory for test is missing: %s\n",
                            dir_out.c_str());
     }
+    // after test_all so it doesn't count these folders
+    test_regression(output_directory);
+    test_parallel_spread(output_directory + "/spread");
+    test_window_edge(output_directory + "/edge");
+    test_weather_binary(output_directory + "/weather");
+    test_environment_cache(output_directory + "/environment");
   }
   catch (const runtime_error& err)
   {
@@ -0,0 +1,425 @@
+/* Copyright (c) His Majesty the King in Right of Canada as represented by the Minister of Natural Resources, 2024. */
+
+/* SPDX-License-Identifier: AGPL-3.0-or-later */
+
+#include "stdafx.h"
+#include "TileCompression.h"
+#include <bit>
+#include <thread>
+#include <zlib.h>
+#ifdef TBD_ZSTD
+#include <zstd.h>
+#endif
+#include "Log.h"
+#include "WorkerPool.h"
+#ifndef COMPRESSION_ZSTD
+#define COMPRESSION_ZSTD 50000
+#endif
+namespace tbd::data
+{
+/**
+ * \brief Code that tells LZW decoder to reset its table
+ */
+static constexpr uint32_t LZW_CLEAR = 256;
+/**
+ * \brief Code that marks the end of LZW data
+ */
+static constexpr uint32_t LZW_EOI = 257;
+/**
+ * \brief First code that is available for LZW table entries
+ */
+static constexpr uint32_t LZW_FIRST = 258;
+/**
+ * \brief Number of bits in LZW codes after a reset
+ */
+static constexpr int LZW_BITS_MIN = 9;
+/**
+ * \brief Largest possible LZW code
+ */
+static constexpr uint32_t LZW_CODE_MAX = (1 << 12) - 1;
+/**
+ * \brief Number of bits used for LZW hash table, which needs to fit all codes at under half full
+ */
+static constexpr int LZW_HASH_BITS = 13;
+/**
+ * \brief Compression level libtiff uses for deflate by default
+ */
+static constexpr int DEFLATE_LEVEL = 6;
+/**
+ * \brief Most threads to use for compressing tiles, so saving doesn't starve simulations
+ */
+static constexpr size_t MAX_TILE_WORKERS = 4;
+#ifdef TBD_ZSTD
+/**
+ * \brief Compression level libtiff uses for zstd by default
+ */
+static constexpr int ZSTD_LEVEL = 9;
+#endif
+/**
+ * \brief Writes codes with most significant bit first, like TIFF LZW expects
+ */
+class CodeWriter
+{
+public:
+  explicit CodeWriter(vector<uint8_t>* out)
+    : out_(out)
+  {
+  }
+  /**
+   * \brief Write code using the given number of bits
+   * \param code Code to write
+   * \param bits Number of bits to use
+   */
+  void put(const uint32_t code, const int bits)
+  {
+    buffer_ = (buffer_ << bits) | code;
+    bits_ += bits;
+    while (bits_ >= 8)
+    {
+      bits_ -= 8;
+      out_->push_back(static_cast<uint8_t>(buffer_ >> bits_));
+    }
+  }
+  /**
+   * \brief Write any remaining bits, padded with zeros
+   */
+  void flush()
+  {
+    if (bits_ > 0)
+    {
+      out_->push_back(static_cast<uint8_t>(buffer_ << (8 - bits_)));
+      bits_ = 0;
+    }
+  }
+private:
+  /**
+   * \brief Output to write to
+   */
+  vector<uint8_t>* out_;
+  /**
+   * \brief Bits that haven't been written yet are in the lowest bits_ bits
+   */
+  uint32_t buffer_{0};
+  /**
+   * \brief Number of bits that haven't been written yet
+   */
+  int bits_{0};
+};
+/**
+ * \brief Compress with LZW using the same code width changes as libtiff
+ * \param in Data to compress
+ * \return Compressed data
+ */
+static vector<uint8_t> lzw_encode(const vector<uint8_t>& in)
+{
+  vector<uint8_t> out{};
+  out.reserve(in.size() / 2 + 16);
+  CodeWriter writer(&out);
+  // (prefix code << 8 | next byte) => code, using open addressing
+  constexpr size_t hash_size = static_cast<size_t>(1) << LZW_HASH_BITS;
+  vector<int32_t> keys(hash_size, -1);
+  vector<uint16_t> codes(hash_size);
+  auto nbits = LZW_BITS_MIN;
+  auto max_code = (static_cast<uint32_t>(1) << nbits) - 1;
+  auto free_code = LZW_FIRST;
+  writer.put(LZW_CLEAR, nbits);
+  if (in.empty())
+  {
+    writer.put(LZW_EOI, nbits);
+    writer.flush();
+    return out;
+  }
+  // decoder lags one entry behind, so width changes one code later than table size implies
+  const auto next_entry = [&]() {
+    ++free_code;
+    if (LZW_CODE_MAX - 1 == free_code)
+    {
+      writer.put(LZW_CLEAR, nbits);
+      std::fill(keys.begin(), keys.end(), -1);
+      nbits = LZW_BITS_MIN;
+      max_code = (static_cast<uint32_t>(1) << nbits) - 1;
+      free_code = LZW_FIRST;
+    }
+    else if (free_code > max_code)
+    {
+      ++nbits;
+      max_code = (static_cast<uint32_t>(1) << nbits) - 1;
+    }
+  };
+  uint32_t prefix = in[0];
+  for (size_t i = 1; i < in.size(); ++i)
+  {
+    const auto c = in[i];
+    const auto key = static_cast<int32_t>((prefix << 8) | c);
+    auto h = (static_cast<uint32_t>(key) * 2654435761u) >> (32 - LZW_HASH_BITS);
+    while (-1 != keys[h] && key != keys[h])
+    {
+      h = (h + 1) & (hash_size - 1);
+    }
+    if (key == keys[h])
+    {
+      prefix = codes[h];
+      continue;
+    }
+    writer.put(prefix, nbits);
+    keys[h] = key;
+    codes[h] = static_cast<uint16_t>(free_code);
+    prefix = c;
+    next_entry();
+  }
+  writer.put(prefix, nbits);
+  // libtiff accounts for the entry the decoder will add for the last code before writing EOI
+  ++free_code;
+  if (LZW_CODE_MAX - 1 == free_code)
+  {
+    writer.put(LZW_CLEAR, nbits);
+    nbits = LZW_BITS_MIN;
+  }
+  else if (free_code > max_code)
+  {
+    ++nbits;
+  }
+  writer.put(LZW_EOI, nbits);
+  writer.flush();
+  return out;
+}
+/**
+ * \brief Compress with zlib, which is what TIFF deflate compression uses
+ * \param in Data to compress
+ * \return Compressed data
+ */
+static vector<uint8_t> deflate_encode(const vector<uint8_t>& in)
+{
+  auto size = compressBound(static_cast<uLong>(in.size()));
+  vector<uint8_t> out(size);
+  const auto result = compress2(out.data(), &size, in.data(), static_cast<uLong>(in.size()), DEFLATE_LEVEL);
+  logging::check_fatal(Z_OK != result, "Deflate compression failed with error %d", result);
+  out.resize(size);
+  return out;
+}
+#ifdef TBD_ZSTD
+/**
+ * \brief Compress with zstd
+ * \param in Data to compress
+ * \return Compressed data
+ */
+static vector<uint8_t> zstd_encode(const vector<uint8_t>& in)
+{
+  vector<uint8_t> out(ZSTD_compressBound(in.size()));
+  const auto size = ZSTD_compress(out.data(), out.size(), in.data(), in.size(), ZSTD_LEVEL);
+  logging::check_fatal(ZSTD_isError(size), "Zstd compression failed: %s", ZSTD_getErrorName(size));
+  out.resize(size);
+  return out;
+}
+#endif
+/**
+ * \brief Replace each sample in rows with difference from previous sample
+ * \tparam S Unsigned type with same size as samples
+ * \param tile Tile to apply predictor to
+ * \param width Number of samples in each row
+ */
+template <class S>
+static void horizontal_difference(vector<uint8_t>& tile, const size_t width)
+{
+  const auto row_size = width * sizeof(S);
+  for (size_t row = 0; row + row_size <= tile.size(); row += row_size)
+  {
+    auto p = &tile[row];
+    // go backwards so previous value hasn't been changed yet
+    for (auto i = width - 1; i > 0; --i)
+    {
+      S cur;
+      S prev;
+      memcpy(&cur, p + i * sizeof(S), sizeof(S));
+      memcpy(&prev, p + (i - 1) * sizeof(S), sizeof(S));
+      cur = static_cast<S>(cur - prev);
+      memcpy(p + i * sizeof(S), &cur, sizeof(S));
+    }
+  }
+}
+/**
+ * \brief Split each row into planes by byte significance and then difference the bytes
+ * \param tile Tile to apply predictor to
+ * \param sample_size Number of bytes in each sample
+ * \param width Number of samples in each row
+ */
+static void floating_point_difference(vector<uint8_t>& tile,
+                                      const size_t sample_size,
+                                      const size_t width)
+{
+  const auto row_size = width * sample_size;
+  vector<uint8_t> row_copy(row_size);
+  for (size_t row = 0; row + row_size <= tile.size(); row += row_size)
+  {
+    auto p = &tile[row];
+    memcpy(row_copy.data(), p, row_size);
+    // planes go from most to least significant byte
+    for (size_t i = 0; i < width; ++i)
+    {
+      for (size_t b = 0; b < sample_size; ++b)
+      {
+        const auto plane = std::endian::native == std::endian::big ? b : sample_size - b - 1;
+        p[plane * width + i] = row_copy[i * sample_size + b];
+      }
+    }
+    for (auto i = row_size - 1; i > 0; --i)
+    {
+      p[i] = static_cast<uint8_t>(p[i] - p[i - 1]);
+    }
+  }
+}
+uint16_t parse_tiff_compression(const string& name)
+{
+  auto lower = name;
+  std::transform(lower.begin(), lower.end(), lower.begin(), ::tolower);
+  if ("lzw" == lower)
+  {
+    return COMPRESSION_LZW;
+  }
+  if ("deflate" == lower)
+  {
+    return COMPRESSION_ADOBE_DEFLATE;
+  }
+  if ("zstd" == lower)
+  {
+#ifdef TBD_ZSTD
+    return COMPRESSION_ZSTD;
+#else
+    throw runtime_error("Not compiled with zstd support");
+#endif
+  }
+  throw runtime_error("Unknown compression " + name);
+}
+uint16_t parse_tiff_predictor(const string& name)
+{
+  auto lower = name;
+  std::transform(lower.begin(), lower.end(), lower.begin(), ::tolower);
+  if ("none" == lower)
+  {
+    return PREDICTOR_NONE;
+  }
+  if ("horizontal" == lower)
+  {
+    return PREDICTOR_HORIZONTAL;
+  }
+  if ("floatingpoint" == lower)
+  {
+    return PREDICTOR_FLOATINGPOINT;
+  }
+  throw runtime_error("Unknown predictor " + name);
+}
+vector<uint8_t> compress_tile(const uint16_t compression,
+                              const uint16_t predictor,
+                              const size_t sample_size,
+                              const size_t width,
+                              vector<uint8_t>& tile)
+{
+  if (PREDICTOR_HORIZONTAL == predictor)
+  {
+    switch (sample_size)
+    {
+      case 1:
+        horizontal_difference<uint8_t>(tile, width);
+        break;
+      case 2:
+        horizontal_difference<uint16_t>(tile, width);
+        break;
+      case 4:
+        horizontal_difference<uint32_t>(tile, width);
+        break;
+      case 8:
+        horizontal_difference<uint64_t>(tile, width);
+        break;
+      default:
+        logging::fatal("Unsupported sample size %ld for horizontal predictor", sample_size);
+    }
+  }
+  else if (PREDICTOR_FLOATINGPOINT == predictor)
+  {
+    floating_point_difference(tile, sample_size, width);
+  }
+  switch (compression)
+  {
+    case COMPRESSION_LZW:
+      return lzw_encode(tile);
+    case COMPRESSION_ADOBE_DEFLATE:
+      return deflate_encode(tile);
+#ifdef TBD_ZSTD
+    case COMPRESSION_ZSTD:
+      return zstd_encode(tile);
+#endif
+    default:
+      return logging::fatal<vector<uint8_t>>("Unsupported compression %d", compression);
+  }
+}
+vector<vector<uint8_t>> compress_tiles(const uint16_t compression,
+                                       const uint16_t predictor,
+                                       const size_t sample_size,
+                                       const size_t width,
+                                       const vector<vector<uint8_t>>& tiles)
+{
+  vector<vector<uint8_t>> result(tiles.size());
+  for_each_tile(
+    tiles.size(),
+    [&](const size_t i) {
+      if (!tiles[i].empty())
+      {
+        // predictor changes tile so use a copy
+        auto tile = tiles[i];
+        result[i] = compress_tile(compression, predictor, sample_size, width, tile);
+      }
+    });
+  return result;
+}
+/**
+ * \brief Pool shared by everything that saves tiles, so only MAX_TILE_WORKERS threads compress at once
+ * \return Pool to compress tiles with
+ */
+static util::WorkerPool& tile_pool()
+{
+  static util::WorkerPool pool{
+    max(static_cast<size_t>(1),
+        min(MAX_TILE_WORKERS, static_cast<size_t>(std::thread::hardware_concurrency())))};
+  return pool;
+}
+void for_each_tile(const size_t count, const std::function<void(size_t)>& fct)
+{
+  if (count <= 1)
+  {
+    for (size_t i = 0; i < count; ++i)
+    {
+      fct(i);
+    }
+    return;
+  }
+  std::atomic<bool> is_failed{false};
+  std::exception_ptr error = nullptr;
+  std::mutex mutex_error{};
+  tile_pool().for_each(
+    count,
+    [&](const size_t i) {
+      // stop starting more tiles once one has failed
+      if (is_failed)
+      {
+        return;
+      }
+      try
+      {
+        fct(i);
+      }
+      catch (...)
+      {
+        lock_guard<mutex> lock(mutex_error);
+        if (nullptr == error)
+        {
+          error = std::current_exception();
+        }
+        is_failed = true;
+      }
+    });
+  if (nullptr != error)
+  {
+    std::rethrow_exception(error);
+  }
+}
+}
@@ -0,0 +1,227 @@
+/* Copyright (c) His Majesty the King in Right of Canada as represented by the Minister of Natural Resources, 2024. */
+
+/* SPDX-License-Identifier: AGPL-3.0-or-later */
+
+#pragma once
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <string>
+#include <type_traits>
+#include <vector>
+namespace tbd::data
+{
+/**
+ * \brief Tiles for one resolution of an image, where tiles that only have nodata are empty
+ */
+struct TileLevel
+{
+  /**
+   * \brief Width of image (pixels)
+   */
+  size_t width;
+  /**
+   * \brief Height of image (pixels)
+   */
+  size_t height;
+  /**
+   * \brief Number of tiles in each row of tiles
+   */
+  size_t tiles_across;
+  /**
+   * \brief Number of rows of tiles
+   */
+  size_t tiles_down;
+  /**
+   * \brief Tiles in row major order starting at top left
+   */
+  std::vector<std::vector<uint8_t>> tiles;
+};
+/**
+ * \brief How to combine each 2x2 block of pixels when making an overview
+ */
+enum class OverviewReduction
+{
+  /**
+   * \brief Average of values, for continuous values like probability and intensity
+   */
+  Average,
+  /**
+   * \brief Most common value, for categories and directions where an average isn't a valid value
+   */
+  Mode,
+};
+/**
+ * \brief Number of tiles needed to cover a number of pixels, including a partial tile at the edge
+ * \param pixels Number of pixels
+ * \param tile_size Number of pixels in each tile
+ * \return Number of tiles needed to cover pixels
+ */
+[[nodiscard]] constexpr size_t tiles_for(const size_t pixels, const size_t tile_size) noexcept
+{
+  return (pixels + tile_size - 1) / tile_size;
+}
+/**
+ * \brief Determine TIFF compression tag value from name
+ * \param name Name of compression ("lzw", "deflate", or "zstd")
+ * \return TIFF compression tag value
+ */
+[[nodiscard]] uint16_t parse_tiff_compression(const std::string& name);
+/**
+ * \brief Determine TIFF predictor tag value from name
+ * \param name Name of predictor ("none", "horizontal", or "floatingpoint")
+ * \return TIFF predictor tag value
+ */
+[[nodiscard]] uint16_t parse_tiff_predictor(const std::string& name);
+/**
+ * \brief Apply TIFF predictor to tile and compress it the same way libtiff would
+ * \param compression TIFF compression tag value
+ * \param predictor TIFF predictor tag value
+ * \param sample_size Number of bytes in each sample
+ * \param width Number of samples in each row of tile
+ * \param tile Uncompressed tile, which is modified by applying the predictor
+ * \return Compressed tile
+ */
+[[nodiscard]] std::vector<uint8_t> compress_tile(uint16_t compression,
+                                                 uint16_t predictor,
+                                                 size_t sample_size,
+                                                 size_t width,
+                                                 std::vector<uint8_t>& tile);
+/**
+ * \brief Call function for every tile index, using multiple threads if there are enough tiles
+ * \param count Number of tiles
+ * \param fct Function to call with each tile index
+ */
+void for_each_tile(size_t count, const std::function<void(size_t)>& fct);
+/**
+ * \brief Compress copies of tiles in parallel
+ * \param compression TIFF compression tag value
+ * \param predictor TIFF predictor tag value
+ * \param sample_size Number of bytes in each sample
+ * \param width Number of samples in each row of tile
+ * \param tiles Uncompressed tiles, which are left empty if they only have nodata
+ * \return Compressed tiles, which are empty where the uncompressed tile is
+ */
+[[nodiscard]] std::vector<std::vector<uint8_t>> compress_tiles(uint16_t compression,
+                                                               uint16_t predictor,
+                                                               size_t sample_size,
+                                                               size_t width,
+                                                               const std::vector<std::vector<uint8_t>>& tiles);
+/**
+ * \brief Make image with half the resolution by combining each 2x2 block of pixels that aren't nodata
+ * \tparam R Type of pixel values
+ * \param level Image to reduce
+ * \param tile_width Width of tiles (pixels)
+ * \param tile_height Height of tiles (pixels)
+ * \param no_data Value that represents no data
+ * \param reduction How to combine each 2x2 block of pixels
+ * \return Image with half the resolution
+ */
+template <class R>
+[[nodiscard]] TileLevel reduce_level(const TileLevel& level,
+                                     const size_t tile_width,
+                                     const size_t tile_height,
+                                     const R no_data,
+                                     const OverviewReduction reduction)
+{
+  const auto width = (level.width + 1) / 2;
+  const auto height = (level.height + 1) / 2;
+  // count from size since readers expect a tile for every partial tile at the edge
+  TileLevel result{width,
+                   height,
+                   tiles_for(width, tile_width),
+                   tiles_for(height, tile_height),
+                   {}};
+  result.tiles.resize(result.tiles_across * result.tiles_down);
+  for_each_tile(
+    result.tiles.size(),
+    [&](const size_t i) {
+      // each tile covers a 2x2 block of tiles from the level above it
+      const std::vector<uint8_t>* from[4]{};
+      auto has_data = false;
+      for (size_t j = 0; j < 4; ++j)
+      {
+        const auto x = 2 * (i % result.tiles_across) + j % 2;
+        const auto y = 2 * (i / result.tiles_across) + j / 2;
+        if (x < level.tiles_across && y < level.tiles_down)
+        {
+          const auto& tile = level.tiles[y * level.tiles_across + x];
+          if (!tile.empty())
+          {
+            from[j] = &tile;
+            has_data = true;
+          }
+        }
+      }
+      if (!has_data)
+      {
+        return;
+      }
+      auto& tile = result.tiles[i];
+      tile.resize(tile_width * tile_height * sizeof(R));
+      for (size_t y = 0; y < tile_height; ++y)
+      {
+        for (size_t x = 0; x < tile_width; ++x)
+        {
+          R values[4]{};
+          size_t count = 0;
+          for (size_t j = 0; j < 4; ++j)
+          {
+            // position in the 2x2 block of tiles
+            const auto bx = 2 * x + j % 2;
+            const auto by = 2 * y + j / 2;
+            const auto source = from[(by / tile_height) * 2 + bx / tile_width];
+            if (nullptr != source)
+            {
+              R value;
+              memcpy(&value,
+                     &(*source)[((by % tile_height) * tile_width + bx % tile_width) * sizeof(R)],
+                     sizeof(R));
+              if (no_data != value)
+              {
+                values[count++] = value;
+              }
+            }
+          }
+          R value = no_data;
+          if (0 < count)
+          {
+            if (OverviewReduction::Average == reduction)
+            {
+              double sum = 0.0;
+              for (size_t j = 0; j < count; ++j)
+              {
+                sum += static_cast<double>(values[j]);
+              }
+              const auto average = sum / static_cast<double>(count);
+              value = std::is_floating_point<R>::value
+                      ? static_cast<R>(average)
+                      : static_cast<R>(std::round(average));
+            }
+            else
+            {
+              // ties go to the first value so the top left pixel wins if they're all different
+              size_t most = 0;
+              for (size_t j = 0; j < count; ++j)
+              {
+                size_t same = 0;
+                for (size_t k = 0; k < count; ++k)
+                {
+                  same += (values[j] == values[k]) ? 1 : 0;
+                }
+                if (same > most)
+                {
+                  most = same;
+                  value = values[j];
+                }
+              }
+            }
+          }
+          memcpy(&tile[(y * tile_width + x) * sizeof(R)], &value, sizeof(R));
+        }
+      }
+    });
+  return result;
+}
+}
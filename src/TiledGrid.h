@@ -0,0 +1,458 @@
+/* Copyright (c) His Majesty the King in Right of Canada as represented by the Minister of Natural Resources, 2024. */
+
+/* SPDX-License-Identifier: AGPL-3.0-or-later */
+
+#pragma once
+#include <bitset>
+#include "Grid.h"
+namespace tbd::data
+{
+/**
+ * \brief Number of rows and columns in each tile of a TiledGrid
+ */
+static constexpr Idx TILE_SIZE = 64;
+/**
+ * \brief Number of cells in each tile of a TiledGrid
+ */
+static constexpr size_t TILE_CELLS = static_cast<size_t>(TILE_SIZE) * TILE_SIZE;
+/**
+ * \brief Values for a square block of cells in a TiledGrid.
+ * \tparam T Type of data stored
+ */
+template <class T>
+struct Tile
+{
+  /**
+   * \brief Value for each cell, in row major order
+   */
+  array<T, TILE_CELLS> values;
+  /**
+   * \brief Which cells have had a value set
+   */
+  std::bitset<TILE_CELLS> has_value{};
+  /**
+   * \brief Number of cells that have had a value set
+   */
+  size_t count{0};
+};
+/**
+ * \brief A GridData that stores values in dense tiles that are only allocated where
+ * values are set.
+ *
+ * Tiles are kept when cleared so the same TiledGrid can be reused without allocating.
+ * \tparam T Type of data after conversion from initialization type.
+ * \tparam V Type of data used as an input when initializing.
+ */
+template <class T, class V = T>
+class TiledGrid final
+  : public GridData<T, V, vector<unique_ptr<Tile<T>>>>
+{
+public:
+  /**
+   * \brief Storage used for tiles
+   */
+  using Tiles = vector<unique_ptr<Tile<T>>>;
+  /**
+   * \brief Determine if Location has a value
+   * \param location Location to determine if present in TiledGrid
+   * \return Whether or not a value is present for the Location
+   */
+  [[nodiscard]] bool contains(const Location& location) const
+  {
+    const auto& tile = this->data[tileIndex(location)];
+    return nullptr != tile && tile->has_value[cellIndex(location)];
+  }
+  template <class P>
+  [[nodiscard]] bool contains(const Position<P>& position) const
+  {
+    return contains(Location{position.hash()});
+  }
+  /**
+   * \brief Retrieve value at Location
+   * \param location Location to get value for
+   * \return Value at Location
+   */
+  [[nodiscard]] T at(const Location& location) const override
+  {
+    const auto& tile = this->data[tileIndex(location)];
+    return nullptr == tile ? this->nodataValue() : tile->values[cellIndex(location)];
+  }
+  template <class P>
+  [[nodiscard]] T at(const Position<P>& position) const
+  {
+    return at(Location{position.hash()});
+  }
+  /**
+   * \brief Set value at Location
+   * \param location Location to set value for
+   * \param value Value to set at Location
+   */
+  void set(const Location& location, const T value) override
+  {
+    const auto t = tileIndex(location);
+    auto& tile = this->data[t];
+    if (nullptr == tile)
+    {
+      tile = make_unique<Tile<T>>();
+      tile->values.fill(this->nodataValue());
+    }
+    const auto i = cellIndex(location);
+    if (!tile->has_value[i])
+    {
+      if (0 == tile->count)
+      {
+        used_.push_back(t);
+      }
+      tile->has_value.set(i);
+      ++tile->count;
+      ++size_;
+      const auto r = location.row();
+      const auto c = location.column();
+      min_row_ = min(min_row_, r);
+      max_row_ = max(max_row_, r);
+      min_column_ = min(min_column_, c);
+      max_column_ = max(max_column_, c);
+    }
+    tile->values[i] = value;
+  }
+  template <class P>
+  void set(const Position<P>& position, const T value)
+  {
+    return set(Location{position.hash()}, value);
+  }
+  ~TiledGrid() = default;
+  /**
+   * \brief Constructor
+   * \param cell_size Cell width and height (m)
+   * \param rows Number of rows
+   * \param columns Number of columns
+   * \param no_data Value that represents no data
+   * \param nodata Integer value that represents no data
+   * \param xllcorner Lower left corner X coordinate (m)
+   * \param yllcorner Lower left corner Y coordinate (m)
+   * \param xurcorner Upper right corner X coordinate (m)
+   * \param yurcorner Upper right corner Y coordinate (m)
+   * \param proj4 Proj4 projection definition
+   */
+  TiledGrid(const MathSize cell_size,
+            const Idx rows,
+            const Idx columns,
+            T no_data,
+            const int nodata,
+            const MathSize xllcorner,
+            const MathSize yllcorner,
+            const MathSize xurcorner,
+            const MathSize yurcorner,
+            string&& proj4)
+    : GridData<T, V, Tiles>(cell_size,
+                            rows,
+                            columns,
+                            no_data,
+                            nodata,
+                            xllcorner,
+                            yllcorner,
+                            xurcorner,
+                            yurcorner,
+                            std::forward<string>(proj4),
+                            Tiles(tileCount(rows) * tileCount(columns))),
+      tile_columns_(tileCount(columns))
+  {
+    clearBounds();
+  }
+  /**
+   * \brief Construct empty TiledGrid with same extent as given Grid
+   * \param grid_info Grid to use extent from
+   * \param no_data Value to use for no data
+   */
+  TiledGrid(const GridBase& grid_info, T no_data)
+    : TiledGrid<T, V>(grid_info.cellSize(),
+                      static_cast<Idx>(grid_info.calculateRows()),
+                      static_cast<Idx>(grid_info.calculateColumns()),
+                      no_data,
+                      static_cast<int>(no_data),
+                      grid_info.xllcorner(),
+                      grid_info.yllcorner(),
+                      grid_info.xurcorner(),
+                      grid_info.yurcorner(),
+                      string(grid_info.proj4()))
+  {
+  }
+  /**
+   * \brief Move constructor
+   * \param rhs TiledGrid to move from
+   */
+  TiledGrid(TiledGrid&& rhs) noexcept = default;
+  /**
+   * \brief Copy constructor
+   * \param rhs TiledGrid to copy from
+   */
+  TiledGrid(const TiledGrid& rhs)
+    : TiledGrid<T, V>(rhs.cellSize(),
+                      rhs.rows(),
+                      rhs.columns(),
+                      rhs.nodataValue(),
+                      static_cast<int>(rhs.nodataInput()),
+                      rhs.xllcorner(),
+                      rhs.yllcorner(),
+                      rhs.xurcorner(),
+                      rhs.yurcorner(),
+                      string(rhs.proj4()))
+  {
+    *this = rhs;
+  }
+  /**
+   * \brief Move assignment
+   * \param rhs TiledGrid to move from
+   * \return This, after assignment
+   */
+  TiledGrid& operator=(TiledGrid&& rhs) noexcept = default;
+  /**
+   * \brief Copy assignment
+   * \param rhs TiledGrid to copy from
+   * \return This, after assignment
+   */
+  TiledGrid& operator=(const TiledGrid& rhs)
+  {
+    if (this != &rhs)
+    {
+      logging::check_equal(this->data.size(), rhs.data.size(), "number of tiles");
+      clear();
+      for (const auto t : rhs.used_)
+      {
+        auto& tile = this->data[t];
+        if (nullptr == tile)
+        {
+          tile = make_unique<Tile<T>>(*rhs.data[t]);
+        }
+        else
+        {
+          *tile = *rhs.data[t];
+        }
+      }
+      used_ = rhs.used_;
+      size_ = rhs.size_;
+      min_row_ = rhs.min_row_;
+      max_row_ = rhs.max_row_;
+      min_column_ = rhs.min_column_;
+      max_column_ = rhs.max_column_;
+    }
+    return *this;
+  }
+  /**
+   * \brief Clear data from TiledGrid but keep tiles for reuse
+   */
+  void clear() noexcept
+  {
+    for (const auto t : used_)
+    {
+      auto& tile = *this->data[t];
+      tile.values.fill(this->nodataValue());
+      tile.has_value.reset();
+      tile.count = 0;
+    }
+    used_.clear();
+    size_ = 0;
+    clearBounds();
+  }
+  /**
+   * \brief Add values from another TiledGrid with the same extent, one tile at a time
+   *
+   * Cells that only have a value in rhs take the value from rhs.
+   * \param rhs TiledGrid to add values from
+   */
+  void add(const TiledGrid& rhs)
+  {
+    logging::check_equal(this->data.size(), rhs.data.size(), "number of tiles");
+    for (const auto t : rhs.used_)
+    {
+      const auto& from = *rhs.data[t];
+      auto& tile = this->data[t];
+      if (nullptr == tile || 0 == tile->count)
+      {
+        // nothing here yet so just take the whole tile
+        if (nullptr == tile)
+        {
+          tile = make_unique<Tile<T>>(from);
+        }
+        else
+        {
+          *tile = from;
+        }
+        used_.push_back(t);
+        size_ += from.count;
+        continue;
+      }
+      for (size_t i = 0; i < TILE_CELLS; ++i)
+      {
+        if (from.has_value[i])
+        {
+          tile->values[i] = tile->has_value[i]
+                            ? static_cast<T>(tile->values[i] + from.values[i])
+                            : from.values[i];
+        }
+      }
+      size_ -= tile->count;
+      tile->has_value |= from.has_value;
+      tile->count = tile->has_value.count();
+      size_ += tile->count;
+    }
+    min_row_ = min(min_row_, rhs.min_row_);
+    max_row_ = max(max_row_, rhs.max_row_);
+    min_column_ = min(min_column_, rhs.min_column_);
+    max_column_ = max(max_column_, rhs.max_column_);
+  }
+  /**
+   * \brief Save TiledGrid contents to file as probability
+   * \param dir Directory to save into
+   * \param base_name File base name to use
+   * \param divisor Number of simulations to divide by to calculate probability per cell
+   */
+  template <class R>
+  string saveToProbabilityFile(const string& dir,
+                               const string& base_name,
+                               const R divisor) const
+  {
+    auto div = [divisor](T value) -> R {
+      return static_cast<R>(value / divisor);
+    };
+    return this->template saveToFile<R>(dir, base_name, div, OverviewReduction::Average);
+  }
+  /**
+   * \brief Number of cells that have a value
+   * \return Number of cells that have a value
+   */
+  [[nodiscard]] size_t size() const noexcept
+  {
+    return size_;
+  }
+  /**
+   * \brief Calculate area for cells that have a value (ha)
+   * \return Area for cells that have a value (ha)
+   */
+  [[nodiscard]] MathSize fireSize() const noexcept
+  {
+    const MathSize per_width = (this->cellSize() / 100.0);
+    // cells might have 0 as a value, but those shouldn't affect size
+    return static_cast<MathSize>(size_) * per_width * per_width;
+  }
+  /**
+   * \brief Call function with every Location that has a value and its value
+   * \param fct Function to call with Location and value
+   */
+  template <class F>
+  void forEach(F fct) const
+  {
+    for (const auto t : used_)
+    {
+      const auto& tile = *this->data[t];
+      const auto row0 = static_cast<Idx>(t / tile_columns_ * TILE_SIZE);
+      const auto column0 = static_cast<Idx>(t % tile_columns_ * TILE_SIZE);
+      for (size_t i = 0; i < TILE_CELLS; ++i)
+      {
+        if (tile.has_value[i])
+        {
+          fct(Location(static_cast<Idx>(row0 + i / TILE_SIZE),
+                       static_cast<Idx>(column0 + i % TILE_SIZE)),
+              tile.values[i]);
+        }
+      }
+    }
+  }
+protected:
+  bool forEachValue(const function<void(const Location&, T)>& fct) const override
+  {
+    forEach(fct);
+    return true;
+  }
+  tuple<Idx, Idx, Idx, Idx> dataBounds() const override
+  {
+    auto min_row = min_row_;
+    auto max_row = max_row_;
+    auto min_column = min_column_;
+    auto max_column = max_column_;
+    // do this so that we take the center point when there's no data since it should
+    // stay the same if the grid is centered on the fire
+    if (min_row > max_row)
+    {
+      min_row = max_row = this->rows() / 2;
+    }
+    if (min_column > max_column)
+    {
+      min_column = max_column = this->columns() / 2;
+    }
+    return tuple<Idx, Idx, Idx, Idx>{
+      min_column,
+      min_row,
+      max_column,
+      max_row};
+  }
+private:
+  /**
+   * \brief Number of tiles needed to cover the given number of cells
+   * \param cells Number of cells
+   * \return Number of tiles needed to cover the given number of cells
+   */
+  [[nodiscard]] static constexpr size_t tileCount(const Idx cells) noexcept
+  {
+    return (static_cast<size_t>(cells) + TILE_SIZE - 1) / TILE_SIZE;
+  }
+  /**
+   * \brief Index of tile that contains Location
+   * \param location Location to find tile for
+   * \return Index of tile that contains Location
+   */
+  [[nodiscard]] size_t tileIndex(const Location& location) const noexcept
+  {
+    return static_cast<size_t>(location.row() / TILE_SIZE) * tile_columns_
+         + static_cast<size_t>(location.column() / TILE_SIZE);
+  }
+  /**
+   * \brief Index of Location within the tile that contains it
+   * \param location Location to find index for
+   * \return Index of Location within the tile that contains it
+   */
+  [[nodiscard]] static constexpr size_t cellIndex(const Location& location) noexcept
+  {
+    return static_cast<size_t>(location.row() % TILE_SIZE) * TILE_SIZE
+         + static_cast<size_t>(location.column() % TILE_SIZE);
+  }
+  /**
+   * \brief Reset bounds to represent no data
+   */
+  void clearBounds() noexcept
+  {
+    min_row_ = this->rows();
+    max_row_ = 0;
+    min_column_ = this->columns();
+    max_column_ = 0;
+  }
+  /**
+   * \brief Number of tiles in each row of tiles
+   */
+  size_t tile_columns_;
+  /**
+   * \brief Indices of tiles that have any values, in the order they were first used
+   */
+  vector<size_t> used_{};
+  /**
+   * \brief Number of cells that have a value
+   */
+  size_t size_{0};
+  /**
+   * \brief Lowest row that has a value
+   */
+  Idx min_row_{};
+  /**
+   * \brief Highest row that has a value
+   */
+  Idx max_row_{};
+  /**
+   * \brief Lowest column that has a value
+   */
+  Idx min_column_{};
+  /**
+   * \brief Highest column that has a value
+   */
+  Idx max_column_{};
+};
+}
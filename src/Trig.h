@@ -0,0 +1,267 @@
+/* Copyright (c) His Majesty the King in Right of Canada as represented by the Minister of Natural Resources, 2024. */
+
+/* SPDX-License-Identifier: AGPL-3.0-or-later */
+
+// Trigonometric functions that are defined in terms of basic arithmetic so they can be
+// inlined and vectorized, but still give the same results at any optimization level for
+// a given target. Every multiply-add goes through mul_add() so the compiler can't decide
+// whether or not to fuse it, which is what makes the library versions unstable. These
+// are not the same as the library versions, which they can differ from in the last bit.
+// -ffast-math can still reassociate arithmetic on targets without FMA, so results are
+// only the same with it if FMA is available, but signed zeros are handled either way.
+#pragma once
+#include <array>
+#include <bit>
+#include <cmath>
+#include <cstdint>
+#include "unstable.h"
+namespace tbd::util::trig
+{
+/**
+ * \brief Calculate a * b + c the same way regardless of optimization flags
+ * \param a First value to multiply
+ * \param b Second value to multiply
+ * \param c Value to add
+ * \return a * b + c
+ */
+[[nodiscard]] inline MathSize mul_add(const MathSize a, const MathSize b, const MathSize c) noexcept
+{
+#ifdef __FMA__
+  return std::fma(a, b, c);
+#else
+  // can't be fused without FMA instructions, so this is always two operations
+  return a * b + c;
+#endif
+}
+/**
+ * \brief Whether sign bit is set, read from the bits so -ffast-math can't assume -0 is 0
+ * \param x Value to check
+ * \return Whether sign bit is set
+ */
+[[nodiscard]] inline bool sign_bit(const MathSize x) noexcept
+{
+  return 0 != (std::bit_cast<uint64_t>(x) >> 63);
+}
+/**
+ * \brief Whether value is 0 or -0, checked using the bits so -ffast-math can't replace -0 with 0 after
+ * \param x Value to check
+ * \return Whether value is 0 or -0
+ */
+[[nodiscard]] inline bool is_zero(const MathSize x) noexcept
+{
+  return 0 == (std::bit_cast<uint64_t>(x) << 1);
+}
+/**
+ * \brief Value with sign bit set if negative, set in the bits so -ffast-math can't drop it from 0
+ * \param x Value that doesn't have sign bit set
+ * \param is_negative Whether to set sign bit
+ * \return Value with sign bit set if negative
+ */
+[[nodiscard]] inline MathSize with_sign(const MathSize x, const bool is_negative) noexcept
+{
+  return std::bit_cast<MathSize>(std::bit_cast<uint64_t>(x) | (static_cast<uint64_t>(is_negative) << 63));
+}
+/**
+ * \brief Calculate n!
+ * \param n Number to calculate factorial of
+ * \return n!
+ */
+[[nodiscard]] constexpr MathSize factorial(const int n) noexcept
+{
+  return n <= 1 ? 1.0 : n * factorial(n - 1);
+}
+/**
+ * \brief Number of terms used in polynomials for sin() and cos() after the first two
+ */
+static constexpr size_t NUM_SIN_COS_TERMS = 8;
+/**
+ * \brief Coefficients for sin(r) = r + r^3 * P(r^2) on [-pi/4, pi/4]
+ */
+static constexpr auto SIN_COEFFICIENTS = []() {
+  std::array<MathSize, NUM_SIN_COS_TERMS> result{};
+  for (size_t i = 0; i < result.size(); ++i)
+  {
+    const auto n = static_cast<int>(2 * i + 3);
+    result[i] = (0 == i % 2 ? -1.0 : 1.0) / factorial(n);
+  }
+  return result;
+}();
+/**
+ * \brief Coefficients for cos(r) = 1 - r^2 / 2 + r^4 * Q(r^2) on [-pi/4, pi/4]
+ */
+static constexpr auto COS_COEFFICIENTS = []() {
+  std::array<MathSize, NUM_SIN_COS_TERMS> result{};
+  for (size_t i = 0; i < result.size(); ++i)
+  {
+    const auto n = static_cast<int>(2 * i + 4);
+    result[i] = (0 == i % 2 ? 1.0 : -1.0) / factorial(n);
+  }
+  return result;
+}();
+/**
+ * \brief Number of terms used in polynomial for atan() after the first
+ */
+static constexpr size_t NUM_ATAN_TERMS = 15;
+/**
+ * \brief Coefficients for atan(a) = a + a^3 * P(a^2) on [-tan(pi/12), tan(pi/12)]
+ */
+static constexpr auto ATAN_COEFFICIENTS = []() {
+  std::array<MathSize, NUM_ATAN_TERMS> result{};
+  for (size_t i = 0; i < result.size(); ++i)
+  {
+    result[i] = (0 == i % 2 ? -1.0 : 1.0) / static_cast<MathSize>(2 * i + 3);
+  }
+  return result;
+}();
+/**
+ * \brief pi / 2 split into parts so that multiplying the first two by an integer is exact
+ */
+static constexpr MathSize PIO2_1 = 1.5707963267341256;
+static constexpr MathSize PIO2_2 = 6.077100506303966e-11;
+static constexpr MathSize PIO2_3 = 2.0222662487959506e-21;
+static constexpr MathSize TWO_OVER_PI = 0.6366197723675814;
+static constexpr MathSize PI_2 = 1.5707963267948966;
+static constexpr MathSize PI_6 = 0.5235987755982989;
+static constexpr MathSize PI = 3.141592653589793;
+static constexpr MathSize SQRT_3 = 1.7320508075688772;
+static constexpr MathSize TAN_PI_12 = 0.2679491924311228;
+/**
+ * \brief Evaluate polynomial with given coefficients using Horner's method
+ * \tparam N Number of coefficients
+ * \param coefficients Coefficients, starting with the constant term
+ * \param x Value to evaluate polynomial at
+ * \return Value of polynomial at x
+ */
+template <size_t N>
+[[nodiscard]] inline MathSize polynomial(const std::array<MathSize, N>& coefficients,
+                                         const MathSize x) noexcept
+{
+  auto result = coefficients[N - 1];
+  for (size_t i = N - 1; i > 0; --i)
+  {
+    result = mul_add(result, x, coefficients[i - 1]);
+  }
+  return result;
+}
+/**
+ * \brief Calculate sin() and cos() of the same angle
+ * \param angle Angle (radians)
+ * \param sin_out Where to put sine of angle
+ * \param cos_out Where to put cosine of angle
+ */
+inline void sin_cos(const MathSize angle, MathSize* sin_out, MathSize* cos_out) noexcept
+{
+  // reduce to [-pi/4, pi/4] and remember which quadrant angle was in
+  const auto k = std::floor(mul_add(angle, TWO_OVER_PI, 0.5));
+  auto r = mul_add(-k, PIO2_1, angle);
+  r = mul_add(-k, PIO2_2, r);
+  r = mul_add(-k, PIO2_3, r);
+  const auto quadrant = static_cast<int64_t>(k) & 3;
+  const auto z = r * r;
+  const auto s = mul_add(r * z, polynomial(SIN_COEFFICIENTS, z), r);
+  const auto c = mul_add(z, mul_add(z, polynomial(COS_COEFFICIENTS, z), -0.5), 1.0);
+  // select instead of branching so this can be vectorized
+  const auto is_swapped = 0 != (quadrant & 1);
+  const auto s_q = is_swapped ? c : s;
+  const auto c_q = is_swapped ? s : c;
+  *sin_out = 0 != (quadrant & 2) ? -s_q : s_q;
+  *cos_out = 0 != ((quadrant + 1) & 2) ? -c_q : c_q;
+}
+/**
+ * \brief Calculate sin() and cos() for a group of angles
+ * \param n Number of angles
+ * \param angles Angles (radians)
+ * \param sin_out Where to put sine of each angle
+ * \param cos_out Where to put cosine of each angle
+ */
+inline void sin_cos(const size_t n,
+                    const MathSize* angles,
+                    MathSize* sin_out,
+                    MathSize* cos_out) noexcept
+{
+  for (size_t i = 0; i < n; ++i)
+  {
+    sin_cos(angles[i], &sin_out[i], &cos_out[i]);
+  }
+}
+/**
+ * \brief Sine of angle
+ * \param angle Angle (radians)
+ * \return Sine of angle
+ */
+[[nodiscard]] inline MathSize sin(const MathSize angle) noexcept
+{
+  MathSize s;
+  MathSize c;
+  sin_cos(angle, &s, &c);
+  return s;
+}
+/**
+ * \brief Cosine of angle
+ * \param angle Angle (radians)
+ * \return Cosine of angle
+ */
+[[nodiscard]] inline MathSize cos(const MathSize angle) noexcept
+{
+  MathSize s;
+  MathSize c;
+  sin_cos(angle, &s, &c);
+  return c;
+}
+/**
+ * \brief Arctangent of value
+ * \param x Value to calculate arctangent of
+ * \return Arctangent of value (radians)
+ */
+[[nodiscard]] inline MathSize atan(const MathSize x) noexcept
+{
+  // use atan(x) = pi/2 - atan(1/x) and atan(x) = pi/6 + atan((x * sqrt(3) - 1) / (x + sqrt(3)))
+  // to reduce to a range where the series converges quickly
+  // use sign bit so atan(-0) is -0
+  const auto is_negative = sign_bit(x);
+  auto a = is_negative ? -x : x;
+  const auto is_inverted = a > 1.0;
+  a = is_inverted ? 1.0 / a : a;
+  const auto is_shifted = a > TAN_PI_12;
+  a = is_shifted ? mul_add(a, SQRT_3, -1.0) / (a + SQRT_3) : a;
+  const auto z = a * a;
+  auto result = mul_add(a * z, polynomial(ATAN_COEFFICIENTS, z), a);
+  result = is_shifted ? result + PI_6 : result;
+  result = is_inverted ? PI_2 - result : result;
+  return with_sign(result, is_negative);
+}
+/**
+ * \brief Angle of vector (x, y) from the x axis
+ * \param y Y component of vector
+ * \param x X component of vector
+ * \return Angle of vector (x, y) from the x axis (radians)
+ */
+[[nodiscard]] inline MathSize atan2(const MathSize y, const MathSize x) noexcept
+{
+  // use sign bits so -0 is treated as below the x axis or left of the y axis like std::atan2()
+  if (is_zero(x))
+  {
+    if (is_zero(y))
+    {
+      return with_sign(sign_bit(x) ? PI : 0.0, sign_bit(y));
+    }
+    return with_sign(PI_2, sign_bit(y));
+  }
+  const auto result = atan(y / x);
+  if (x > 0)
+  {
+    return result;
+  }
+  return sign_bit(y) ? result - PI : result + PI;
+}
+/**
+ * \brief Arccosine of value
+ * \param x Value to calculate arccosine of, in [-1, 1]
+ * \return Arccosine of value (radians)
+ */
+[[nodiscard]] inline MathSize acos(const MathSize x) noexcept
+{
+  // (1 - x) * (1 + x) keeps precision near +/-1 better than 1 - x * x
+  return atan2(std::sqrt((1.0 - x) * (1.0 + x)), x);
+}
+}
@@ -97,17 +97,21 @@ void read_directory(const string& name, vector<string>* v)
 {
   read_directory(name, v, "*");
 }
-vector<string> find_rasters(const string& dir, const int year)
+string find_raster_root(const string& dir, const int year)
 {
   const auto for_year = dir + "/" + to_string(year) + "/";
   const auto for_default = dir + "/default/";
   // use first existing folder of dir/year, dir/default, or dir in that order
-  const auto raster_root = directory_exists(for_year.c_str())
-                           ? for_year
-                           : (
-                               directory_exists(for_default.c_str())
-                                 ? for_default
-                                 : dir);
+  return directory_exists(for_year.c_str())
+         ? for_year
+         : (
+             directory_exists(for_default.c_str())
+               ? for_default
+               : dir);
+}
+vector<string> find_rasters(const string& dir, const int year)
+{
+  const auto raster_root = find_raster_root(dir, year);
   vector<string> results{};
   try
   {
@@ -135,6 +139,26 @@ bool file_exists(const char* path) noexcept
   // FIX: check that this works on symlinks
   return stat(path, &path_info) == 0 && path_info.st_mode & S_IFREG;
 }
+uint64_t hash_bytes(const void* data, const size_t size, uint64_t hash) noexcept
+{
+  const auto bytes = static_cast<const uint8_t*>(data);
+  for (size_t i = 0; i < size; ++i)
+  {
+    hash = (hash ^ bytes[i]) * 1099511628211ULL;
+  }
+  return hash;
+}
+uint64_t hash_file(const string& path, uint64_t hash)
+{
+  ifstream in(path, std::ios::binary);
+  logging::check_fatal(!in.good(), "Unable to read %s", path.c_str());
+  vector<char> buffer(1 << 16);
+  while (in.read(buffer.data(), static_cast<std::streamsize>(buffer.size())) || 0 < in.gcount())
+  {
+    hash = hash_bytes(buffer.data(), static_cast<size_t>(in.gcount()), hash);
+  }
+  return hash;
+}
 void make_directory(const char* dir) noexcept
 {
 #ifdef _WIN32
@@ -5,6 +5,7 @@
 
 #pragma once
 #include "stdafx.h"
+#include "Trig.h"
 #include <string>
 #include <unordered_map>
 #include <utility>
@@ -224,6 +225,25 @@ std::basic_istream<Elem, Traits>& getline(
  * \return Whether or not the file exists
  */
 [[nodiscard]] bool file_exists(const char* path) noexcept;
+/**
+ * \brief Starting value for FNV-1a hashes
+ */
+static constexpr uint64_t HASH_START = 14695981039346656037ULL;
+/**
+ * \brief Add bytes to an FNV-1a hash
+ * \param data Bytes to add
+ * \param size Number of bytes to add
+ * \param hash Hash to add to
+ * \return Hash including bytes
+ */
+[[nodiscard]] uint64_t hash_bytes(const void* data, size_t size, uint64_t hash = HASH_START) noexcept;
+/**
+ * \brief FNV-1a hash of a file's contents
+ * \param path File to hash
+ * \param hash Hash to add to
+ * \return Hash including file contents
+ */
+[[nodiscard]] uint64_t hash_file(const string& path, uint64_t hash = HASH_START);
 /**
  * \brief Get a list of items in the given directory matching the given regex
  * \param for_files Match files and not directories
@@ -259,6 +279,13 @@ void read_directory(const bool for_files,
  * \param v vector to put found file names into
  */
 void read_directory(const string& name, vector<string>* v);
+/**
+ * \brief Determine directory to use rasters from for the specified year
+ * \param dir Root directory to look for rasters in
+ * \param year Year to use rasters for if available, else default
+ * \return First existing directory of dir/year, dir/default, or dir
+ */
+[[nodiscard]] string find_raster_root(const string& dir, int year);
 /**
  * \brief Get a list of rasters in the given directory for the specified year
  * \param dir Root directory to look for rasters in
@@ -516,7 +543,7 @@ void month_and_day(const int year, const size_t day_of_year, size_t* month, size
                                             const MathSize theta)
 {
   return (util::fix_radians(
-    atan2(sin(theta) / length_to_breadth,
-          cos(theta))));
+    util::trig::atan2(util::trig::sin(theta) / length_to_breadth,
+                      util::trig::cos(theta))));
 }
 }
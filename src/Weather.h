@@ -5,6 +5,7 @@
 #pragma once
 #include "Index.h"
 #include "Util.h"
+#include "Trig.h"
 #include "unstable.h"
 namespace tbd
 {
@@ -157,8 +158,8 @@ public:
    * \param speed Speed of wind
    */
   Wind(const Direction& direction, const Speed speed) noexcept
-    : wsv_x_(speed.asValue() * _sin(direction.heading())),
-      wsv_y_(speed.asValue() * _cos(direction.heading())),
+    : wsv_x_(speed.asValue() * util::trig::sin(direction.heading())),
+      wsv_y_(speed.asValue() * util::trig::cos(direction.heading())),
       direction_(direction),
       speed_(speed)
   {
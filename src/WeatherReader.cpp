@@ -0,0 +1,615 @@
+/* Copyright (c) His Majesty the King in Right of Canada as represented by the Minister of Natural Resources, 2024. */
+
+/* SPDX-License-Identifier: AGPL-3.0-or-later */
+
+#include "stdafx.h"
+#include "WeatherReader.h"
+#include <charconv>
+#include <thread>
+#include "Log.h"
+#include "MappedFile.h"
+#include "Util.h"
+#include "WorkerPool.h"
+namespace tbd::wx
+{
+/**
+ * \brief Columns that input needs to have, in this order
+ */
+static constexpr auto EXPECTED_HEADER = "Scenario,Date,PREC,TEMP,RH,WS,WD,FFMC,DMC,DC,ISI,BUI,FWI";
+/**
+ * \brief Number of values in each row after the scenario and date
+ */
+static constexpr size_t NUM_COLUMNS = 11;
+/**
+ * \brief Names of values in each row after the scenario and date, in the order they are stored
+ */
+static constexpr const char* COLUMNS[NUM_COLUMNS] =
+  {"PREC", "TEMP", "RH", "WS", "WD", "FFMC", "DMC", "DC", "ISI", "BUI", "FWI"};
+/**
+ * \brief Identifies a binary weather file
+ */
+static constexpr char BINARY_MAGIC[8] = {'F', 'S', 'T', 'R', 'W', 'X', '\0', '\0'};
+/**
+ * \brief Version of binary weather format, which needs to change if the format does
+ */
+static constexpr uint32_t BINARY_VERSION = 2;
+/**
+ * \brief Start of a binary weather file
+ *
+ * This is followed by an id for each scenario, and then a block of doubles for each of
+ * COLUMNS with all hours for the first scenario, then all hours for the second, and so on.
+ */
+struct BinaryHeader
+{
+  /**
+   * \brief Always BINARY_MAGIC
+   */
+  char magic[8];
+  /**
+   * \brief Always BINARY_VERSION, which also catches files with the wrong byte order
+   */
+  uint32_t version;
+  /**
+   * \brief Number of scenarios
+   */
+  uint32_t scenarios;
+  /**
+   * \brief Number of hours for each scenario
+   */
+  uint32_t hours;
+  /**
+   * \brief Year of first hour
+   */
+  int32_t year;
+  /**
+   * \brief Month of first hour (1 - 12)
+   */
+  int32_t month;
+  /**
+   * \brief Day of month of first hour (1 - 31)
+   */
+  int32_t day_of_month;
+  /**
+   * \brief Hour of day of first hour (0 - 23)
+   */
+  int32_t hour;
+  /**
+   * \brief Keeps scenario ids that come after this aligned
+   */
+  uint32_t unused;
+};
+static_assert(40 == sizeof(BinaryHeader));
+/**
+ * \brief Number of days in year before the start of each month, for non-leap years
+ */
+static constexpr int DAYS_BEFORE_MONTH[] = {0, 31, 59, 90, 120, 151, 181, 212, 243, 273, 304, 334};
+/**
+ * \brief Number of days in each month, for non-leap years
+ */
+static constexpr int DAYS_IN_MONTH[] = {31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
+/**
+ * \brief Number of days since 1970-01-01, so hours can be compared without mktime()
+ * \param year Year
+ * \param month Month (1 - 12)
+ * \param day Day of month (1 - 31)
+ * \return Number of days since 1970-01-01
+ */
+static constexpr int64_t days_from_civil(int64_t year, const int64_t month, const int64_t day) noexcept
+{
+  year -= month <= 2;
+  const auto era = (year >= 0 ? year : year - 399) / 400;
+  const auto year_of_era = year - era * 400;
+  const auto day_of_year = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+  const auto day_of_era = year_of_era * 365 + year_of_era / 4 - year_of_era / 100 + day_of_year;
+  return era * 146097 + day_of_era - 719468;
+}
+/**
+ * \brief Date and hour for a number of hours since 1970-01-01 00:00
+ * \param hours Number of hours since 1970-01-01 00:00
+ * \return Date and hour
+ */
+static WeatherTime to_weather_time(const int64_t hours) noexcept
+{
+  // floor division so times before 1970 still work
+  const auto days = (hours >= 0 ? hours : hours - (DAY_HOURS - 1)) / DAY_HOURS;
+  const auto z = days + 719468;
+  const auto era = (z >= 0 ? z : z - 146096) / 146097;
+  const auto day_of_era = z - era * 146097;
+  const auto year_of_era = (day_of_era - day_of_era / 1460 + day_of_era / 36524 - day_of_era / 146096) / 365;
+  const auto day_of_year = day_of_era - (365 * year_of_era + year_of_era / 4 - year_of_era / 100);
+  const auto mp = (5 * day_of_year + 2) / 153;
+  const auto month = static_cast<int>(mp < 10 ? mp + 3 : mp - 9);
+  const auto year = static_cast<int>(year_of_era + era * 400 + (month <= 2 ? 1 : 0));
+  const auto day_of_month = static_cast<int>(day_of_year - (153 * mp + 2) / 5 + 1);
+  return {year,
+          month,
+          day_of_month,
+          static_cast<Day>(DAYS_BEFORE_MONTH[month - 1]
+                           + (2 < month && is_leap_year(year) ? 1 : 0)
+                           + day_of_month - 1),
+          static_cast<int>(hours - days * DAY_HOURS)};
+}
+/**
+ * \brief Make weather from column values, calculating the same way as reading from a stream does
+ * \param values Values in the same order as COLUMNS
+ * \return Weather for the hour
+ */
+static FwiWeather make_weather(const array<MathSize, NUM_COLUMNS>& values)
+{
+  const Precipitation prec(values[0]);
+  const Temperature temp(values[1]);
+  const RelativeHumidity rh(values[2]);
+  const Speed ws(values[3]);
+  const Direction wd(values[4], false);
+  const Wind wind(wd, ws);
+  const Ffmc ffmc(values[5]);
+  const Dmc dmc(values[6]);
+  const Dc dc(values[7]);
+  const Isi isi(values[8], ws, ffmc);
+  const Bui bui(values[9], dmc, dc);
+  const Fwi fwi(values[10], isi, bui);
+  logging::check_fatal(0 > prec.asValue(),
+                       "Hourly weather precip %f is negative",
+                       prec.asValue());
+  return {temp, rh, wind, prec, ffmc, dmc, dc, isi, bui, fwi};
+}
+/**
+ * \brief Range of characters for a line that values are read from in order
+ */
+class LineReader
+{
+public:
+  LineReader(const string& filename, const size_t line, const char* begin, const char* end) noexcept
+    : filename_(filename), line_(line), cur_(begin), end_(end)
+  {
+  }
+  /**
+   * \brief Skip past the next delimiter
+   */
+  void skip(const char delimiter) noexcept
+  {
+    while (cur_ < end_ && delimiter != *cur_)
+    {
+      ++cur_;
+    }
+    if (cur_ < end_)
+    {
+      ++cur_;
+    }
+  }
+  /**
+   * \brief Read number that is followed by delimiter or end of line
+   * \tparam T Type of number to read
+   * \param name Name of value for error messages
+   * \param delimiter Character that should come after number
+   * \return Number that was read
+   */
+  template <class T>
+  [[nodiscard]] T read(const char* name, const char delimiter)
+  {
+    skipSpaces();
+    // stod() would allow this but from_chars() doesn't
+    if (cur_ < end_ && '+' == *cur_)
+    {
+      ++cur_;
+    }
+    T value{};
+    const auto result = std::from_chars(cur_, end_, value);
+    if (std::errc() != result.ec)
+    {
+      fail(name);
+    }
+    cur_ = result.ptr;
+    skipSpaces();
+    if (cur_ < end_)
+    {
+      if (delimiter != *cur_)
+      {
+        fail(name);
+      }
+      ++cur_;
+    }
+    return value;
+  }
+  /**
+   * \brief Read number that is followed by any delimiter, ignoring anything else before it
+   * \tparam T Type of number to read
+   * \param name Name of value for error messages
+   * \param delimiter Character that ends the field the number is in
+   * \return Number that was read
+   */
+  template <class T>
+  [[nodiscard]] T readPrefix(const char* name, const char delimiter)
+  {
+    skipSpaces();
+    T value{};
+    const auto result = std::from_chars(cur_, end_, value);
+    if (std::errc() != result.ec)
+    {
+      fail(name);
+    }
+    cur_ = result.ptr;
+    skip(delimiter);
+    return value;
+  }
+  /**
+   * \brief Stop with an error about the value being read
+   * \param name Name of value
+   */
+  void fail(const char* name) const
+  {
+    const auto line_end = std::find(cur_, end_, '\n');
+    logging::fatal("Error reading weather file %s: invalid %s on line %ld near '%s'",
+                   filename_.c_str(),
+                   name,
+                   line_,
+                   string(cur_, line_end).c_str());
+  }
+private:
+  /**
+   * \brief Move past any spaces
+   */
+  void skipSpaces() noexcept
+  {
+    while (cur_ < end_ && ' ' == *cur_)
+    {
+      ++cur_;
+    }
+  }
+  /**
+   * \brief File being read
+   */
+  const string& filename_;
+  /**
+   * \brief Line number being read
+   */
+  size_t line_;
+  /**
+   * \brief Current position
+   */
+  const char* cur_;
+  /**
+   * \brief End of line
+   */
+  const char* end_;
+};
+/**
+ * \brief Rows for a single scenario
+ */
+struct ScenarioBlock
+{
+  /**
+   * \brief Scenario number
+   */
+  size_t id;
+  /**
+   * \brief Start of first row
+   */
+  const char* begin;
+  /**
+   * \brief End of last row
+   */
+  const char* end;
+  /**
+   * \brief Line number of first row
+   */
+  size_t first_line;
+  /**
+   * \brief Number of rows
+   */
+  size_t rows;
+};
+/**
+ * \brief Find end of line that starts at the given position
+ * \param begin Start of line
+ * \param end End of file
+ * \return Position of '\n' that ends line, or end of file
+ */
+static const char* line_end(const char* begin, const char* end) noexcept
+{
+  const auto found = static_cast<const char*>(memchr(begin, '\n', static_cast<size_t>(end - begin)));
+  return nullptr == found ? end : found;
+}
+/**
+ * \brief Remove trailing '\r' from line
+ * \param begin Start of line
+ * \param end End of line
+ * \return End of line without '\r'
+ */
+static const char* trim_end(const char* begin, const char* end) noexcept
+{
+  while (end > begin && ('\r' == *(end - 1) || ' ' == *(end - 1)))
+  {
+    --end;
+  }
+  return end;
+}
+/**
+ * \brief Whether line has something in the scenario column
+ * \param begin Start of line
+ * \param end End of line
+ * \return Whether line has something in the scenario column
+ */
+static bool has_scenario(const char* begin, const char* end) noexcept
+{
+  return begin < end && ',' != *begin;
+}
+/**
+ * \brief Parse rows for a scenario
+ * \param filename File being read
+ * \param block Rows to parse
+ * \return Weather for scenario
+ */
+static ScenarioWeather parse_scenario(const string& filename, const ScenarioBlock& block)
+{
+  logging::debug("Loading scenario %d...", block.id);
+  ScenarioWeather result{block.id, {}, {}};
+  // reserve so that nothing moves once weather is added
+  result.hours.reserve(block.rows);
+  result.times.reserve(block.rows);
+  auto prev_hours = std::numeric_limits<int64_t>::min();
+  auto line = block.first_line;
+  for (auto begin = block.begin; begin < block.end; ++line)
+  {
+    const auto end_of_line = line_end(begin, block.end);
+    const auto end = trim_end(begin, end_of_line);
+    if (has_scenario(begin, end))
+    {
+      LineReader reader(filename, line, begin, end);
+      reader.skip(',');
+      WeatherTime t{};
+      t.year = reader.readPrefix<int>("year", '-');
+      t.month = reader.readPrefix<int>("month", '-');
+      t.day_of_month = reader.readPrefix<int>("day", ' ');
+      const auto hour = reader.readPrefix<int>("hour", ',');
+      t.hour = hour;
+      const auto is_leap = is_leap_year(t.year);
+      if (1 > t.month || 12 < t.month)
+      {
+        reader.fail("month");
+      }
+      if (1 > t.day_of_month
+          || (DAYS_IN_MONTH[t.month - 1] + (2 == t.month && is_leap ? 1 : 0)) < t.day_of_month)
+      {
+        reader.fail("day");
+      }
+      if (0 > t.hour || DAY_HOURS <= t.hour)
+      {
+        reader.fail("hour");
+      }
+      t.day = static_cast<Day>(DAYS_BEFORE_MONTH[t.month - 1]
+                               + (2 < t.month && is_leap ? 1 : 0)
+                               + t.day_of_month - 1);
+      if (!result.times.empty() && t.day < result.times.front().day)
+      {
+        logging::fatal(
+          "Weather input file crosses year boundary or dates are not sequential");
+      }
+      const auto cur_hours = days_from_civil(t.year, t.month, t.day_of_month) * DAY_HOURS + t.hour;
+      if (prev_hours != std::numeric_limits<int64_t>::min())
+      {
+        logging::check_fatal(
+          1 != cur_hours - prev_hours,
+          "Expected sequential hours in weather input but rows are %f hours away from each other",
+          static_cast<MathSize>(cur_hours - prev_hours));
+      }
+      prev_hours = cur_hours;
+      array<MathSize, NUM_COLUMNS> values{};
+      for (size_t i = 0; i < NUM_COLUMNS; ++i)
+      {
+        values[i] = reader.read<MathSize>(COLUMNS[i], ',');
+      }
+      result.hours.emplace_back(make_weather(values));
+      result.times.emplace_back(t);
+    }
+    begin = end_of_line + 1;
+  }
+  return result;
+}
+vector<ScenarioWeather> read_weather_csv(const string& filename)
+{
+  const util::MappedFile file(filename);
+  const auto data = file.data();
+  const auto data_end = data + file.size();
+  // get rid of whitespace
+  const auto header_end = line_end(data, data_end);
+  string header(data, header_end);
+  header.erase(std::remove(header.begin(), header.end(), ' '), header.end());
+  header.erase(std::remove(header.begin(), header.end(), '\r'), header.end());
+  logging::check_fatal(EXPECTED_HEADER != header,
+                       "Input CSV must have columns in this order:\n'%s'\n but got:\n'%s'",
+                       EXPECTED_HEADER,
+                       header.c_str());
+  // find where each scenario starts so they can be parsed in parallel
+  vector<ScenarioBlock> blocks{};
+  set<size_t> seen{};
+  size_t line = 2;
+  for (auto begin = min(header_end + 1, data_end); begin < data_end; ++line)
+  {
+    const auto end_of_line = line_end(begin, data_end);
+    const auto end = trim_end(begin, end_of_line);
+    if (has_scenario(begin, end))
+    {
+      LineReader reader(filename, line, begin, end);
+      const auto id = reader.readPrefix<size_t>("scenario", ',');
+      if (blocks.empty() || id != blocks.back().id)
+      {
+        logging::check_fatal(!seen.emplace(id).second,
+                             "Error reading weather file %s: rows for scenario %ld need to be together",
+                             filename.c_str(),
+                             id);
+        blocks.push_back({id, begin, end_of_line, line, 0});
+      }
+      auto& block = blocks.back();
+      block.end = end_of_line;
+      ++block.rows;
+    }
+    begin = end_of_line + 1;
+  }
+  vector<ScenarioWeather> result(blocks.size());
+  {
+    util::WorkerPool pool(max(static_cast<size_t>(1),
+                              min(blocks.size(),
+                                  static_cast<size_t>(std::thread::hardware_concurrency()))));
+    for (size_t i = 0; i < blocks.size(); ++i)
+    {
+      pool.submit([&filename, &blocks, &result, i]() {
+        result[i] = parse_scenario(filename, blocks[i]);
+      });
+    }
+    pool.wait();
+  }
+  logging::info("Read %ld scenarios from '%s'", result.size(), filename.c_str());
+  return result;
+}
+bool is_weather_binary(const string& filename)
+{
+  ifstream in(filename, std::ios::binary);
+  char magic[sizeof BINARY_MAGIC]{};
+  return in.read(magic, sizeof magic) && 0 == memcmp(magic, BINARY_MAGIC, sizeof magic);
+}
+vector<ScenarioWeather> read_weather_binary(const string& filename)
+{
+  const util::MappedFile file(filename);
+  BinaryHeader header{};
+  logging::check_fatal(file.size() < sizeof header,
+                       "Weather file %s is too small to be binary weather",
+                       filename.c_str());
+  memcpy(&header, file.data(), sizeof header);
+  logging::check_fatal(0 != memcmp(header.magic, BINARY_MAGIC, sizeof BINARY_MAGIC),
+                       "Weather file %s is not binary weather",
+                       filename.c_str());
+  logging::check_fatal(BINARY_VERSION != header.version,
+                       "Weather file %s has unsupported version %d",
+                       filename.c_str(),
+                       header.version);
+  const size_t num_scenarios = header.scenarios;
+  const size_t num_hours = header.hours;
+  const auto ids = file.data() + sizeof header;
+  const auto columns = ids + num_scenarios * sizeof(uint64_t);
+  const auto column_size = num_scenarios * num_hours * sizeof(double);
+  logging::check_fatal(
+    file.size() != static_cast<size_t>(columns - file.data()) + NUM_COLUMNS * column_size,
+    "Weather file %s should have %ld scenarios with %ld hours but is the wrong size",
+    filename.c_str(),
+    num_scenarios,
+    num_hours);
+  logging::check_fatal(1 > header.month || 12 < header.month
+                         || 1 > header.day_of_month || 31 < header.day_of_month
+                         || 0 > header.hour || DAY_HOURS <= header.hour,
+                       "Weather file %s has invalid start date",
+                       filename.c_str());
+  // every scenario has the same hours so only figure them out once
+  const auto start = days_from_civil(header.year, header.month, header.day_of_month) * DAY_HOURS
+                   + header.hour;
+  vector<WeatherTime> times{};
+  times.reserve(num_hours);
+  for (size_t h = 0; h < num_hours; ++h)
+  {
+    times.emplace_back(to_weather_time(start + static_cast<int64_t>(h)));
+    if (times.back().day < times.front().day)
+    {
+      logging::fatal(
+        "Weather input file crosses year boundary or dates are not sequential");
+    }
+  }
+  vector<ScenarioWeather> result(num_scenarios);
+  {
+    util::WorkerPool pool(max(static_cast<size_t>(1),
+                              min(num_scenarios,
+                                  static_cast<size_t>(std::thread::hardware_concurrency()))));
+    for (size_t s = 0; s < num_scenarios; ++s)
+    {
+      pool.submit([&, s]() {
+        auto& scenario = result[s];
+        uint64_t id;
+        memcpy(&id, ids + s * sizeof id, sizeof id);
+        scenario.id = static_cast<size_t>(id);
+        logging::debug("Loading scenario %d...", scenario.id);
+        scenario.times = times;
+        scenario.hours.reserve(num_hours);
+        for (size_t h = 0; h < num_hours; ++h)
+        {
+          array<MathSize, NUM_COLUMNS> values{};
+          for (size_t i = 0; i < NUM_COLUMNS; ++i)
+          {
+            double v;
+            memcpy(&v, columns + i * column_size + (s * num_hours + h) * sizeof v, sizeof v);
+            values[i] = static_cast<MathSize>(v);
+          }
+          scenario.hours.emplace_back(make_weather(values));
+        }
+      });
+    }
+    pool.wait();
+  }
+  logging::info("Read %ld scenarios from '%s'", result.size(), filename.c_str());
+  return result;
+}
+vector<ScenarioWeather> read_weather(const string& filename)
+{
+  return is_weather_binary(filename)
+         ? read_weather_binary(filename)
+         : read_weather_csv(filename);
+}
+void write_weather_binary(const string& filename, const vector<ScenarioWeather>& scenarios)
+{
+  logging::check_fatal(scenarios.empty() || scenarios.front().times.empty(),
+                       "No weather to write to %s",
+                       filename.c_str());
+  const auto& first = scenarios.front().times;
+  for (const auto& s : scenarios)
+  {
+    logging::check_fatal(s.times.size() != first.size()
+                           || s.times.front().day != first.front().day
+                           || s.times.front().hour != first.front().hour,
+                         "Binary weather needs every scenario to cover the same hours but scenario %ld doesn't",
+                         s.id);
+  }
+  const auto num_hours = first.size();
+  BinaryHeader header{};
+  memcpy(header.magic, BINARY_MAGIC, sizeof BINARY_MAGIC);
+  header.version = BINARY_VERSION;
+  header.scenarios = static_cast<uint32_t>(scenarios.size());
+  header.hours = static_cast<uint32_t>(num_hours);
+  header.year = first.front().year;
+  header.month = first.front().month;
+  header.day_of_month = first.front().day_of_month;
+  header.hour = first.front().hour;
+  ofstream out(filename, std::ios::binary);
+  logging::check_fatal(!out.good(), "Cannot open file %s for output", filename.c_str());
+  out.write(reinterpret_cast<const char*>(&header), sizeof header);
+  for (const auto& s : scenarios)
+  {
+    const auto id = static_cast<uint64_t>(s.id);
+    out.write(reinterpret_cast<const char*>(&id), sizeof id);
+  }
+  const std::function<MathSize(const FwiWeather&)> values[NUM_COLUMNS] = {
+    [](const FwiWeather& w) { return w.prec().asValue(); },
+    [](const FwiWeather& w) { return w.temp().asValue(); },
+    [](const FwiWeather& w) { return w.rh().asValue(); },
+    [](const FwiWeather& w) { return w.wind().speed().asValue(); },
+    [](const FwiWeather& w) { return w.wind().direction().asValue(); },
+    [](const FwiWeather& w) { return w.ffmc().asValue(); },
+    [](const FwiWeather& w) { return w.dmc().asValue(); },
+    [](const FwiWeather& w) { return w.dc().asValue(); },
+    [](const FwiWeather& w) { return w.isi().asValue(); },
+    [](const FwiWeather& w) { return w.bui().asValue(); },
+    [](const FwiWeather& w) { return w.fwi().asValue(); }};
+  // same precision as parsing the .csv so results don't depend on which file is used
+  vector<double> column(num_hours);
+  for (const auto& value : values)
+  {
+    for (const auto& s : scenarios)
+    {
+      std::transform(s.hours.begin(),
+                     s.hours.end(),
+                     column.begin(),
+                     [&value](const FwiWeather& w) { return static_cast<double>(value(w)); });
+      out.write(reinterpret_cast<const char*>(column.data()),
+                static_cast<std::streamsize>(column.size() * sizeof(double)));
+    }
+  }
+  logging::check_fatal(!out.good(), "Could not write weather to %s", filename.c_str());
+}
+}
@@ -0,0 +1,92 @@
+/* Copyright (c) His Majesty the King in Right of Canada as represented by the Minister of Natural Resources, 2024. */
+
+/* SPDX-License-Identifier: AGPL-3.0-or-later */
+
+#pragma once
+#include <string>
+#include <vector>
+#include "FWI.h"
+namespace tbd::wx
+{
+/**
+ * \brief Date and hour that a row of hourly weather is for
+ */
+struct WeatherTime
+{
+  /**
+   * \brief Year
+   */
+  int year;
+  /**
+   * \brief Month (1 - 12)
+   */
+  int month;
+  /**
+   * \brief Day of month (1 - 31)
+   */
+  int day_of_month;
+  /**
+   * \brief Day of year (0 is January 1)
+   */
+  Day day;
+  /**
+   * \brief Hour of day (0 - 23)
+   */
+  int hour;
+};
+/**
+ * \brief Hourly weather for a scenario, in the order it was read
+ */
+struct ScenarioWeather
+{
+  /**
+   * \brief Scenario number
+   */
+  size_t id;
+  /**
+   * \brief Weather for each hour, stored contiguously so it can be pointed into
+   */
+  vector<FwiWeather> hours;
+  /**
+   * \brief Date and hour for each entry in hours
+   */
+  vector<WeatherTime> times;
+};
+/**
+ * \brief Read hourly weather for all scenarios from a .csv file
+ *
+ * Scenarios are parsed on multiple threads, so rows for each scenario need to be together
+ * in the file. Rows within a scenario need to be sequential hours.
+ * \param filename File to read
+ * \return Weather for each scenario, in the order they are in the file
+ */
+[[nodiscard]] vector<ScenarioWeather> read_weather_csv(const string& filename);
+/**
+ * \brief Whether file is in the binary weather format instead of .csv
+ * \param filename File to check
+ * \return Whether file is in the binary weather format
+ */
+[[nodiscard]] bool is_weather_binary(const string& filename);
+/**
+ * \brief Read hourly weather for all scenarios from a binary weather file
+ *
+ * Binary files have a header with the number of scenarios and hours and the start date,
+ * followed by a block of doubles for each of PREC, TEMP, RH, WS, WD, FFMC, DMC, DC, ISI,
+ * BUI, FWI. Every scenario covers the same hours.
+ * \param filename File to read
+ * \return Weather for each scenario, in the order they are in the file
+ */
+[[nodiscard]] vector<ScenarioWeather> read_weather_binary(const string& filename);
+/**
+ * \brief Read hourly weather for all scenarios from a binary or .csv file
+ * \param filename File to read
+ * \return Weather for each scenario, in the order they are in the file
+ */
+[[nodiscard]] vector<ScenarioWeather> read_weather(const string& filename);
+/**
+ * \brief Write hourly weather for all scenarios to a binary weather file
+ * \param filename File to write
+ * \param scenarios Weather to write, where every scenario covers the same hours
+ */
+void write_weather_binary(const string& filename, const vector<ScenarioWeather>& scenarios);
+}
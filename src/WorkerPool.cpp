@@ -0,0 +1,210 @@
+/* Copyright (c) His Majesty the King in Right of Canada as represented by the Minister of Natural Resources, 2024. */
+
+/* SPDX-License-Identifier: AGPL-3.0-or-later */
+
+#include "stdafx.h"
+#include "WorkerPool.h"
+#include "Log.h"
+namespace tbd::util
+{
+/**
+ * \brief Pool that the current thread is a worker for, if any
+ */
+static thread_local WorkerPool* CURRENT_POOL = nullptr;
+/**
+ * \brief Index of worker that the current thread is running for
+ */
+static thread_local size_t CURRENT_WORKER = 0;
+WorkerPool::WorkerPool(const size_t num_workers)
+{
+  const auto n = max(num_workers, static_cast<size_t>(1));
+  for (size_t i = 0; i < n; ++i)
+  {
+    workers_.push_back(make_unique<Worker>());
+  }
+  for (size_t i = 0; i < n; ++i)
+  {
+    threads_.emplace_back(&WorkerPool::work, this, i);
+  }
+  logging::debug("Started %ld worker threads", n);
+}
+WorkerPool::~WorkerPool()
+{
+  try
+  {
+    wait();
+    {
+      lock_guard<mutex> lock(mutex_);
+      stopping_ = true;
+    }
+    cv_work_.notify_all();
+    for (auto& t : threads_)
+    {
+      if (t.joinable())
+      {
+        t.join();
+      }
+    }
+  }
+  catch (const std::exception& ex)
+  {
+    logging::fatal(ex);
+    std::terminate();
+  }
+}
+void WorkerPool::submit(Task task)
+{
+  size_t index = CURRENT_WORKER;
+  {
+    lock_guard<mutex> lock(mutex_);
+    ++pending_;
+    ++queued_;
+    if (this != CURRENT_POOL)
+    {
+      index = next_;
+      next_ = (next_ + 1) % workers_.size();
+    }
+  }
+  {
+    auto& worker = *workers_[index];
+    lock_guard<mutex> lock(worker.mutex);
+    worker.tasks.push_back(std::move(task));
+  }
+  cv_work_.notify_one();
+}
+void WorkerPool::wait()
+{
+  std::unique_lock<mutex> lock(mutex_);
+  cv_done_.wait(lock, [this] { return 0 == pending_; });
+}
+WorkerPool* WorkerPool::current() noexcept
+{
+  return CURRENT_POOL;
+}
+void WorkerPool::for_each(const size_t n, const std::function<void(size_t)>& fct)
+{
+  /**
+   * \brief State shared with helper tasks, which can start after for_each() returns
+   */
+  struct Shared
+  {
+    /**
+     * \brief Next index that hasn't been claimed
+     */
+    std::atomic<size_t> next{0};
+    /**
+     * \brief Mutex for parallel access
+     */
+    std::mutex mutex{};
+    /**
+     * \brief Signals that a helper stopped working
+     */
+    std::condition_variable cv{};
+    /**
+     * \brief Number of helpers that are working
+     */
+    size_t active{0};
+    /**
+     * \brief Whether caller is done and helpers shouldn't start
+     */
+    bool is_finished{false};
+  };
+  const auto shared = make_shared<Shared>();
+  const auto run = [&fct, n](Shared& s) {
+    for (auto i = s.next++; i < n; i = s.next++)
+    {
+      fct(i);
+    }
+  };
+  const auto helpers = min(n, workers_.size()) - (0 == n ? 0 : 1);
+  for (size_t i = 0; i < helpers; ++i)
+  {
+    submit([shared, run]() {
+      {
+        lock_guard<mutex> lock(shared->mutex);
+        if (shared->is_finished)
+        {
+          return;
+        }
+        ++shared->active;
+      }
+      run(*shared);
+      {
+        lock_guard<mutex> lock(shared->mutex);
+        --shared->active;
+      }
+      shared->cv.notify_all();
+    });
+  }
+  run(*shared);
+  std::unique_lock<mutex> lock(shared->mutex);
+  shared->is_finished = true;
+  shared->cv.wait(lock, [&shared] { return 0 == shared->active; });
+}
+bool WorkerPool::pop(const size_t index, Task* task)
+{
+  auto& worker = *workers_[index];
+  lock_guard<mutex> lock(worker.mutex);
+  if (worker.tasks.empty())
+  {
+    return false;
+  }
+  *task = std::move(worker.tasks.back());
+  worker.tasks.pop_back();
+  return true;
+}
+bool WorkerPool::steal(const size_t index, Task* task)
+{
+  const auto n = workers_.size();
+  for (size_t i = 1; i < n; ++i)
+  {
+    auto& worker = *workers_[(index + i) % n];
+    lock_guard<mutex> lock(worker.mutex);
+    if (!worker.tasks.empty())
+    {
+      *task = std::move(worker.tasks.front());
+      worker.tasks.pop_front();
+      return true;
+    }
+  }
+  return false;
+}
+void WorkerPool::work(const size_t index)
+{
+  CURRENT_POOL = this;
+  CURRENT_WORKER = index;
+  Task task{};
+  while (true)
+  {
+    if (pop(index, &task) || steal(index, &task))
+    {
+      {
+        lock_guard<mutex> lock(mutex_);
+        --queued_;
+      }
+      task();
+      task = nullptr;
+      bool is_done;
+      {
+        lock_guard<mutex> lock(mutex_);
+        is_done = (0 == --pending_);
+      }
+      if (is_done)
+      {
+        cv_done_.notify_all();
+      }
+    }
+    else
+    {
+      std::unique_lock<mutex> lock(mutex_);
+      // queued_ can be positive while another worker is taking the task, so this
+      // might loop a few times but won't sleep while something is in a queue
+      cv_work_.wait(lock, [this] { return stopping_ || 0 < queued_; });
+      if (stopping_ && 0 == queued_)
+      {
+        return;
+      }
+    }
+  }
+}
+}
@@ -0,0 +1,145 @@
+/* Copyright (c) His Majesty the King in Right of Canada as represented by the Minister of Natural Resources, 2024. */
+
+/* SPDX-License-Identifier: AGPL-3.0-or-later */
+
+#pragma once
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+namespace tbd::util
+{
+/**
+ * \brief A fixed set of threads that run submitted tasks, where each thread has its own
+ * queue and takes work from the other queues when its own is empty.
+ */
+class WorkerPool
+{
+public:
+  /**
+   * \brief Function to run on a worker thread
+   */
+  using Task = std::function<void()>;
+  /**
+   * \brief Start the given number of worker threads
+   * \param num_workers Number of worker threads to start
+   */
+  explicit WorkerPool(size_t num_workers);
+  /**
+   * \brief Wait for all tasks to finish and then stop the worker threads
+   */
+  ~WorkerPool();
+  WorkerPool(const WorkerPool& rhs) = delete;
+  WorkerPool(WorkerPool&& rhs) = delete;
+  WorkerPool& operator=(const WorkerPool& rhs) = delete;
+  WorkerPool& operator=(WorkerPool&& rhs) = delete;
+  /**
+   * \brief Queue a task to run
+   *
+   * Tasks submitted from a worker go into that worker's own queue and are the next
+   * thing it runs, while tasks from other threads are spread across the workers.
+   * \param task Task to run
+   */
+  void submit(Task task);
+  /**
+   * \brief Block until there are no tasks queued or running
+   */
+  void wait();
+  /**
+   * \brief Call function for every index in [0, n) using this thread and any workers
+   * that are free, and return once every call is done
+   *
+   * Safe to call from a worker of this pool, since the calling thread does whatever
+   * work the other workers don't get to and only waits on calls that already started.
+   * \param n Number of indices
+   * \param fct Function to call with each index
+   */
+  void for_each(size_t n, const std::function<void(size_t)>& fct);
+  /**
+   * \brief Pool that the current thread is a worker for
+   * \return Pool that the current thread is a worker for, or nullptr if it isn't one
+   */
+  [[nodiscard]] static WorkerPool* current() noexcept;
+  /**
+   * \brief Number of worker threads
+   * \return Number of worker threads
+   */
+  [[nodiscard]] size_t size() const noexcept
+  {
+    return workers_.size();
+  }
+private:
+  /**
+   * \brief Queue of tasks for a single worker thread
+   */
+  struct Worker
+  {
+    /**
+     * \brief Mutex for parallel access
+     */
+    std::mutex mutex{};
+    /**
+     * \brief Tasks waiting to run
+     */
+    std::deque<Task> tasks{};
+  };
+  /**
+   * \brief Take the newest task from the given worker's own queue
+   * \param index Index of worker to take task for
+   * \param task Task that was taken
+   * \return Whether a task was taken
+   */
+  [[nodiscard]] bool pop(size_t index, Task* task);
+  /**
+   * \brief Take the oldest task from the queue of any other worker
+   * \param index Index of worker to take task for
+   * \param task Task that was taken
+   * \return Whether a task was taken
+   */
+  [[nodiscard]] bool steal(size_t index, Task* task);
+  /**
+   * \brief Run tasks until pool is stopped
+   * \param index Index of worker this thread is running for
+   */
+  void work(size_t index);
+  /**
+   * \brief Queue for each worker thread
+   */
+  std::vector<std::unique_ptr<Worker>> workers_{};
+  /**
+   * \brief Worker threads
+   */
+  std::vector<std::thread> threads_{};
+  /**
+   * \brief Mutex for counts and stopping
+   */
+  std::mutex mutex_{};
+  /**
+   * \brief Signals workers that there are tasks queued or the pool is stopping
+   */
+  std::condition_variable cv_work_{};
+  /**
+   * \brief Signals waiting threads that all tasks are done
+   */
+  std::condition_variable cv_done_{};
+  /**
+   * \brief Number of tasks that are in a queue
+   */
+  size_t queued_{0};
+  /**
+   * \brief Number of tasks that are queued or running
+   */
+  size_t pending_{0};
+  /**
+   * \brief Queue to put next task from a thread that isn't a worker into
+   */
+  size_t next_{0};
+  /**
+   * \brief Whether worker threads should exit
+   */
+  bool stopping_{false};
+};
+}